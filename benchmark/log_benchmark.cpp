@@ -0,0 +1,272 @@
+﻿/**
+ * @file log_benchmark.cpp
+ * @brief 日志模块的性能测试
+ * Licensed under the MIT licenses.
+ *
+ * @note 用法: atframe_utils_benchmark [每个线程的次数] [多线程测试的线程数]
+ * @note 每个用例先跑一轮只统计吞吐量，再跑一轮逐次计时统计延迟分位数，避免计时本身影响吞吐量
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/file_system.h"
+#include "lock/atomic_int_type.h"
+#include "log/log_async_pipeline.h"
+#include "log/log_background_worker.h"
+#include "log/log_formatter.h"
+#include "log/log_sink_file_backend.h"
+#include "log/log_wrapper.h"
+#include "std/chrono.h"
+#include "time/time_utility.h"
+
+namespace {
+    const uint32_t BENCH_LOG_CATEGORY = util::log::log_wrapper::categorize_t::DEFAULT;
+
+    const char *g_bench_prefix_formats[] = {
+        "",
+        "[%L]",
+        "[%Y-%m-%d %H:%M:%S.%f][%L]: ",
+        "[%Y-%m-%d %H:%M:%S.%f][%L](%s:%n %C): ",
+    };
+
+    struct bench_case_t;
+    typedef void (*bench_fn_t)(bench_case_t &bench, size_t index);
+
+    struct bench_case_t {
+        std::string name;
+        bench_fn_t fn;
+        util::log::log_formatter::compiled_t format;
+        util::log::log_formatter::caller_info_t caller;
+    };
+
+    struct bench_result_t {
+        double ops_per_sec;
+        uint64_t p50;
+        uint64_t p99;
+        uint64_t p999;
+        uint64_t max;
+    };
+
+    static util::lock::atomic_int_type<int> g_bench_start;
+
+    static inline uint64_t bench_now_ns() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static void bench_null_sink(const util::log::log_wrapper::caller_info_t &, const char *, size_t) {}
+
+    static void bench_fn_format(bench_case_t &bench, size_t index) {
+        char buffer[256];
+        bench.caller.line_number = static_cast<uint32_t>(index);
+        util::log::log_formatter::format(buffer, sizeof(buffer), bench.format, bench.caller);
+    }
+
+    static void bench_fn_log(bench_case_t &, size_t index) {
+        WCLOGINFO(BENCH_LOG_CATEGORY, "benchmark log %d, payload %s", static_cast<int>(index), "0123456789abcdef");
+    }
+
+    static void bench_worker(bench_case_t *bench, size_t iterations, std::vector<uint32_t> *latency) {
+        while (0 == g_bench_start.load(util::lock::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+
+        if (NULL == latency) {
+            for (size_t i = 0; i < iterations; ++i) {
+                bench->fn(*bench, i);
+            }
+            return;
+        }
+
+        latency->reserve(iterations);
+        for (size_t i = 0; i < iterations; ++i) {
+            uint64_t begin = bench_now_ns();
+            bench->fn(*bench, i);
+            uint64_t cost = bench_now_ns() - begin;
+            latency->push_back(cost > 0xFFFFFFFFULL ? 0xFFFFFFFFU : static_cast<uint32_t>(cost));
+        }
+    }
+
+    // 启动所有线程后再同时开始，返回总耗时(纳秒)
+    static uint64_t bench_run_threads(bench_case_t &bench, size_t threads, size_t iterations, std::vector<std::vector<uint32_t> > *latency) {
+        g_bench_start.store(0, util::lock::memory_order_release);
+
+        if (NULL != latency) {
+            latency->clear();
+            latency->resize(threads);
+        }
+
+        std::vector<std::thread *> workers;
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers.push_back(new std::thread(bench_worker, &bench, iterations, NULL == latency ? NULL : &(*latency)[i]));
+        }
+
+        uint64_t begin = bench_now_ns();
+        g_bench_start.store(1, util::lock::memory_order_release);
+        for (size_t i = 0; i < workers.size(); ++i) {
+            workers[i]->join();
+            delete workers[i];
+        }
+
+        return bench_now_ns() - begin;
+    }
+
+    static bench_result_t bench_run(bench_case_t &bench, size_t threads, size_t iterations) {
+        bench_result_t ret;
+        memset(&ret, 0, sizeof(ret));
+
+        // 预热，让线程缓冲区和文件都准备好
+        bench_run_threads(bench, 1, iterations / 10 + 1, NULL);
+
+        uint64_t cost = bench_run_threads(bench, threads, iterations, NULL);
+        ret.ops_per_sec = cost > 0 ? static_cast<double>(threads * iterations) * 1000000000.0 / static_cast<double>(cost) : 0.0;
+
+        std::vector<std::vector<uint32_t> > latency;
+        bench_run_threads(bench, threads, iterations, &latency);
+
+        std::vector<uint32_t> all;
+        all.reserve(threads * iterations);
+        for (size_t i = 0; i < latency.size(); ++i) {
+            all.insert(all.end(), latency[i].begin(), latency[i].end());
+        }
+
+        if (!all.empty()) {
+            std::sort(all.begin(), all.end());
+            ret.p50 = all[all.size() * 50 / 100];
+            ret.p99 = all[all.size() * 99 / 100];
+            ret.p999 = all[all.size() * 999 / 1000];
+            ret.max = all.back();
+        }
+
+        return ret;
+    }
+
+    static void bench_print_header() {
+        printf("%-72s %7s %14s %9s %9s %9s %11s\n", "case", "threads", "ops/s", "p50(ns)", "p99(ns)", "p999(ns)", "max(ns)");
+    }
+
+    static void bench_print(const bench_case_t &bench, size_t threads, const bench_result_t &res) {
+        printf("%-72s %7d %14.0f %9llu %9llu %9llu %11llu\n", bench.name.c_str(), static_cast<int>(threads), res.ops_per_sec,
+               static_cast<unsigned long long>(res.p50), static_cast<unsigned long long>(res.p99), static_cast<unsigned long long>(res.p999),
+               static_cast<unsigned long long>(res.max));
+        fflush(stdout);
+    }
+
+    static void bench_formatter(size_t iterations) {
+        for (size_t i = 0; i < sizeof(g_bench_prefix_formats) / sizeof(g_bench_prefix_formats[0]); ++i) {
+            bench_case_t bench;
+            bench.name = std::string("log_formatter::format \"") + g_bench_prefix_formats[i] + "\"";
+            bench.fn = bench_fn_format;
+            bench.format.compile(g_bench_prefix_formats[i]);
+            bench.caller = util::log::log_formatter::caller_info_t(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", __FILE__,
+                                                                   __LINE__, __FUNCTION__);
+            bench_print(bench, 1, bench_run(bench, 1, iterations));
+        }
+    }
+
+    static util::log::log_wrapper *bench_reset_logger(const char *prefix) {
+        util::log::log_wrapper *logger = WLOG_GETCAT(BENCH_LOG_CATEGORY);
+        logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+        logger->clear_sinks();
+        logger->set_prefix_format(prefix);
+        logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, false);
+        return logger;
+    }
+
+    static void bench_null_sink_log(size_t iterations, size_t threads) {
+        for (size_t i = 0; i < sizeof(g_bench_prefix_formats) / sizeof(g_bench_prefix_formats[0]); ++i) {
+            util::log::log_wrapper *logger = bench_reset_logger(g_bench_prefix_formats[i]);
+            logger->add_sink(bench_null_sink);
+
+            bench_case_t bench;
+            bench.name = std::string("log_wrapper::log null sink \"") + g_bench_prefix_formats[i] + "\"";
+            bench.fn = bench_fn_log;
+            bench_print(bench, 1, bench_run(bench, 1, iterations));
+            if (threads > 1) {
+                bench_print(bench, threads, bench_run(bench, threads, iterations));
+            }
+        }
+
+        // 异步写出时调用线程只负责格式化和入队
+        util::log::log_wrapper *logger = bench_reset_logger(g_bench_prefix_formats[2]);
+        logger->add_sink(bench_null_sink);
+        logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, true);
+        util::log::log_async_pipeline::instance().start();
+
+        bench_case_t bench;
+        bench.name = "log_wrapper::log async null sink";
+        bench.fn = bench_fn_log;
+        bench_print(bench, 1, bench_run(bench, 1, iterations));
+        if (threads > 1) {
+            bench_print(bench, threads, bench_run(bench, threads, iterations));
+        }
+
+        util::log::log_async_pipeline::instance().stop();
+        logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, false);
+    }
+
+    static void bench_file_sink_log(size_t iterations) {
+        const char *file_pattern = "atframe_utils_benchmark/bench.%N.log";
+        const bool auto_flush[] = {false, true};
+
+        for (size_t i = 0; i < sizeof(auto_flush) / sizeof(auto_flush[0]); ++i) {
+            util::log::log_wrapper *logger = bench_reset_logger(g_bench_prefix_formats[2]);
+
+            util::log::log_sink_file_backend backend(file_pattern);
+            backend.set_max_file_size(64 * 1024 * 1024).set_rotate_size(2).set_auto_flush(auto_flush[i]);
+            logger->add_sink(backend);
+
+            bench_case_t bench;
+            bench.name = auto_flush[i] ? "log_wrapper::log file sink auto flush" : "log_wrapper::log file sink buffered";
+            bench.fn = bench_fn_log;
+            bench_print(bench, 1, bench_run(bench, 1, iterations));
+
+            logger->clear_sinks();
+        }
+
+        // 等后台线程关闭文件后再删除
+        util::log::log_background_worker::flush();
+        util::file_system::remove("atframe_utils_benchmark/bench.0.log");
+        util::file_system::remove("atframe_utils_benchmark/bench.1.log");
+        util::file_system::remove("atframe_utils_benchmark");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t iterations = 100000;
+    size_t threads = 4;
+    if (argc > 1) {
+        iterations = static_cast<size_t>(strtoul(argv[1], NULL, 10));
+    }
+    if (argc > 2) {
+        threads = static_cast<size_t>(strtoul(argv[2], NULL, 10));
+    }
+    if (0 == iterations) {
+        iterations = 1;
+    }
+    if (0 == threads) {
+        threads = 1;
+    }
+
+    util::time::time_utility::update();
+
+    bench_print_header();
+    bench_formatter(iterations);
+    bench_null_sink_log(iterations, threads);
+    bench_file_sink_log(iterations);
+
+    util::log::log_wrapper::release_tls_buffer();
+    return 0;
+}
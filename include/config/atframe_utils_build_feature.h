@@ -0,0 +1,14 @@
+// cmake template file
+
+#ifndef _ATFRAME_UTIL_CONFIG_BUILD_FEATURE_H_
+#define _ATFRAME_UTIL_CONFIG_BUILD_FEATURE_H_
+
+# pragma once
+
+#define LOG_WRAPPER_DISABLE_LUA_SUPPORT 1
+/* #undef NETWORK_EVPOLL_ENABLE_LIBUV */
+#define NETWORK_ENABLE_CURL 1
+/* #undef ENABLE_MIXEDINT_MAGIC_MASK */
+#define LOG_SINK_ENABLE_ZLIB 1
+
+#endif
@@ -0,0 +1,156 @@
+﻿/**
+ * @file log_async_pipeline.h
+ * @brief 异步日志管线
+ * Licensed under the MIT licenses.
+ *
+ * @note 每个写日志的线程拥有自己的单生产者单消费者无锁环形缓冲区，由一个后台线程批量取出并写出到落地接口
+ * @note 同一线程内的日志顺序保持不变，不同线程之间不保证顺序
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_ASYNC_PIPELINE_H_
+#define _UTIL_LOG_LOG_ASYNC_PIPELINE_H_
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "design_pattern/noncopyable.h"
+#include "lock/seq_alloc.h"
+#include "lock/spin_lock.h"
+#include "std/smart_ptr.h"
+
+#include "log_formatter.h"
+
+#ifndef LOG_WRAPPER_ASYNC_RING_SIZE
+#define LOG_WRAPPER_ASYNC_RING_SIZE (1024 * 512)
+#endif
+
+namespace util {
+    namespace log {
+        class log_wrapper;
+
+        /**
+         * @brief 异步日志管线
+         * @note 需要先调用start()启动后台线程，并对日志分类设置log_wrapper::options_t::OPT_ASYNC_WRITE后才会生效
+         * @note 未启动时push会返回false，log_wrapper会回退到同步写出
+         */
+        class log_async_pipeline : public util::design_pattern::noncopyable {
+        public:
+            typedef log_formatter::caller_info_t caller_info_t;
+
+            struct ring_t;
+            typedef std::shared_ptr<ring_t> ring_ptr_t;
+
+        private:
+            log_async_pipeline();
+            ~log_async_pipeline();
+
+        public:
+            static log_async_pipeline &instance();
+
+            /**
+             * @brief 停止全局异步管线(如果已创建)，并写出所有未写出的日志
+             * @note 日志模块析构时会调用此接口，以保证后台线程不会访问已释放的落地接口
+             */
+            static void shutdown();
+
+            /**
+             * @brief 启动后台写出线程
+             * @return 成功返回0，已启动返回1，失败返回负数
+             */
+            int start();
+
+            /**
+             * @brief 停止后台写出线程，会先写出所有缓冲区内的日志
+             * @note 会等待正在推送的其他线程完成后再写出剩余日志，之后的推送都会返回false由调用方同步写出
+             */
+            void stop();
+
+            bool is_running() const;
+
+            /**
+             * @brief 等待当前所有已推送的日志被写出
+             */
+            void flush();
+
+            /**
+             * @brief 推送一条已格式化的日志
+             * @note 缓冲区满且设置了不等待时，日志会被丢弃并计数
+             * @return 已被管线接管(包括被丢弃)返回true，管线未启动返回false，此时调用方需要自己同步写出
+             */
+            bool push(log_wrapper *logger, const caller_info_t &caller, const char *content, size_t content_size);
+
+            /**
+             * @brief 推送一条二进制日志，由后台线程格式化后写出
+             * @param fmt 记录时使用的printf格式串，必须在写出前一直有效
+             * @param data log_binary_codec编码后的参数
+             * @param data_size 编码后的参数长度
+             * @see push
+             */
+            bool push_binary(log_wrapper *logger, const caller_info_t &caller, const char *fmt, const char *data, size_t data_size);
+
+            /**
+             * @brief 设置每个线程的环形缓冲区大小(只影响新创建的缓冲区，会向上取整到2的幂)
+             */
+            void set_ring_size(size_t sz);
+
+            inline size_t get_ring_size() const { return ring_size_; }
+
+            /**
+             * @brief 设置后台线程空闲时的最大等待时间(毫秒)
+             */
+            inline void set_flush_interval(time_t ms) { flush_interval_ms_ = ms > 0 ? ms : 1; }
+
+            inline time_t get_flush_interval() const { return flush_interval_ms_; }
+
+            /**
+             * @brief 缓冲区满时是否等待后台线程取出数据，不等待则丢弃这条日志
+             */
+            inline void set_block_on_full(bool v) { block_on_full_ = v; }
+
+            inline bool get_block_on_full() const { return block_on_full_; }
+
+            /**
+             * @brief 因缓冲区满而被丢弃的日志条数
+             */
+            inline uint64_t get_dropped_count() const { return dropped_count_.get(); }
+
+        private:
+            bool push_record(log_wrapper *logger, const caller_info_t &caller, const char *fmt, const char *content, size_t content_size);
+
+            ring_t *mutable_tls_ring();
+
+            size_t drain(ring_t &ring);
+
+            size_t drain_all();
+
+            void wakeup();
+
+            static void flusher_main(log_async_pipeline *self);
+
+        private:
+            struct flusher_t;
+            std::shared_ptr<flusher_t> flusher_;
+
+            size_t ring_size_;
+            time_t flush_interval_ms_;
+            bool block_on_full_;
+            util::lock::seq_alloc_u32 running_;
+            // 低位是正在push的生产者数量，最高位表示已停止，stop()需要等所有正在push的生产者退出后再做最后一次写出
+            util::lock::seq_alloc_u32 pushing_;
+            util::lock::seq_alloc_u64 dropped_count_;
+
+            lock::spin_lock rings_lock_;
+            std::vector<ring_ptr_t> rings_;
+        };
+    }
+}
+
+#endif
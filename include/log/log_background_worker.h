@@ -0,0 +1,86 @@
+﻿/**
+ * @file log_background_worker.h
+ * @brief 日志后台任务线程
+ * Licensed under the MIT licenses.
+ *
+ * @note 用于把文件轮转、创建目录、关闭文件等耗时的文件系统操作从写日志的线程中移走
+ * @note 后台线程在第一次投递任务时启动，所有日志后端共用一个线程
+ * @note 也可以添加定时任务，用于定期写出缓冲区之类不依赖下一条日志触发的工作
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_BACKGROUND_WORKER_H_
+#define _UTIL_LOG_LOG_BACKGROUND_WORKER_H_
+
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+#include <list>
+
+#include "design_pattern/noncopyable.h"
+#include "std/functional.h"
+#include "std/smart_ptr.h"
+
+namespace util {
+    namespace log {
+        class log_background_worker : public util::design_pattern::noncopyable {
+        public:
+            typedef std::function<void()> task_t;
+            typedef std::function<bool()> timer_task_t; // 返回false时移除定时任务
+
+        private:
+            log_background_worker();
+            ~log_background_worker();
+
+        public:
+            /**
+             * @brief 投递任务到全局后台线程
+             * @return 成功返回true，后台线程已停止或不可用时返回false，此时调用方需要自己执行任务
+             */
+            static bool post(const task_t &task);
+
+            /**
+             * @brief 添加定时任务，每隔interval_ms毫秒在后台线程中执行一次，直到任务返回false
+             * @note 定时任务不会被flush()等待，任务中引用的对象需要自己管理生命周期(比如使用weak_ptr)
+             * @return 成功返回true，后台线程已停止或不可用时返回false
+             */
+            static bool add_timer(const timer_task_t &task, time_t interval_ms);
+
+            /**
+             * @brief 等待当前所有已投递的任务执行完
+             */
+            static void flush();
+
+            /**
+             * @brief 停止全局后台线程(如果已创建)，会先执行完所有已投递的任务，停止后不能再投递任务
+             */
+            static void shutdown();
+
+        private:
+            static log_background_worker *instance();
+
+            bool post_task(const task_t &task);
+
+            bool add_timer_task(const timer_task_t &task, time_t interval_ms);
+
+            void start_thread();
+
+            void wait_idle();
+
+            void stop();
+
+            static void worker_main(log_background_worker *self);
+
+        private:
+            struct worker_t;
+            std::shared_ptr<worker_t> worker_;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,56 @@
+﻿/**
+ * @file log_binary_codec.h
+ * @brief 日志参数二进制编解码
+ * Licensed under the MIT licenses.
+ *
+ * @note 按printf格式串把可变参数原样保存成紧凑的二进制数据，在需要时再按同一个格式串还原成文本
+ * @note 字符串参数会被复制，其他参数按值保存，%n不会被执行
+ * @note 格式串本身不会被保存，解码时必须提供和编码时相同的格式串(通常是调用处的字符串常量)
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_BINARY_CODEC_H_
+#define _UTIL_LOG_LOG_BINARY_CODEC_H_
+
+#pragma once
+
+#include <cstddef>
+#include <cstdarg>
+#include <stdint.h>
+
+namespace util {
+    namespace log {
+        class log_binary_codec {
+        public:
+            /**
+             * @brief 按格式串编码参数
+             * @param buff 输出缓冲区
+             * @param bufz 输出缓冲区长度
+             * @param fmt printf格式串
+             * @param ap 参数列表
+             * @param truncated 不为NULL时输出是否因为缓冲区不足而被截断
+             * @note 缓冲区不足时会截断，解码时截断处之后的内容会被忽略
+             * @return 编码后的数据长度
+             */
+            static size_t encode(char *buff, size_t bufz, const char *fmt, va_list ap, bool *truncated = NULL);
+
+            /**
+             * @brief 按格式串把编码后的参数还原成文本
+             * @param buff 输出缓冲区
+             * @param bufz 输出缓冲区长度
+             * @param fmt 编码时使用的printf格式串
+             * @param data 编码后的数据
+             * @param datasz 编码后的数据长度
+             * @note 如果返回值大于0，本函数保证输出的数据结尾有'\0'，且返回的长度不计这个'\0'
+             * @return 输出的文本长度
+             */
+            static size_t decode(char *buff, size_t bufz, const char *fmt, const char *data, size_t datasz);
+        };
+    }
+}
+
+#endif
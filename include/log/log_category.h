@@ -0,0 +1,162 @@
+﻿/**
+ * @file log_category.h
+ * @brief 按名字注册的日志分类
+ * Licensed under the MIT licenses.
+ *
+ * @note 名字用'.'分隔层级，比如"net.http"的父分类是"net"，注册子分类时会自动注册所有父分类
+ * @note 没有单独设置级别的分类继承父分类的级别，都没有设置时使用绑定的log_wrapper分类的级别
+ * @note 没有单独绑定log_wrapper分类的分类继承父分类的绑定，根分类默认绑定categorize_t::DEFAULT
+ * @note 分类对象注册后不会释放，可以缓存指针，WNLOG*宏在每个调用处缓存查找结果
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_CATEGORY_H_
+#define _UTIL_LOG_LOG_CATEGORY_H_
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "design_pattern/noncopyable.h"
+#include "lock/atomic_int_type.h"
+
+#include "log_wrapper.h"
+
+namespace util {
+    namespace log {
+        class log_category : public util::design_pattern::noncopyable {
+        public:
+            /**
+             * @brief 获取分类，不存在时注册
+             * @param name 分类名，NULL或空字符串表示根分类
+             */
+            static log_category *get(const char *name);
+
+            /**
+             * @brief 查找分类，不存在时返回NULL
+             */
+            static log_category *find(const char *name);
+
+            static log_category &root();
+
+            inline const std::string &get_name() const { return name_; }
+
+            inline log_category *get_parent() const { return parent_; }
+
+            /**
+             * @brief 检查日志级别，只读取一次缓存的级别
+             */
+            inline bool check(log_wrapper::level_t::type level) const {
+                int effective_level = effective_level_.load(util::lock::memory_order_relaxed);
+                if (effective_level < 0) {
+                    return log_wrapper::check_level(effective_logger_.load(util::lock::memory_order_relaxed), level);
+                }
+
+                return effective_level >= static_cast<int>(level);
+            }
+
+            /**
+             * @brief 获取生效的日志级别
+             */
+            log_wrapper::level_t::type get_level() const;
+
+            /**
+             * @brief 设置级别，没有单独设置级别的子分类也会使用这个级别
+             */
+            void set_level(log_wrapper::level_t::type level);
+
+            /**
+             * @brief 取消单独设置的级别，重新继承父分类
+             */
+            void reset_level();
+
+            inline bool has_level() const { return level_ >= 0; }
+
+            /**
+             * @brief 绑定输出使用的log_wrapper分类，没有单独绑定的子分类也会使用这个分类
+             */
+            void set_logger(uint32_t cat);
+
+            /**
+             * @brief 取消单独绑定的log_wrapper分类，重新继承父分类
+             */
+            void reset_logger();
+
+            inline uint32_t get_logger_category() const { return effective_logger_.load(util::lock::memory_order_relaxed); }
+
+            inline log_wrapper *get_logger() const { return log_wrapper::mutable_log_cat(get_logger_category()); }
+
+        private:
+            log_category(const std::string &name, log_category *parent);
+
+            /**
+             * @brief 重新计算生效的级别和绑定的分类，并更新所有继承的子分类，调用前需要加锁
+             */
+            void refresh();
+
+        private:
+            std::string name_;
+            log_category *parent_;
+            std::vector<log_category *> children_;
+            int level_;      // 单独设置的级别，小于0表示继承
+            int64_t logger_; // 单独绑定的log_wrapper分类，小于0表示继承
+            util::lock::atomic_int_type<int> effective_level_;
+            util::lock::atomic_int_type<uint32_t> effective_logger_;
+
+            friend struct log_category_registry_t;
+        };
+    }
+}
+
+#define WLOG_NCAT(name) util::log::log_category::get(name)
+
+// 按名字分类日志输出工具，分类名必须是常量，第一次执行时查找并缓存在调用处
+#ifdef _MSC_VER
+
+#define WNLOGDEFLV(lv, lv_name, name, ...)                                                               \
+    if (static_cast<int>(lv) <= LOG_WRAPPER_COMPILE_MAX_LEVEL) {                                         \
+        static util::log::log_category *log_wrapper_named_cat = WLOG_NCAT(name);                         \
+        if (log_wrapper_named_cat->check(lv)) {                                                          \
+            util::log::log_wrapper *log_wrapper_named_logger = log_wrapper_named_cat->get_logger();      \
+            if (NULL != log_wrapper_named_logger) {                                                      \
+                log_wrapper_named_logger->log(WDTLOGFILENF(lv, lv_name), __VA_ARGS__);                   \
+            }                                                                                            \
+        }                                                                                                \
+    }
+
+#define WNLOGDEBUG(name, ...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", name, __VA_ARGS__)
+#define WNLOGNOTICE(name, ...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", name, __VA_ARGS__)
+#define WNLOGINFO(name, ...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", name, __VA_ARGS__)
+#define WNLOGWARNING(name, ...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", name, __VA_ARGS__)
+#define WNLOGERROR(name, ...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", name, __VA_ARGS__)
+#define WNLOGFATAL(name, ...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", name, __VA_ARGS__)
+
+#else
+
+#define WNLOGDEFLV(lv, lv_name, name, args...)                                                           \
+    if (static_cast<int>(lv) <= LOG_WRAPPER_COMPILE_MAX_LEVEL) {                                         \
+        static util::log::log_category *log_wrapper_named_cat = WLOG_NCAT(name);                         \
+        if (log_wrapper_named_cat->check(lv)) {                                                          \
+            util::log::log_wrapper *log_wrapper_named_logger = log_wrapper_named_cat->get_logger();      \
+            if (NULL != log_wrapper_named_logger) {                                                      \
+                log_wrapper_named_logger->log(WDTLOGFILENF(lv, lv_name), ##args);                        \
+            }                                                                                            \
+        }                                                                                                \
+    }
+
+#define WNLOGDEBUG(...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", __VA_ARGS__)
+#define WNLOGNOTICE(...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", __VA_ARGS__)
+#define WNLOGINFO(...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", __VA_ARGS__)
+#define WNLOGWARNING(...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", __VA_ARGS__)
+#define WNLOGERROR(...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", __VA_ARGS__)
+#define WNLOGFATAL(...) WNLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", __VA_ARGS__)
+
+#endif
+
+#endif
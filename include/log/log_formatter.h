@@ -1,106 +1,185 @@
-﻿/**
- * @file log_wrapper.h
- * @brief 日志包装器
- * Licensed under the MIT licenses.
- *
- * @version 1.0
- * @author owent
- * @date 2015-06-29
- * @history
- */
-
-#ifndef _UTIL_LOG_LOG_FORMATTER_H_
-#define _UTIL_LOG_LOG_FORMATTER_H_
-
-#pragma once
-
-#include <cstdlib>
-#include <cstdio>
-#include <stdint.h>
-#include <string>
-#include <inttypes.h>
-#include <ctime>
-#include <cstring>
-
-namespace util {
-    namespace log {
-        /**
-         * @brief 日志格式化数据
-         */
-        class log_formatter {
-        public:
-            struct flag_t {
-                enum type {
-                    INDEX = 0x01, // 日志rotation序号
-                    DATE = 0x02,  // 日期
-                    TIME = 0x04, // 时间
-                };
-            };
-
-            struct level_t {
-                enum type {
-                    LOG_LW_DISABLED = 0, // 关闭日志
-                    LOG_LW_FATAL,        // 强制输出
-                    LOG_LW_ERROR,        // 错误
-                    LOG_LW_WARNING,
-                    LOG_LW_INFO,
-                    LOG_LW_NOTICE,
-                    LOG_LW_DEBUG,
-                };
-            };
-
-            struct caller_info_t {
-                level_t::type level_id;
-                const char *level_name;
-                const char *file_path;
-                uint32_t line_number;
-                const char *func_name;
-                uint32_t rotate_index;
-
-                caller_info_t();
-                caller_info_t(level_t::type lid, const char *lname, const char *fpath, uint32_t lnum, const char *fnname);
-                caller_info_t(level_t::type lid, const char *lname, const char *fpath, uint32_t lnum, const char *fnname, uint32_t ridx);
-            };
-
-        public:
-            static bool check(int32_t flags, int32_t checked);
-
-            /**
-             * @brief 格式化到缓冲区，如果缓冲区不足忽略后面的数据
-             * @note 如果返回值大于0，本函数保证输出的数据结尾有'\0'，且返回的长度不计这个'\0'
-             * @return 返回消耗的缓存区长度
-             * @see http://en.cppreference.com/w/c/chrono/strftime
-             * @note 支持的格式规则
-             *            %Y:  	writes year as a 4 digit decimal number
-             *            %y:   writes last 2 digits of year as a decimal number (range [00,99])
-             *            %m:  	writes month as a decimal number (range [01,12])
-             *            %j:   writes day of the year as a decimal number (range [001,366])
-             *            %d:  	writes day of the month as a decimal number (range [01,31])
-             *            %w:  	writes weekday as a decimal number, where Sunday is 0 (range [0-6])
-             *            %H:   writes hour as a decimal number, 24 hour clock (range [00-23])
-             *            %I:  	writes hour as a decimal number, 12 hour clock (range [01,12])
-             *            %M:  	writes minute as a decimal number (range [00,59])
-             *            %S:  	writes second as a decimal number (range [00,60])
-             *            %F:  	equivalent to "%Y-%m-%d" (the ISO 8601 date format)
-             *            %T:  	equivalent to "%H:%M:%S" (the ISO 8601 time format)
-             *            %R:  	equivalent to "%H:%M"
-             *            %f:  	小于秒的时间标识 TODO: 目前为了速度是clock中的单位为毫秒的部分，但不是真正的毫秒数，以后改成真正的毫秒数
-             *            %L:  	日志级别名称
-             *            %l:  	日志级别ID
-             *            %s:  	调用处源码文件名
-             *            %n:  	调用处源码行号
-             *            %C:  	调用处函数名称
-             *            %N:   轮询序号(仅在内部接口有效)
-             */
-            static size_t format(char *buff, size_t bufz, const char *fmt, size_t fmtz, const caller_info_t &caller);
-
-            static bool check_rotation_var(const char *fmt, size_t fmtz);
-
-            static bool has_format(const char *fmt, size_t fmtz);
-        private:
-            static struct tm *get_iso_tm();
-        };
-    }
-}
-
-#endif
+﻿/**
+ * @file log_wrapper.h
+ * @brief 日志包装器
+ * Licensed under the MIT licenses.
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2015-06-29
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_FORMATTER_H_
+#define _UTIL_LOG_LOG_FORMATTER_H_
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <inttypes.h>
+#include <ctime>
+#include <cstring>
+
+namespace util {
+    namespace log {
+        /**
+         * @brief 日志格式化数据
+         */
+        class log_formatter {
+        public:
+            struct flag_t {
+                enum type {
+                    INDEX = 0x01, // 日志rotation序号
+                    DATE = 0x02,  // 日期
+                    TIME = 0x04, // 时间
+                };
+            };
+
+            struct level_t {
+                enum type {
+                    LOG_LW_DISABLED = 0, // 关闭日志
+                    LOG_LW_FATAL,        // 强制输出
+                    LOG_LW_ERROR,        // 错误
+                    LOG_LW_WARNING,
+                    LOG_LW_INFO,
+                    LOG_LW_NOTICE,
+                    LOG_LW_DEBUG,
+                };
+            };
+
+            struct caller_info_t {
+                level_t::type level_id;
+                const char *level_name;
+                const char *file_path;
+                uint32_t line_number;
+                const char *func_name;
+                uint32_t rotate_index;
+                time_t log_time;        // 日志产生的时间，为0时使用time_utility中缓存的时间
+                uint32_t log_time_nsec; // 日志产生时间的纳秒部分，仅log_time不为0时有效
+
+                caller_info_t();
+                caller_info_t(level_t::type lid, const char *lname, const char *fpath, uint32_t lnum, const char *fnname);
+                caller_info_t(level_t::type lid, const char *lname, const char *fpath, uint32_t lnum, const char *fnname, uint32_t ridx);
+            };
+
+            struct format_op_t {
+                enum type {
+                    FOP_LITERAL = 0, // 原样输出的文本
+                    FOP_YEAR,        // %Y
+                    FOP_YEAR2,       // %y
+                    FOP_MONTH,       // %m
+                    FOP_YDAY,        // %j
+                    FOP_MDAY,        // %d
+                    FOP_WDAY,        // %w
+                    FOP_HOUR,        // %H
+                    FOP_HOUR12,      // %I
+                    FOP_MINUTE,      // %M
+                    FOP_SECOND,      // %S
+                    FOP_DATE,        // %F
+                    FOP_TIME,        // %T
+                    FOP_HOUR_MINUTE, // %R
+                    FOP_MSEC,        // %f
+                    FOP_USEC,        // %u
+                    FOP_NSEC,        // %i
+                    FOP_LEVEL_NAME,  // %L
+                    FOP_LEVEL_ID,    // %l
+                    FOP_FILE_PATH,   // %s
+                    FOP_LINE_NUMBER, // %n
+                    FOP_FUNC_NAME,   // %C
+                    FOP_ROTATE_INDEX // %N
+                };
+            };
+
+            /**
+             * @brief 预编译的格式规则
+             * @note 设置时解析一次，格式化时不再逐字符解析，连续的文本直接memcpy
+             */
+            class compiled_t {
+            public:
+                compiled_t();
+                explicit compiled_t(const std::string &fmt);
+
+                void compile(const std::string &fmt);
+
+                inline const std::string &get_source() const { return source_; }
+
+                inline bool empty() const { return source_.empty(); }
+
+                inline bool has_rotation_var() const { return has_rotation_var_; }
+
+                inline bool has_time_var() const { return has_time_var_; }
+
+                // 是否使用了文件路径或行号(%s/%n)
+                inline bool has_source_var() const { return has_source_var_; }
+
+            private:
+                friend class log_formatter;
+
+                struct op_t {
+                    format_op_t::type op;
+                    size_t offset; // FOP_LITERAL时为literals_中的起始位置
+                    size_t length; // FOP_LITERAL时为文本长度
+                };
+
+                std::string source_;
+                std::string literals_;
+                std::vector<op_t> ops_;
+                bool has_rotation_var_;
+                bool has_time_var_;
+                bool has_source_var_;
+            };
+
+        public:
+            static bool check(int32_t flags, int32_t checked);
+
+            /**
+             * @brief 格式化到缓冲区，如果缓冲区不足忽略后面的数据
+             * @note 如果返回值大于0，本函数保证输出的数据结尾有'\0'，且返回的长度不计这个'\0'
+             * @note 时间相关的规则使用caller.log_time和caller.log_time_nsec，caller.log_time为0时使用time_utility缓存的时间(微秒精度)。
+             *       log_wrapper默认(OPT_CAPTURE_TIME)在写日志时用CLOCK_REALTIME_COARSE填充caller.log_time，%f/%u/%i的精度为时钟中断周期；
+             *       开启OPT_AUTO_UPDATE_TIME时使用CLOCK_REALTIME的精确时间；通过time_utility::update(t)指定时间后使用指定的时间
+             * @return 返回消耗的缓存区长度
+             * @see http://en.cppreference.com/w/c/chrono/strftime
+             * @note 支持的格式规则
+             *            %Y:  	writes year as a 4 digit decimal number
+             *            %y:   writes last 2 digits of year as a decimal number (range [00,99])
+             *            %m:  	writes month as a decimal number (range [01,12])
+             *            %j:   writes day of the year as a decimal number (range [001,366])
+             *            %d:  	writes day of the month as a decimal number (range [01,31])
+             *            %w:  	writes weekday as a decimal number, where Sunday is 0 (range [0-6])
+             *            %H:   writes hour as a decimal number, 24 hour clock (range [00-23])
+             *            %I:  	writes hour as a decimal number, 12 hour clock (range [01,12])
+             *            %M:  	writes minute as a decimal number (range [00,59])
+             *            %S:  	writes second as a decimal number (range [00,60])
+             *            %F:  	equivalent to "%Y-%m-%d" (the ISO 8601 date format)
+             *            %T:  	equivalent to "%H:%M:%S" (the ISO 8601 time format)
+             *            %R:  	equivalent to "%H:%M"
+             *            %f:  	毫秒部分(3位)
+             *            %u:  	微秒部分(6位)
+             *            %i:  	纳秒部分(9位)
+             *            %L:  	日志级别名称
+             *            %l:  	日志级别ID
+             *            %s:  	调用处源码文件名
+             *            %n:  	调用处源码行号
+             *            %C:  	调用处函数名称
+             *            %N:   轮询序号(仅在内部接口有效)
+             */
+            static size_t format(char *buff, size_t bufz, const char *fmt, size_t fmtz, const caller_info_t &caller);
+
+            /**
+             * @brief 使用预编译的格式规则格式化到缓冲区
+             * @see format
+             */
+            static size_t format(char *buff, size_t bufz, const compiled_t &fmt, const caller_info_t &caller);
+
+            static bool check_rotation_var(const char *fmt, size_t fmtz);
+
+            static bool has_format(const char *fmt, size_t fmtz);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,145 @@
+﻿/**
+ * @file log_kv_encoder.h
+ * @brief 结构化日志编码
+ * Licensed under the MIT licenses.
+ *
+ * @note 把带类型的键值对直接编码成一行JSON或logfmt，不产生中间的std::string
+ * @note 缓冲区不足时会丢弃放不下的字段，已写入的部分仍然是完整的一行
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_KV_ENCODER_H_
+#define _UTIL_LOG_LOG_KV_ENCODER_H_
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+
+#include "log_formatter.h"
+
+namespace util {
+    namespace log {
+        /**
+         * @brief 结构化日志字段
+         * @note 只保存字符串的地址，必须在日志写出前一直有效(通常直接在调用处构造)
+         */
+        struct log_kv_field_t {
+            struct value_type_t {
+                enum type {
+                    EN_KV_INT = 0,
+                    EN_KV_UINT,
+                    EN_KV_DOUBLE,
+                    EN_KV_BOOL,
+                    EN_KV_STRING,
+                };
+            };
+
+            const char *key;
+            value_type_t::type value_type;
+            union {
+                int64_t int_value;
+                uint64_t uint_value;
+                double double_value;
+                bool bool_value;
+                struct {
+                    const char *data;
+                    size_t size;
+                } string_value;
+            };
+
+            log_kv_field_t(const char *k, bool v) : key(k), value_type(value_type_t::EN_KV_BOOL) { bool_value = v; }
+            log_kv_field_t(const char *k, int v) : key(k), value_type(value_type_t::EN_KV_INT) { int_value = v; }
+            log_kv_field_t(const char *k, long v) : key(k), value_type(value_type_t::EN_KV_INT) { int_value = v; }
+            log_kv_field_t(const char *k, long long v) : key(k), value_type(value_type_t::EN_KV_INT) { int_value = v; }
+            log_kv_field_t(const char *k, unsigned int v) : key(k), value_type(value_type_t::EN_KV_UINT) { uint_value = v; }
+            log_kv_field_t(const char *k, unsigned long v) : key(k), value_type(value_type_t::EN_KV_UINT) { uint_value = v; }
+            log_kv_field_t(const char *k, unsigned long long v) : key(k), value_type(value_type_t::EN_KV_UINT) { uint_value = v; }
+            log_kv_field_t(const char *k, double v) : key(k), value_type(value_type_t::EN_KV_DOUBLE) { double_value = v; }
+            log_kv_field_t(const char *k, const char *v) : key(k), value_type(value_type_t::EN_KV_STRING) {
+                string_value.data = v;
+                string_value.size = (NULL == v) ? 0 : strlen(v);
+            }
+            log_kv_field_t(const char *k, const char *v, size_t sz) : key(k), value_type(value_type_t::EN_KV_STRING) {
+                string_value.data = v;
+                string_value.size = sz;
+            }
+            log_kv_field_t(const char *k, const std::string &v) : key(k), value_type(value_type_t::EN_KV_STRING) {
+                string_value.data = v.c_str();
+                string_value.size = v.size();
+            }
+        };
+
+        /**
+         * @brief 结构化日志编码器，直接写入调用方提供的缓冲区
+         */
+        class log_kv_encoder {
+        public:
+            struct format_t {
+                enum type {
+                    EN_KV_FMT_JSON = 0, // {"key":"value","num":1}
+                    EN_KV_FMT_LOGFMT,   // key=value num=1
+                };
+            };
+
+        public:
+            /**
+             * @brief 构造编码器
+             * @param buff 输出缓冲区
+             * @param bufz 输出缓冲区长度
+             * @param fmt 输出格式
+             */
+            log_kv_encoder(char *buff, size_t bufz, format_t::type fmt);
+
+            /**
+             * @brief 写入调用处信息，包括时间、级别、文件、行号和函数名
+             * @note caller.log_time为0时使用time_utility缓存的时间
+             */
+            log_kv_encoder &add_caller(const log_formatter::caller_info_t &caller);
+
+            log_kv_encoder &add(const log_kv_field_t &field);
+
+            /**
+             * @brief 结束编码
+             * @note 本函数保证输出的数据结尾有'\0'，且返回的长度不计这个'\0'
+             * @return 输出的数据长度
+             */
+            size_t finish();
+
+            inline bool is_truncated() const { return truncated_; }
+
+            /**
+             * @brief 快速整数转字符串
+             * @param buff 输出缓冲区，至少需要21字节
+             * @return 输出的长度，不会在结尾写入'\0'
+             */
+            static size_t write_int(char *buff, int64_t v);
+            static size_t write_uint(char *buff, uint64_t v);
+
+        private:
+            bool begin_field(const char *key);
+            void end_field(bool success);
+
+            bool write_raw(const char *data, size_t sz);
+            bool write_char(char c);
+            bool write_string(const char *data, size_t sz, bool is_key);
+
+        private:
+            char *buff_;
+            size_t bufz_;
+            size_t used_;
+            size_t field_start_; // 当前字段的起始位置，放不下时回退到这里
+            size_t field_count_;
+            format_t::type fmt_;
+            bool truncated_;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,71 @@
+﻿/**
+ * @file log_rate_limiter.h
+ * @brief 日志限频和采样
+ * Licensed under the MIT licenses.
+ *
+ * @note 用于WCLOGRATE*和WCLOGSAMPLE*宏，每个调用处持有一个静态对象
+ * @note 未被限制时只有几次原子操作，被限制的日志不会格式化
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_RATE_LIMITER_H_
+#define _UTIL_LOG_LOG_RATE_LIMITER_H_
+
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+#include <stdint.h>
+
+#include "design_pattern/noncopyable.h"
+#include "lock/atomic_int_type.h"
+
+namespace util {
+    namespace log {
+        /**
+         * @brief 按秒限频，每秒最多放行max_per_second条日志
+         * @note 窗口切换时的计数不是严格精确的，多线程下允许少量误差
+         */
+        class log_rate_limiter : public util::design_pattern::noncopyable {
+        public:
+            explicit log_rate_limiter(uint32_t max_per_second);
+
+            /**
+             * @brief 检查是否放行
+             * @param suppressed 放行时输出之前被丢弃的日志条数(并清零)，未放行时不修改
+             * @return 放行返回true
+             */
+            bool check(uint32_t &suppressed);
+
+            inline uint32_t get_max_per_second() const { return max_per_second_; }
+
+        private:
+            uint32_t max_per_second_;
+            util::lock::atomic_int_type<time_t> window_;
+            util::lock::atomic_int_type<uint32_t> count_;
+            util::lock::atomic_int_type<uint32_t> suppressed_;
+        };
+
+        /**
+         * @brief 采样，每every_n条日志放行一条(第一条总是放行)
+         */
+        class log_sampler : public util::design_pattern::noncopyable {
+        public:
+            explicit log_sampler(uint32_t every_n);
+
+            bool check();
+
+            inline uint32_t get_every_n() const { return every_n_; }
+
+        private:
+            uint32_t every_n_;
+            util::lock::atomic_int_type<uint32_t> count_;
+        };
+    }
+}
+
+#endif
@@ -1,113 +1,232 @@
-﻿/**
- * @file log_sink_file_backend.h
- * @brief 日志文件后端
- * Licensed under the MIT licenses.
- *
- * @version 1.0
- * @author owent
- * @date 2016-03-31
- * @history
- */
-
-#ifndef _UTIL_LOG_LOG_SINK_FILE_BACKEND_H_
-#define _UTIL_LOG_LOG_SINK_FILE_BACKEND_H_
-
-#pragma once
-
-#include <cstdlib>
-#include <cstdio>
-#include <stdint.h>
-#include <string>
-#include <vector>
-#include <fstream>
-#include "std/smart_ptr.h"
-#include "lock/spin_lock.h"
-
-#include "log_formatter.h"
-
-namespace util {
-    namespace log {
-        /**
-         * @brief 文件日志后端
-         */
-        class log_sink_file_backend {
-        public:
-            log_sink_file_backend();
-            log_sink_file_backend(const std::string &file_name_pattern);
-            log_sink_file_backend(const log_sink_file_backend& other);
-            ~log_sink_file_backend();
-
-        public:
-            void set_file_pattern(const std::string &file_name_pattern);
-
-            void operator()(const log_formatter::caller_info_t &caller, const char *content, size_t content_size);
-
-            inline time_t get_check_interval() const { return check_interval_; }
-
-            inline log_sink_file_backend &set_check_interval(time_t check_interval) {
-                check_interval_ = check_interval;
-                return *this;
-            }
-
-            inline bool get_auto_flush() const { return log_file_.auto_flush; }
-
-            inline log_sink_file_backend &set_auto_flush(bool enable_buffer) {
-                log_file_.auto_flush = enable_buffer;
-                return *this;
-            }
-
-            inline size_t get_max_file_size() const { return max_file_size_; }
-
-            inline log_sink_file_backend &set_max_file_size(size_t max_file_size) {
-                max_file_size_ = max_file_size;
-                return *this;
-            }
-
-            inline uint32_t get_rotate_size() const { return rotation_size_; }
-
-            inline log_sink_file_backend &set_rotate_size(uint32_t sz) {
-                // 轮训sz不能为0
-                if (sz <= 1) {
-                    sz = 1;
-                }
-                rotation_size_ = sz;
-                return *this;
-            }
-
-        private:
-            void init();
-
-            std::shared_ptr<std::ofstream> open_log_file(bool destroy_content);
-
-            void rotate_log();
-
-            void check_update();
-
-            void reset_log_file();
-        private:
-            // 第一个first表示是否需要format
-            std::string path_pattern_;
-
-            uint32_t rotation_size_;  // 轮询滚动size
-            size_t max_file_size_;  // log文件size限制
-
-
-            time_t check_interval_; // 更换文件或目录的检查周期
-            time_t check_expire_point_; // 更换文件或目录的检查周期
-            bool inited_;
-            lock::spin_lock fs_lock_;
-
-            
-            struct file_impl_t {
-                bool auto_flush; // 是否每次追加内容后，自动刷写缓冲区到实际文件
-                uint32_t rotation_index;
-                size_t written_size;
-                std::shared_ptr<std::ofstream> opened_file;
-                std::string file_path;
-            };
-            file_impl_t log_file_;
-        };
-    }
-}
-
-#endif
+﻿/**
+ * @file log_sink_file_backend.h
+ * @brief 日志文件后端
+ * Licensed under the MIT licenses.
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2016-03-31
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_SINK_FILE_BACKEND_H_
+#define _UTIL_LOG_LOG_SINK_FILE_BACKEND_H_
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "std/smart_ptr.h"
+#include "lock/atomic_int_type.h"
+#include "lock/spin_lock.h"
+
+#include "log_formatter.h"
+
+#ifndef LOG_SINK_FILE_BACKEND_BUFFER_SIZE
+#define LOG_SINK_FILE_BACKEND_BUFFER_SIZE (1024 * 1024)
+#endif
+
+namespace util {
+    namespace log {
+        /**
+         * @brief 文件日志后端
+         */
+        class log_sink_file_backend {
+        public:
+            struct file_writer_t;
+            typedef std::shared_ptr<file_writer_t> file_writer_ptr_t;
+            struct prepared_file_t;
+
+        public:
+            log_sink_file_backend();
+            log_sink_file_backend(const std::string &file_name_pattern);
+            log_sink_file_backend(const log_sink_file_backend& other);
+            ~log_sink_file_backend();
+
+        public:
+            void set_file_pattern(const std::string &file_name_pattern);
+
+            void operator()(const log_formatter::caller_info_t &caller, const char *content, size_t content_size);
+
+            inline time_t get_check_interval() const { return check_interval_; }
+
+            inline log_sink_file_backend &set_check_interval(time_t check_interval) {
+                check_interval_ = check_interval;
+                return *this;
+            }
+
+            inline bool get_auto_flush() const { return log_file_.auto_flush; }
+
+            inline log_sink_file_backend &set_auto_flush(bool enable_buffer) {
+                log_file_.auto_flush = enable_buffer;
+                return *this;
+            }
+
+            /**
+             * @brief 设置写缓冲区大小，只影响之后打开的文件，为0时每行日志直接写出
+             * @note 缓冲区满、达到刷写周期、切换文件、调用flush()或析构时写出
+             */
+            inline log_sink_file_backend &set_buffer_size(size_t sz) {
+                buffer_size_ = sz;
+                return *this;
+            }
+
+            inline size_t get_buffer_size() const { return buffer_size_; }
+
+            /**
+             * @brief 设置缓冲区内数据的最大停留时间(毫秒)，为0时不检查
+             * @note 写入日志时检查，另外后台线程按这个周期定时写出，没有新日志时缓冲区中的数据也不会一直停留
+             */
+            inline log_sink_file_backend &set_flush_interval(time_t ms) {
+                flush_interval_ = ms;
+                return *this;
+            }
+
+            inline time_t get_flush_interval() const { return flush_interval_; }
+
+            /**
+             * @brief 把缓冲区内的数据写出到文件
+             */
+            void flush();
+
+            inline size_t get_max_file_size() const { return max_file_size_; }
+
+            inline log_sink_file_backend &set_max_file_size(size_t max_file_size) {
+                max_file_size_ = max_file_size;
+                return *this;
+            }
+
+            inline uint32_t get_rotate_size() const { return rotation_size_; }
+
+            inline log_sink_file_backend &set_rotate_size(uint32_t sz) {
+                // 轮训sz不能为0
+                if (sz <= 1) {
+                    sz = 1;
+                }
+                rotation_size_ = sz;
+                return *this;
+            }
+
+            /**
+             * @brief 设置是否压缩轮转后的旧文件
+             * @note 按大小轮转到下一个文件时，旧文件会被改名后在后台线程中压缩成同名的.gz文件，然后删除原文件
+             * @note 编译时没有zlib时设置无效
+             */
+            inline log_sink_file_backend &set_compress(bool enable) {
+                compress_ = enable && is_compress_supported();
+                return *this;
+            }
+
+            inline bool get_compress() const { return compress_; }
+
+            static bool is_compress_supported();
+
+            /**
+             * @brief 设置多进程共享模式，多个进程可以使用相同的文件路径规则写同一组文件
+             * @note 每行日志(或整个写缓冲区)用一次O_APPEND的write写出，在本地文件系统上不会和其他进程的日志交错
+             * @note 轮转通过文件路径规则第0个文件旁的.lock文件协调，lock文件中记录当前的轮转序号，只有一个进程执行轮转
+             * @note 共享模式下按文件的实际大小轮转，不压缩旧文件(其他进程可能还在写)，不支持的平台上设置无效
+             */
+            inline log_sink_file_backend &set_shared(bool enable) {
+                shared_ = enable && is_shared_supported();
+                return *this;
+            }
+
+            inline bool get_shared() const { return shared_; }
+
+            static bool is_shared_supported();
+
+        private:
+            void init();
+
+            file_writer_ptr_t open_log_file(bool destroy_content);
+
+            void rotate_log();
+
+            /**
+             * @brief 共享模式下在文件锁内轮转，其他进程已经轮转过时直接切换到新的序号
+             */
+            void rotate_shared_log();
+
+            /**
+             * @brief 打开共享模式的lock文件，路径变化时重新打开
+             * @return lock文件的文件描述符，失败返回-1
+             */
+            int open_shared_lock();
+
+            void close_shared_lock();
+
+            /**
+             * @brief 共享模式下从lock文件同步轮转序号，lock文件中还没有记录时写入当前的序号
+             */
+            void sync_shared_index();
+
+            /**
+             * @brief 把当前文件改名，最后一个引用释放、文件关闭后在后台线程中压缩
+             */
+            void compress_current_file();
+
+            /**
+             * @brief 当前文件写过3/4后，在后台线程中预先打开下一个轮转文件，切换文件时只需要替换指针
+             * @see prepare_file
+             */
+            void prepare_next_file();
+
+            /**
+             * @brief 在后台线程中预先打开文件，之后打开这个路径时直接使用
+             * @note 非共享模式下在后台线程中创建目录，并创建同名的.preparing临时文件，切换时改名替换原文件，
+             *       切换前原来的历史文件保持不变，也不会提前出现空文件
+             * @note 共享模式下其他进程可能正在写这个文件，只预先打开已经存在的文件
+             */
+            void prepare_file(const char *file_path, size_t file_path_len);
+
+            /**
+             * @brief 丢弃预先打开但没有使用的文件，临时文件在后台线程中删除
+             */
+            void discard_prepared_file();
+
+            /**
+             * @brief 轮转后的文件就是当前文件时(比如只有一个文件)，直接清空当前文件
+             * @return 不是同一个文件或清空失败时返回false
+             */
+            bool truncate_same_file();
+
+            void check_update();
+
+            void reset_log_file();
+        private:
+            log_formatter::compiled_t path_pattern_; // 预编译的文件路径规则
+
+            uint32_t rotation_size_;  // 轮询滚动size
+            size_t max_file_size_;  // log文件size限制
+
+
+            time_t check_interval_; // 更换文件或目录的检查周期
+            time_t check_expire_point_; // 更换文件或目录的检查周期
+            size_t buffer_size_;        // 写缓冲区大小
+            time_t flush_interval_;     // 缓冲区数据最大停留时间(毫秒)
+            bool compress_;             // 是否压缩轮转后的旧文件
+            bool shared_;               // 是否多进程共享文件
+            bool inited_;
+            int shared_lock_fd_;             // 共享模式的lock文件
+            std::string shared_lock_path_;
+            lock::spin_lock fs_lock_;
+
+            
+            struct file_impl_t {
+                bool auto_flush; // 是否每次追加内容后，自动刷写缓冲区到实际文件
+                uint32_t rotation_index;
+                util::lock::atomic_int_type<size_t> written_size; // 同步写出时可能有多个线程同时写
+                file_writer_ptr_t opened_file;
+                std::string file_path;
+            };
+            file_impl_t log_file_;
+            std::shared_ptr<prepared_file_t> prepared_file_;
+        };
+    }
+}
+
+#endif
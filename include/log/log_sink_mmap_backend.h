@@ -0,0 +1,126 @@
+﻿/**
+ * @file log_sink_mmap_backend.h
+ * @brief 内存映射日志文件后端
+ * Licensed under the MIT licenses.
+ *
+ * @note 预先分配固定大小的文件并映射到内存，写日志只需要一次原子加法和一次内存复制，不需要系统调用
+ * @note 脏页由内核管理，进程崩溃或被SIGKILL后已写入的日志仍然会落地(系统掉电除外)
+ * @note 文件未写满的部分为'\0'，重新打开已有文件时会从尾部向前查找写入位置
+ * @note 只按文件大小轮转，路径规则中的日期等变量在打开文件时求值
+ * @note 当前文件通过原子指针发布，写入时不加锁；写过3/4后在log_background_worker中创建并映射下一个文件的.preparing临时文件，
+ *       切换时改名替换原文件并替换指针，旧文件在最后一个写入者离开后由后台线程解除映射
+ * @note 切换前原来的历史文件保持不变，进程在切换前退出也不会丢失；没有用到的临时文件(比如后端析构时)会被删除
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_SINK_MMAP_BACKEND_H_
+#define _UTIL_LOG_LOG_SINK_MMAP_BACKEND_H_
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+#include "std/smart_ptr.h"
+
+#include "log_formatter.h"
+
+#ifndef LOG_SINK_MMAP_BACKEND_FILE_SIZE
+#define LOG_SINK_MMAP_BACKEND_FILE_SIZE (16 * 1024 * 1024)
+#endif
+
+namespace util {
+    namespace log {
+        /**
+         * @brief 内存映射日志文件后端
+         * @note 可以被多个线程同时调用
+         */
+        class log_sink_mmap_backend {
+        public:
+            struct mapping_t;
+            typedef std::shared_ptr<mapping_t> mapping_ptr_t;
+            struct mapping_set_t;
+            typedef std::shared_ptr<mapping_set_t> mapping_set_ptr_t;
+
+        public:
+            log_sink_mmap_backend();
+            log_sink_mmap_backend(const std::string &file_name_pattern);
+            log_sink_mmap_backend(const log_sink_mmap_backend &other);
+            ~log_sink_mmap_backend();
+
+        public:
+            void set_file_pattern(const std::string &file_name_pattern);
+
+            void operator()(const log_formatter::caller_info_t &caller, const char *content, size_t content_size);
+
+            /**
+             * @brief 请求内核异步回写已映射的数据，进程崩溃时不需要调用，只用于防止系统掉电丢失
+             */
+            void flush();
+
+            inline size_t get_file_size() const { return file_size_; }
+
+            /**
+             * @brief 设置每个文件预分配的大小，只影响之后打开的文件
+             */
+            inline log_sink_mmap_backend &set_file_size(size_t sz) {
+                // 至少要能放下一行日志
+                if (sz < 4096) {
+                    sz = 4096;
+                }
+                file_size_ = sz;
+                return *this;
+            }
+
+            inline uint32_t get_rotate_size() const { return rotation_size_; }
+
+            inline log_sink_mmap_backend &set_rotate_size(uint32_t sz) {
+                // 轮训sz不能为0
+                if (sz <= 1) {
+                    sz = 1;
+                }
+                rotation_size_ = sz;
+                return *this;
+            }
+
+        private:
+            void init();
+
+            size_t format_file_path(char *buff, size_t bufz, uint32_t rotation_index) const;
+
+            uint32_t get_next_rotation_index(uint32_t rotation_index) const;
+
+            /**
+             * @brief 标记并返回当前映射，没有打开时返回NULL，用完后需要调用release_mapping
+             */
+            mapping_t *pin_mapping();
+
+            static void release_mapping(mapping_t *mapping);
+
+            /**
+             * @brief 同pin_mapping，没有打开时先打开当前文件，失败时返回NULL
+             */
+            mapping_t *acquire_mapping();
+
+            bool open_current_mapping();
+
+            void rotate_mapping(mapping_t *full_mapping, uint32_t generation);
+
+            void prepare_next_mapping(mapping_t *mapping);
+
+        private:
+            log_formatter::compiled_t path_pattern_; // 预编译的文件路径规则
+            uint32_t rotation_size_;                 // 轮询滚动size
+            size_t file_size_;                       // 预分配的文件大小
+
+            mapping_set_ptr_t mappings_;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,133 @@
+﻿/**
+ * @file log_sink_socket_backend.h
+ * @brief 日志数据报套接字后端
+ * Licensed under the MIT licenses.
+ *
+ * @note 把日志发送到本机的日志收集程序，支持Unix域数据报套接字和UDP，每行日志是一个数据报
+ * @note 日志先积攒在缓冲区中，Linux下用sendmmsg一次发送多个数据报，发送缓冲区满或接收方不存在时直接丢弃，不会阻塞
+ * @note 复制出的对象共享同一个套接字和缓冲区，添加到log_wrapper后仍然可以用原来的对象flush()
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_SINK_SOCKET_BACKEND_H_
+#define _UTIL_LOG_LOG_SINK_SOCKET_BACKEND_H_
+
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+#include <stdint.h>
+#include <string>
+
+#include "std/smart_ptr.h"
+
+#include "log_formatter.h"
+
+#ifndef LOG_SINK_SOCKET_BACKEND_BUFFER_SIZE
+#define LOG_SINK_SOCKET_BACKEND_BUFFER_SIZE (64 * 1024)
+#endif
+
+namespace util {
+    namespace log {
+        /**
+         * @brief 数据报套接字日志后端
+         */
+        class log_sink_socket_backend {
+        public:
+            struct socket_impl_t;
+            typedef std::shared_ptr<socket_impl_t> socket_impl_ptr_t;
+
+        public:
+            log_sink_socket_backend();
+            log_sink_socket_backend(const std::string &address);
+            log_sink_socket_backend(const log_sink_socket_backend &other);
+            ~log_sink_socket_backend();
+
+        public:
+            /**
+             * @brief 设置目标地址
+             * @param address unix:<path> 表示Unix域数据报套接字，udp:<host>:<port> 表示UDP(IPv6地址使用udp:[<host>]:<port>)
+             * @return 地址格式错误、解析失败或创建套接字失败时返回false，之后的日志都会被丢弃
+             */
+            bool set_address(const std::string &address);
+
+            const std::string &get_address() const;
+
+            void operator()(const log_formatter::caller_info_t &caller, const char *content, size_t content_size);
+
+            /**
+             * @brief 发送缓冲区内所有的日志
+             */
+            void flush();
+
+            inline size_t get_batch_size() const { return batch_size_; }
+
+            /**
+             * @brief 设置积攒多少行日志后发送一次，为1时每行日志直接发送
+             */
+            log_sink_socket_backend &set_batch_size(size_t sz);
+
+            /**
+             * @brief 设置缓冲区内日志的最大停留时间(毫秒)，为0时只按batch_size发送
+             * @note 写入日志时检查，另外第一次缓存日志时会在log_background_worker中添加定时任务，没有新日志时也会发送
+             * @note 定时任务的间隔在添加时确定，之后修改只影响写入日志时的检查
+             */
+            inline log_sink_socket_backend &set_flush_interval(time_t ms) {
+                flush_interval_ = ms;
+                return *this;
+            }
+
+            inline time_t get_flush_interval() const { return flush_interval_; }
+
+            inline size_t get_max_datagram_size() const { return max_datagram_size_; }
+
+            /**
+             * @brief 设置单个数据报的最大长度，更长的日志会被截断
+             */
+            inline log_sink_socket_backend &set_max_datagram_size(size_t sz) {
+                if (sz > LOG_SINK_SOCKET_BACKEND_BUFFER_SIZE) {
+                    sz = LOG_SINK_SOCKET_BACKEND_BUFFER_SIZE;
+                }
+                max_datagram_size_ = sz;
+                return *this;
+            }
+
+            /**
+             * @brief 设置syslog的facility，设置后每个数据报前会加上"<PRI>"，小于0时不添加
+             * @note 日志级别按FATAL->LOG_CRIT, ERROR->LOG_ERR, WARNING->LOG_WARNING, INFO->LOG_INFO, DEBUG->LOG_DEBUG转换
+             *       本模块的NOTICE低于INFO，也转换为LOG_INFO
+             */
+            inline log_sink_socket_backend &set_syslog_facility(int32_t facility) {
+                syslog_facility_ = facility;
+                return *this;
+            }
+
+            inline int32_t get_syslog_facility() const { return syslog_facility_; }
+
+            /**
+             * @brief 获取已发送的日志行数
+             */
+            uint64_t get_sent_count() const;
+
+            /**
+             * @brief 获取因为发送缓冲区满、接收方不存在或没有设置地址而丢弃的日志行数
+             */
+            uint64_t get_dropped_count() const;
+
+            static bool is_supported();
+
+        private:
+            size_t batch_size_;
+            time_t flush_interval_;
+            size_t max_datagram_size_;
+            int32_t syslog_facility_;
+            socket_impl_ptr_t impl_;
+        };
+    }
+}
+
+#endif
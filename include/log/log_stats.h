@@ -0,0 +1,164 @@
+﻿/**
+ * @file log_stats.h
+ * @brief 日志模块自身的统计
+ * Licensed under the MIT licenses.
+ *
+ * @note 每个线程只写自己的计数器，读取时汇总所有线程，写入时没有原子加法和锁
+ * @note 行数、字节数和丢弃数总是统计，耗时需要对分类开启log_wrapper::options_t::OPT_STATS_LATENCY
+ * @note 每个落地接口的行数、字节数和耗时另外保存在落地接口上，按add_sink返回的id查询。
+ *       同一个落地接口会被多个线程调用，这部分计数使用原子加法
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_STATS_H_
+#define _UTIL_LOG_LOG_STATS_H_
+
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "lock/atomic_int_type.h"
+
+#include "log_wrapper.h"
+
+namespace util {
+    namespace log {
+        class log_stats {
+        public:
+            enum {
+                LEVEL_COUNT = log_wrapper::level_t::LOG_LW_DEBUG + 1,
+                // 落地接口耗时分桶，第i个桶统计耗时小于(1 << (i + LATENCY_BUCKET_SHIFT))纳秒的调用，最后一个桶不设上限
+                LATENCY_BUCKET_SHIFT = 8,
+                LATENCY_BUCKET_COUNT = 20,
+            };
+
+            struct counter_t {
+                enum type {
+                    EN_LSC_LINES = 0,                                          // 写出到落地接口的行数，按级别分开统计
+                    EN_LSC_BYTES = EN_LSC_LINES + LEVEL_COUNT,                 // 写出到落地接口的字节数，每个落地接口分别计算
+                    EN_LSC_DROPPED,                                            // 异步管线满时丢弃的行数
+                    EN_LSC_FORMAT_COUNT,                                       // 统计了格式化耗时的次数
+                    EN_LSC_FORMAT_NS,                                          // 格式化总耗时(纳秒)
+                    EN_LSC_SINK_CALLS,                                         // 统计了耗时的落地接口调用次数
+                    EN_LSC_SINK_NS,                                            // 落地接口总耗时(纳秒)
+                    EN_LSC_SINK_LATENCY,                                       // 落地接口耗时分布
+                    EN_LSC_MAX = EN_LSC_SINK_LATENCY + LATENCY_BUCKET_COUNT,
+                };
+            };
+
+            struct category_t {
+                uint64_t counters[counter_t::EN_LSC_MAX];
+
+                inline uint64_t get_lines(log_wrapper::level_t::type level) const {
+                    if (level < 0 || static_cast<int>(level) >= static_cast<int>(LEVEL_COUNT)) {
+                        return 0;
+                    }
+                    return counters[counter_t::EN_LSC_LINES + level];
+                }
+
+                uint64_t get_total_lines() const;
+
+                inline uint64_t get_bytes() const { return counters[counter_t::EN_LSC_BYTES]; }
+                inline uint64_t get_dropped() const { return counters[counter_t::EN_LSC_DROPPED]; }
+                inline uint64_t get_format_count() const { return counters[counter_t::EN_LSC_FORMAT_COUNT]; }
+                inline uint64_t get_format_ns() const { return counters[counter_t::EN_LSC_FORMAT_NS]; }
+                inline uint64_t get_sink_calls() const { return counters[counter_t::EN_LSC_SINK_CALLS]; }
+                inline uint64_t get_sink_ns() const { return counters[counter_t::EN_LSC_SINK_NS]; }
+
+                inline uint64_t get_sink_latency(size_t bucket) const {
+                    return bucket < LATENCY_BUCKET_COUNT ? counters[counter_t::EN_LSC_SINK_LATENCY + bucket] : 0;
+                }
+            };
+
+            struct snapshot_t {
+                category_t categories[log_wrapper::categorize_t::MAX];
+            };
+
+            struct sink_counter_t {
+                enum type {
+                    EN_LSSC_LINES = 0,   // 写出到这个落地接口的行数
+                    EN_LSSC_BYTES,       // 写出到这个落地接口的字节数
+                    EN_LSSC_CALLS,       // 统计了耗时的调用次数
+                    EN_LSSC_NS,          // 总耗时(纳秒)
+                    EN_LSSC_LATENCY,     // 耗时分布
+                    EN_LSSC_MAX = EN_LSSC_LATENCY + LATENCY_BUCKET_COUNT,
+                };
+            };
+
+            struct sink_t {
+                uint64_t counters[sink_counter_t::EN_LSSC_MAX];
+
+                inline uint64_t get_lines() const { return counters[sink_counter_t::EN_LSSC_LINES]; }
+                inline uint64_t get_bytes() const { return counters[sink_counter_t::EN_LSSC_BYTES]; }
+                inline uint64_t get_calls() const { return counters[sink_counter_t::EN_LSSC_CALLS]; }
+                inline uint64_t get_ns() const { return counters[sink_counter_t::EN_LSSC_NS]; }
+
+                inline uint64_t get_latency(size_t bucket) const {
+                    return bucket < LATENCY_BUCKET_COUNT ? counters[sink_counter_t::EN_LSSC_LATENCY + bucket] : 0;
+                }
+            };
+
+        public:
+            /**
+             * @brief 汇总所有线程的统计数据
+             * @note 只保证每个计数器自身的值是某个时刻的值，不同计数器之间不是同一时刻的快照
+             */
+            static void snapshot(snapshot_t &out);
+
+            /**
+             * @brief 把当前的统计数据作为基准，之后的snapshot只返回基准之后的增量
+             */
+            static void reset();
+
+            /**
+             * @brief 获取一个落地接口的统计数据
+             * @param sink_id log_wrapper::add_sink返回的id
+             * @note 从添加落地接口开始计算，不受reset()影响，移除落地接口后数据一起释放
+             * @return 没有找到这个落地接口时返回false
+             */
+            static bool get_sink_stats(const log_wrapper &logger, uint32_t sink_id, sink_t &out);
+
+            /**
+             * @brief 获取耗时分桶的上限(纳秒)，最后一个桶返回0表示不设上限
+             */
+            static uint64_t get_latency_bucket_bound(size_t bucket);
+
+            static size_t get_latency_bucket(uint64_t ns);
+
+            /**
+             * @brief 获取用于统计耗时的单调时钟(纳秒)
+             */
+            static uint64_t now_ns();
+
+        public:
+            // 以下接口由log_wrapper和log_async_pipeline调用
+            static void add(uint32_t cat, counter_t::type counter, uint64_t value);
+
+            static void add_line(uint32_t cat, log_wrapper::level_t::type level, uint64_t bytes);
+
+            static void add_format_latency(uint32_t cat, uint64_t ns);
+
+            static void add_sink_latency(uint32_t cat, uint64_t ns);
+
+            static void add_sink_line(const log_wrapper::log_router_t &router, uint64_t bytes);
+
+            static void add_sink_latency(const log_wrapper::log_router_t &router, uint64_t ns);
+        };
+
+        /**
+         * @brief 单个落地接口的计数器，由log_wrapper::add_sink创建
+         */
+        struct log_sink_stats_t {
+            util::lock::atomic_int_type<uint64_t> counters[log_stats::sink_counter_t::EN_LSSC_MAX];
+
+            log_sink_stats_t();
+        };
+    }
+}
+
+#endif
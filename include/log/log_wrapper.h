@@ -1,240 +1,569 @@
-﻿/**
- * @file log_wrapper.h
- * @brief 日志包装器
- * Licensed under the MIT licenses.
- *
- * @version 1.0
- * @author owent
- * @date 2015-06-29
- * @history
- */
-
-#ifndef _UTIL_LOG_LOG_WRAPPER_H_
-#define _UTIL_LOG_LOG_WRAPPER_H_
-
-#pragma once
-
-#include "std/functional.h"
-#include "std/smart_ptr.h"
-#include <bitset>
-#include <list>
-
-
-#include "cli/shell_font.h"
-
-#include "log_formatter.h"
-
-#ifndef LOG_WRAPPER_MAX_SIZE_PER_LINE
-#define LOG_WRAPPER_MAX_SIZE_PER_LINE (1024 * 1024 * 2)
-#endif
-
-#ifndef LOG_WRAPPER_CATEGORIZE_SIZE
-#define LOG_WRAPPER_CATEGORIZE_SIZE 32
-#endif
-
-namespace util {
-    namespace log {
-        class log_wrapper {
-        public:
-            struct categorize_t {
-                enum type {
-                    DEFAULT = 0, // 服务框架
-                    MAX = LOG_WRAPPER_CATEGORIZE_SIZE
-                };
-            };
-
-            struct options_t {
-                enum type {
-                    OPT_AUTO_UPDATE_TIME = 0, // 是否自动更新时间（会降低性能）
-                    OPT_MAX
-                };
-            };
-
-        public:
-            typedef log_formatter::level_t level_t;
-            typedef log_formatter::caller_info_t caller_info_t;
-
-            typedef std::function<void(const caller_info_t &caller, const char *content, size_t content_size)> log_handler_t;
-            typedef struct {
-                level_t::type level_min;
-                level_t::type level_max;
-                log_handler_t handle;
-            } log_router_t;
-
-        protected:
-            log_wrapper();
-            virtual ~log_wrapper();
-
-        public:
-            // 初始化
-            int32_t init(level_t::type level = level_t::LOG_LW_DEBUG);
-
-            static void update();
-
-            void log(const caller_info_t &caller,
-#ifdef _MSC_VER
-                     _In_z_ _Printf_format_string_ const char *fmt, ...);
-#elif (defined(__clang__) && __clang_major__ >= 3) || (defined(__GNUC__) && __GNUC__ >= 4)
-// 格式检查(成员函数有个隐含的this参数)
-#if defined(__MINGW32__) || defined(__MINGW64__)
-                     const char *fmt, ...) __attribute__((format(__MINGW_PRINTF_FORMAT, 3, 4)));
-#else
-                     const char *fmt, ...) __attribute__((format(printf, 3, 4)));
-#endif
-#else
-                     const char *fmt, ...);
-#endif
-
-            // 一般日志级别检查
-            inline bool check(level_t::type level) const { return log_level_ >= level; }
-
-            static inline bool check(const log_wrapper *logger, level_t::type level) {
-                if (NULL == logger) {
-                    return false;
-                }
-                return logger->log_level_ >= level;
-            }
-
-            inline const std::list<log_router_t> &get_sinks() const { return log_sinks_; }
-
-            /**
-             * @brief 添加落地接口
-             */
-            void add_sink(log_handler_t h, level_t::type level_min = level_t::LOG_LW_FATAL,
-                          level_t::type level_max = level_t::LOG_LW_DEBUG);
-
-            inline void set_level(level_t::type l) { log_level_ = l; }
-
-            inline level_t::type get_level() const { return log_level_; }
-
-            inline const std::string &set_prefix_format() const { return prefix_format_; }
-
-            inline void set_prefix_format(const std::string &prefix) { prefix_format_ = prefix; }
-
-            inline bool get_option(options_t::type t) const {
-                if (t < options_t::OPT_MAX) {
-                    return false;
-                }
-
-                return options_.test(t);
-            };
-
-            inline void set_option(options_t::type t, bool v) {
-                if (t < options_t::OPT_MAX) {
-                    return;
-                }
-
-                options_.set(t, v);
-            };
-
-            /**
-             * @brief 实际写出到落地接口
-             */
-            void write_log(const caller_info_t &caller, const char *content, size_t content_size);
-
-            // TODO 白名单及用户指定日志输出以后有需要再说
-
-            static log_wrapper *mutable_log_cat(uint32_t cats = categorize_t::DEFAULT);
-
-        private:
-            level_t::type log_level_;
-            std::list<log_router_t> log_sinks_;
-            std::string prefix_format_;
-            std::bitset<options_t::OPT_MAX> options_;
-
-            static bool destroyed_; // log模块进入释放阶段，进入释放阶段后log功能会被关闭
-        };
-    }
-}
-
-#define WLOG_LEVELID(lv) static_cast<util::log::log_wrapper::level_t::type>(lv)
-
-#define WDTLOGGETCAT(cat) util::log::log_wrapper::mutable_log_cat(cat)
-#define WDTLOGFILENF(lv, name) util::log::log_wrapper::caller_info_t(lv, name, __FILE__, __LINE__, __FUNCTION__)
-
-#define WLOG_INIT(cat, lv) NULL != WDTLOGGETCAT(cat) ? WDTLOGGETCAT(cat)->init(lv) : -1
-
-#define WLOG_GETCAT(cat) util::log::log_wrapper::mutable_log_cat(cat)
-
-// 按分类日志输出工具
-#ifdef _MSC_VER
-
-#define WCLOGDEFLV(lv, lv_name, cat, ...) \
-    if (util::log::log_wrapper::check(WDTLOGGETCAT(cat), lv)) WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), __VA_ARGS__);
-
-#define WCLOGDEBUG(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", cat, __VA_ARGS__)
-#define WCLOGNOTICE(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", cat, __VA_ARGS__)
-#define WCLOGINFO(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", cat, __VA_ARGS__)
-#define WCLOGWARNING(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", cat, __VA_ARGS__)
-#define WCLOGERROR(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", cat, __VA_ARGS__)
-#define WCLOGFATAL(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", cat, __VA_ARGS__)
-
-#else
-
-#define WCLOGDEFLV(lv, lv_name, cat, args...) \
-    if (util::log::log_wrapper::check(WDTLOGGETCAT(cat), lv)) WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), ##args);
-
-#define WCLOGDEBUG(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", __VA_ARGS__)
-#define WCLOGNOTICE(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", __VA_ARGS__)
-#define WCLOGINFO(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", __VA_ARGS__)
-#define WCLOGWARNING(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", __VA_ARGS__)
-#define WCLOGERROR(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", __VA_ARGS__)
-#define WCLOGFATAL(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", __VA_ARGS__)
-
-#endif
-
-// 默认日志输出工具
-#define WLOGDEBUG(...) WCLOGDEBUG(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
-#define WLOGNOTICE(...) WCLOGNOTICE(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
-#define WLOGINFO(...) WCLOGINFO(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
-#define WLOGWARNING(...) WCLOGWARNING(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
-#define WLOGERROR(...) WCLOGERROR(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
-#define WLOGFATAL(...) WCLOGFATAL(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
-
-
-// 控制台输出工具
-#ifdef _MSC_VER
-#define PSTDTERMCOLOR(code, fmt, ...)                                              \
-    \
-{                                                                           \
-        util::cli::shell_stream::shell_stream_opr log_wrapper_pstd_ss(&std::cout); \
-        log_wrapper_pstd_ss.open(code);                                            \
-        log_wrapper_pstd_ss.close();                                               \
-        printf(fmt, __VA_ARGS__);                                                  \
-    \
-}
-
-#else
-#define PSTDTERMCOLOR(code, fmt, args...)                                          \
-    \
-{                                                                           \
-        util::cli::shell_stream::shell_stream_opr log_wrapper_pstd_ss(&std::cout); \
-        log_wrapper_pstd_ss.open(code);                                            \
-        log_wrapper_pstd_ss.close();                                               \
-        printf(fmt, ##args);                                                       \
-    \
-}
-
-#endif
-
-#define PSTDINFO(...) printf(__VA_ARGS__)
-#define PSTDNOTICE(...) PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_COLOR_YELLOW, __VA_ARGS__)
-#define PSTDWARNING(...) \
-    PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_SPEC_BOLD | util::cli::shell_font_style::SHELL_FONT_COLOR_YELLOW, __VA_ARGS__)
-#define PSTDERROR(...) \
-    PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_SPEC_BOLD | util::cli::shell_font_style::SHELL_FONT_COLOR_RED, __VA_ARGS__)
-#define PSTDFATAL(...) PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_COLOR_MAGENTA, __VA_ARGS__)
-#define PSTDOK(...) PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_COLOR_GREEN, __VA_ARGS__)
-//
-#ifndef NDEBUG
-#define PSTDDEBUG(...) PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_COLOR_CYAN, __VA_ARGS__)
-#define PSTDMARK                                                                                                         \
-    PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_SPEC_BOLD | util::cli::shell_font_style::SHELL_FONT_COLOR_RED, \
-                  "Mark: %s:%s (function %s)\n", __FILE__, __LINE__, __FUNCTION__)
-#else
-#define PSTDDEBUG(...)
-#define PSTDMARK
-
-#endif
-
-#endif // _UTIL_LOG_LOG_WRAPPER_H_
+﻿/**
+ * @file log_wrapper.h
+ * @brief 日志包装器
+ * Licensed under the MIT licenses.
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2015-06-29
+ * @history
+ */
+
+#ifndef _UTIL_LOG_LOG_WRAPPER_H_
+#define _UTIL_LOG_LOG_WRAPPER_H_
+
+#pragma once
+
+#include "std/functional.h"
+#include "std/smart_ptr.h"
+#include <bitset>
+#include <vector>
+
+#include "lock/atomic_int_type.h"
+#include "lock/spin_lock.h"
+
+
+#include "cli/shell_font.h"
+
+#include "log_formatter.h"
+#include "log_kv_encoder.h"
+#include "log_rate_limiter.h"
+
+#ifndef LOG_WRAPPER_MAX_SIZE_PER_LINE
+#define LOG_WRAPPER_MAX_SIZE_PER_LINE (1024 * 1024 * 2)
+#endif
+
+// 线程缓冲区的初始大小，单条日志超过时按2倍增长，最大到LOG_WRAPPER_MAX_SIZE_PER_LINE
+#ifndef LOG_WRAPPER_TLS_BUFFER_INIT_SIZE
+#define LOG_WRAPPER_TLS_BUFFER_INIT_SIZE 4096
+#endif
+
+#ifndef LOG_WRAPPER_CATEGORIZE_SIZE
+#define LOG_WRAPPER_CATEGORIZE_SIZE 32
+#endif
+
+/**
+ * @brief 编译期保留的最大日志级别，级别id大于这个值的WCLOG*和WLOG*调用会在编译期被移除
+ * @note 取值和level_t一致，0为关闭所有日志，6(LOG_LW_DEBUG)为全部保留
+ */
+#ifndef LOG_WRAPPER_COMPILE_MAX_LEVEL
+#define LOG_WRAPPER_COMPILE_MAX_LEVEL 6
+#endif
+
+namespace util {
+    namespace log {
+        struct log_sink_stats_t;
+
+        class log_wrapper {
+        public:
+            struct categorize_t {
+                enum type {
+                    DEFAULT = 0, // 服务框架
+                    MAX = LOG_WRAPPER_CATEGORIZE_SIZE
+                };
+            };
+
+            struct options_t {
+                enum type {
+                    OPT_AUTO_UPDATE_TIME = 0, // 是否在写日志时读取系统的精确时间(CLOCK_REALTIME)，默认关闭
+                    OPT_ASYNC_WRITE,          // 是否通过log_async_pipeline异步写出（管线未启动时仍然同步写出）
+                    OPT_STATS_LATENCY,        // 是否在log_stats中统计格式化和落地接口的耗时（每次需要额外读取时钟）
+                    OPT_CAPTURE_TIME,         // 是否在写日志时读取系统的粗略时间(CLOCK_REALTIME_COARSE)，默认开启，time_utility::update(t)指定时间时仍使用指定的时间
+                    OPT_MAX
+                };
+            };
+
+        public:
+            typedef log_formatter::level_t level_t;
+            typedef log_formatter::caller_info_t caller_info_t;
+
+            typedef std::function<void(const caller_info_t &caller, const char *content, size_t content_size)> log_handler_t;
+            typedef struct {
+                uint32_t sink_id; // add_sink返回的id，用于移除落地接口
+                level_t::type level_min;
+                level_t::type level_max;
+                log_handler_t handle;
+                std::shared_ptr<log_sink_stats_t> stats; // 这个落地接口的统计数据，见log_stats::get_sink_stats
+            } log_router_t;
+            typedef std::shared_ptr<log_router_t> log_router_ptr_t;
+
+            /**
+             * @brief 落地接口表，创建后不再修改，修改落地接口时整体复制后替换(copy-on-write)
+             * @note 写日志的线程持有旧表的引用时可以继续安全地使用旧表
+             */
+            struct sink_table_t {
+                std::vector<log_router_ptr_t> routers;                        // 按添加顺序排列的所有落地接口
+                std::vector<const log_router_t *> levels[level_t::LOG_LW_DEBUG + 1]; // 按日志级别分组的落地接口
+            };
+            typedef std::shared_ptr<const sink_table_t> sink_table_ptr_t;
+
+        protected:
+            log_wrapper();
+            virtual ~log_wrapper();
+
+        public:
+            // 初始化
+            int32_t init(level_t::type level = level_t::LOG_LW_DEBUG);
+
+            static void update();
+
+            void log(const caller_info_t &caller,
+#ifdef _MSC_VER
+                     _In_z_ _Printf_format_string_ const char *fmt, ...);
+#elif (defined(__clang__) && __clang_major__ >= 3) || (defined(__GNUC__) && __GNUC__ >= 4)
+// 格式检查(成员函数有个隐含的this参数)
+#if defined(__MINGW32__) || defined(__MINGW64__)
+                     const char *fmt, ...) __attribute__((format(__MINGW_PRINTF_FORMAT, 3, 4)));
+#else
+                     const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+#endif
+#else
+                     const char *fmt, ...);
+#endif
+
+            /**
+             * @brief 以二进制方式记录日志，只保存参数的原始数据，格式化推迟到写出时进行
+             * @param caller 调用处信息，必须在日志写出前一直有效(WCLOGBIN*宏中使用调用处的静态变量)
+             * @param fmt printf格式串，必须在日志写出前一直有效(通常是字符串常量)
+             * @note 开启OPT_ASYNC_WRITE且异步管线已启动时，格式化会在后台线程中进行，否则立即格式化并写出
+             * @note 由于格式串只保存了地址，记录的数据不能脱离当前进程解码
+             */
+            void log_binary(const caller_info_t *caller,
+#ifdef _MSC_VER
+                            _In_z_ _Printf_format_string_ const char *fmt, ...);
+#elif (defined(__clang__) && __clang_major__ >= 3) || (defined(__GNUC__) && __GNUC__ >= 4)
+#if defined(__MINGW32__) || defined(__MINGW64__)
+                            const char *fmt, ...) __attribute__((format(__MINGW_PRINTF_FORMAT, 3, 4)));
+#else
+                            const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+#endif
+#else
+                            const char *fmt, ...);
+#endif
+
+            /**
+             * @brief 记录结构化日志，按set_kv_format设置的格式编码成一行，不使用前缀格式
+             * @param caller 调用处信息，会作为time、level、file、line和func字段写在最前面
+             * @param fields 字段数组
+             * @param field_count 字段数量
+             */
+            void log_kv(const caller_info_t &caller, const log_kv_field_t *fields, size_t field_count);
+
+            /**
+             * @brief 把多段文本直接拼接成一行日志，不经过printf格式化
+             * @param caller 调用处信息
+             * @param segments 文本段数组，为NULL的段会被跳过
+             * @param segment_sizes 每段文本的长度
+             * @param segment_count 文本段数量
+             * @note 用于脚本绑定等参数已经是字符串的场景，整行只格式化一次前缀
+             */
+            void log_segments(const caller_info_t &caller, const char *const *segments, const size_t *segment_sizes, size_t segment_count);
+
+            inline void set_kv_format(log_kv_encoder::format_t::type fmt) { kv_format_ = fmt; }
+
+            inline log_kv_encoder::format_t::type get_kv_format() const { return kv_format_; }
+
+            // 一般日志级别检查
+            inline bool check(level_t::type level) const { return log_level_ >= level; }
+
+            static inline bool check(const log_wrapper *logger, level_t::type level) {
+                if (NULL == logger) {
+                    return false;
+                }
+                return logger->log_level_ >= level;
+            }
+
+            /**
+             * @brief 按分类检查日志级别，只读取一次缓存的级别，不需要先获取log_wrapper对象
+             * @note 分类未初始化或log模块已释放时返回false
+             */
+            static inline bool check_level(uint32_t cat, level_t::type level) {
+                if (cat >= categorize_t::MAX) {
+                    return false;
+                }
+
+                return category_levels_[cat].load(util::lock::memory_order_relaxed) >= static_cast<int>(level);
+            }
+
+            /**
+             * @brief 获取当前落地接口表的快照
+             */
+            sink_table_ptr_t get_sinks() const;
+
+            inline size_t get_sink_size() const { return sink_size_.load(util::lock::memory_order_acquire); }
+
+            /**
+             * @brief 添加落地接口，可以在其他线程写日志时调用
+             * @return 落地接口的id，用于remove_sink，添加失败返回0
+             */
+            uint32_t add_sink(log_handler_t h, level_t::type level_min = level_t::LOG_LW_FATAL,
+                              level_t::type level_max = level_t::LOG_LW_DEBUG);
+
+            /**
+             * @brief 移除落地接口，可以在其他线程写日志时调用
+             * @note 移除后正在写出的日志可能仍然会调用到这个落地接口
+             * @return 找到并移除返回true
+             */
+            bool remove_sink(uint32_t sink_id);
+
+            /**
+             * @brief 移除所有落地接口
+             */
+            void clear_sinks();
+
+            inline void set_level(level_t::type l) {
+                log_level_ = l;
+                sync_level_cache();
+            }
+
+            inline level_t::type get_level() const { return log_level_; }
+
+            /**
+             * @brief 获取分类id，不是通过mutable_log_cat获取的对象返回categorize_t::MAX
+             */
+            inline uint32_t get_category() const { return category_; }
+
+            inline const std::string &set_prefix_format() const { return prefix_format_.get_source(); }
+
+            inline void set_prefix_format(const std::string &prefix) { prefix_format_.compile(prefix); }
+
+            inline const log_formatter::compiled_t &get_compiled_prefix_format() const { return prefix_format_; }
+
+            inline bool get_option(options_t::type t) const {
+                if (t >= options_t::OPT_MAX) {
+                    return false;
+                }
+
+                return options_.test(t);
+            };
+
+            inline void set_option(options_t::type t, bool v) {
+                if (t >= options_t::OPT_MAX) {
+                    return;
+                }
+
+                options_.set(t, v);
+            };
+
+            /**
+             * @brief 写出日志，开启异步写出时会转交给log_async_pipeline
+             */
+            void write_log(const caller_info_t &caller, const char *content, size_t content_size);
+
+            /**
+             * @brief 实际写出到落地接口
+             */
+            void write_sinks(const caller_info_t &caller, const char *content, size_t content_size);
+
+            /**
+             * @brief 格式化二进制日志并写出到落地接口
+             * @param caller 调用处信息
+             * @param fmt 记录时使用的printf格式串
+             * @param data log_binary_codec编码后的参数
+             * @param data_size 编码后的参数长度
+             */
+            void write_binary(const caller_info_t &caller, const char *fmt, const char *data, size_t data_size);
+
+            // TODO 白名单及用户指定日志输出以后有需要再说
+
+            static log_wrapper *mutable_log_cat(uint32_t cats = categorize_t::DEFAULT);
+
+            /**
+             * @brief 释放当前线程的日志缓冲区，之后再写日志时会重新分配
+             * @note POSIX系统下线程退出时会自动释放，Windows下需要在线程退出前手动调用
+             */
+            static void release_tls_buffer();
+
+        private:
+            /**
+             * @brief 记录日志产生的时间
+             * @note 开启OPT_AUTO_UPDATE_TIME时读取系统的精确时间；否则开启OPT_CAPTURE_TIME且time_utility没有被指定时间时读取系统的粗略时间；
+             *       其他情况使用time_utility缓存的时间
+             */
+            void stamp_time(caller_info_t &caller) const;
+
+            /**
+             * @brief 替换落地接口表
+             */
+            void reset_sinks(const std::vector<log_router_ptr_t> &routers);
+
+            /**
+             * @brief 把日志级别同步到按分类缓存的级别中
+             */
+            void sync_level_cache();
+
+            static bool setup_categories(log_wrapper *all_logger);
+
+        private:
+            level_t::type log_level_;
+            uint32_t category_;
+            mutable lock::spin_lock sink_lock_; // 只保护sinks_指针本身的读取和替换
+            lock::spin_lock sink_modify_lock_;  // 修改落地接口表的操作之间互斥
+            sink_table_ptr_t sinks_;
+            util::lock::atomic_int_type<size_t> sink_size_;
+            uint32_t sink_id_alloc_;
+            log_formatter::compiled_t prefix_format_;
+            log_kv_encoder::format_t::type kv_format_;
+            std::bitset<options_t::OPT_MAX> options_;
+
+            static bool destroyed_; // log模块进入释放阶段，进入释放阶段后log功能会被关闭
+            static util::lock::atomic_int_type<int> category_levels_[categorize_t::MAX]; // 按分类缓存的日志级别
+        };
+    }
+}
+
+#define WLOG_LEVELID(lv) static_cast<util::log::log_wrapper::level_t::type>(lv)
+
+#define WDTLOGGETCAT(cat) util::log::log_wrapper::mutable_log_cat(cat)
+// 先在编译期按级别裁剪，再检查缓存的分类级别
+#define WDTLOGCHECK(cat, lv) \
+    (static_cast<int>(lv) <= LOG_WRAPPER_COMPILE_MAX_LEVEL && util::log::log_wrapper::check_level(static_cast<uint32_t>(cat), lv))
+#define WLOGFIELD(key, value) util::log::log_kv_field_t(key, value)
+#define WDTLOGFILENF(lv, name) util::log::log_wrapper::caller_info_t(lv, name, __FILE__, __LINE__, __FUNCTION__)
+
+#define WLOG_INIT(cat, lv) NULL != WDTLOGGETCAT(cat) ? WDTLOGGETCAT(cat)->init(lv) : -1
+
+#define WLOG_GETCAT(cat) util::log::log_wrapper::mutable_log_cat(cat)
+
+// 按分类日志输出工具
+#ifdef _MSC_VER
+
+#define WCLOGDEFLV(lv, lv_name, cat, ...) \
+    if (WDTLOGCHECK(cat, lv)) WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), __VA_ARGS__);
+
+#define WCLOGDEBUG(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", cat, __VA_ARGS__)
+#define WCLOGNOTICE(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", cat, __VA_ARGS__)
+#define WCLOGINFO(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", cat, __VA_ARGS__)
+#define WCLOGWARNING(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", cat, __VA_ARGS__)
+#define WCLOGERROR(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", cat, __VA_ARGS__)
+#define WCLOGFATAL(cat, ...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", cat, __VA_ARGS__)
+
+#define WCLOGBINDEFLV(lv, lv_name, cat, ...)                                                                       \
+    if (WDTLOGCHECK(cat, lv)) {                                                                                      \
+        static const util::log::log_wrapper::caller_info_t log_wrapper_bin_caller = WDTLOGFILENF(lv, lv_name); \
+        WDTLOGGETCAT(cat)->log_binary(&log_wrapper_bin_caller, __VA_ARGS__);                                        \
+    }
+
+#define WCLOGBINDEBUG(cat, ...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", cat, __VA_ARGS__)
+#define WCLOGBINNOTICE(cat, ...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", cat, __VA_ARGS__)
+#define WCLOGBININFO(cat, ...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", cat, __VA_ARGS__)
+#define WCLOGBINWARNING(cat, ...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", cat, __VA_ARGS__)
+#define WCLOGBINERROR(cat, ...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", cat, __VA_ARGS__)
+#define WCLOGBINFATAL(cat, ...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", cat, __VA_ARGS__)
+
+// 限频日志，每个调用处每秒最多输出max_per_second条，恢复输出时先输出一条被丢弃条数的汇总
+#define WCLOGRATEDEFLV(lv, lv_name, cat, max_per_second, ...)                                                        \
+    if (WDTLOGCHECK(cat, lv)) {                                                                                      \
+        static util::log::log_rate_limiter log_wrapper_rate_limiter(max_per_second);                                \
+        uint32_t log_wrapper_suppressed = 0;                                                                         \
+        if (log_wrapper_rate_limiter.check(log_wrapper_suppressed)) {                                                \
+            if (0 != log_wrapper_suppressed) {                                                                       \
+                WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), "suppressed %u messages", log_wrapper_suppressed); \
+            }                                                                                                        \
+            WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), __VA_ARGS__);                                          \
+        }                                                                                                            \
+    }
+
+#define WCLOGRATEDEBUG(cat, ...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", cat, __VA_ARGS__)
+#define WCLOGRATENOTICE(cat, ...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", cat, __VA_ARGS__)
+#define WCLOGRATEINFO(cat, ...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", cat, __VA_ARGS__)
+#define WCLOGRATEWARNING(cat, ...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", cat, __VA_ARGS__)
+#define WCLOGRATEERROR(cat, ...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", cat, __VA_ARGS__)
+#define WCLOGRATEFATAL(cat, ...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", cat, __VA_ARGS__)
+
+// 采样日志，每个调用处每every_n条输出一条
+#define WCLOGSAMPLEDEFLV(lv, lv_name, cat, every_n, ...)                                         \
+    if (WDTLOGCHECK(cat, lv)) {                                                                  \
+        static util::log::log_sampler log_wrapper_sampler(every_n);                              \
+        if (log_wrapper_sampler.check()) {                                                       \
+            WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), __VA_ARGS__);                      \
+        }                                                                                        \
+    }
+
+#define WCLOGSAMPLEDEBUG(cat, ...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", cat, __VA_ARGS__)
+#define WCLOGSAMPLENOTICE(cat, ...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", cat, __VA_ARGS__)
+#define WCLOGSAMPLEINFO(cat, ...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", cat, __VA_ARGS__)
+#define WCLOGSAMPLEWARNING(cat, ...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", cat, __VA_ARGS__)
+#define WCLOGSAMPLEERROR(cat, ...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", cat, __VA_ARGS__)
+#define WCLOGSAMPLEFATAL(cat, ...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", cat, __VA_ARGS__)
+
+// 结构化日志，参数是WLOGFIELD(key, value)列表
+#define WCLOGKVDEFLV(lv, lv_name, cat, ...)                                                                            \
+    if (WDTLOGCHECK(cat, lv)) {                                                                                        \
+        const util::log::log_kv_field_t log_wrapper_kv_fields[] = {__VA_ARGS__};                                       \
+        WDTLOGGETCAT(cat)->log_kv(WDTLOGFILENF(lv, lv_name), log_wrapper_kv_fields,                                    \
+                                  sizeof(log_wrapper_kv_fields) / sizeof(log_wrapper_kv_fields[0]));                   \
+    }
+
+#define WCLOGKVDEBUG(cat, ...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", cat, __VA_ARGS__)
+#define WCLOGKVNOTICE(cat, ...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", cat, __VA_ARGS__)
+#define WCLOGKVINFO(cat, ...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", cat, __VA_ARGS__)
+#define WCLOGKVWARNING(cat, ...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", cat, __VA_ARGS__)
+#define WCLOGKVERROR(cat, ...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", cat, __VA_ARGS__)
+#define WCLOGKVFATAL(cat, ...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", cat, __VA_ARGS__)
+
+#else
+
+#define WCLOGDEFLV(lv, lv_name, cat, args...) \
+    if (WDTLOGCHECK(cat, lv)) WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), ##args);
+
+#define WCLOGDEBUG(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", __VA_ARGS__)
+#define WCLOGNOTICE(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", __VA_ARGS__)
+#define WCLOGINFO(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", __VA_ARGS__)
+#define WCLOGWARNING(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", __VA_ARGS__)
+#define WCLOGERROR(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", __VA_ARGS__)
+#define WCLOGFATAL(...) WCLOGDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", __VA_ARGS__)
+
+#define WCLOGBINDEFLV(lv, lv_name, cat, args...)                                                                   \
+    if (WDTLOGCHECK(cat, lv)) {                                                                                      \
+        static const util::log::log_wrapper::caller_info_t log_wrapper_bin_caller = WDTLOGFILENF(lv, lv_name); \
+        WDTLOGGETCAT(cat)->log_binary(&log_wrapper_bin_caller, ##args);                                             \
+    }
+
+#define WCLOGBINDEBUG(...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", __VA_ARGS__)
+#define WCLOGBINNOTICE(...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", __VA_ARGS__)
+#define WCLOGBININFO(...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", __VA_ARGS__)
+#define WCLOGBINWARNING(...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", __VA_ARGS__)
+#define WCLOGBINERROR(...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", __VA_ARGS__)
+#define WCLOGBINFATAL(...) WCLOGBINDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", __VA_ARGS__)
+
+// 限频日志，每个调用处每秒最多输出max_per_second条，恢复输出时先输出一条被丢弃条数的汇总
+#define WCLOGRATEDEFLV(lv, lv_name, cat, max_per_second, args...)                                                    \
+    if (WDTLOGCHECK(cat, lv)) {                                                                                      \
+        static util::log::log_rate_limiter log_wrapper_rate_limiter(max_per_second);                                \
+        uint32_t log_wrapper_suppressed = 0;                                                                         \
+        if (log_wrapper_rate_limiter.check(log_wrapper_suppressed)) {                                                \
+            if (0 != log_wrapper_suppressed) {                                                                       \
+                WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), "suppressed %u messages", log_wrapper_suppressed); \
+            }                                                                                                        \
+            WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), ##args);                                               \
+        }                                                                                                            \
+    }
+
+#define WCLOGRATEDEBUG(...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", __VA_ARGS__)
+#define WCLOGRATENOTICE(...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", __VA_ARGS__)
+#define WCLOGRATEINFO(...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", __VA_ARGS__)
+#define WCLOGRATEWARNING(...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", __VA_ARGS__)
+#define WCLOGRATEERROR(...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", __VA_ARGS__)
+#define WCLOGRATEFATAL(...) WCLOGRATEDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", __VA_ARGS__)
+
+// 采样日志，每个调用处每every_n条输出一条
+#define WCLOGSAMPLEDEFLV(lv, lv_name, cat, every_n, args...)                                     \
+    if (WDTLOGCHECK(cat, lv)) {                                                                  \
+        static util::log::log_sampler log_wrapper_sampler(every_n);                              \
+        if (log_wrapper_sampler.check()) {                                                       \
+            WDTLOGGETCAT(cat)->log(WDTLOGFILENF(lv, lv_name), ##args);                           \
+        }                                                                                        \
+    }
+
+#define WCLOGSAMPLEDEBUG(...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", __VA_ARGS__)
+#define WCLOGSAMPLENOTICE(...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", __VA_ARGS__)
+#define WCLOGSAMPLEINFO(...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", __VA_ARGS__)
+#define WCLOGSAMPLEWARNING(...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", __VA_ARGS__)
+#define WCLOGSAMPLEERROR(...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", __VA_ARGS__)
+#define WCLOGSAMPLEFATAL(...) WCLOGSAMPLEDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", __VA_ARGS__)
+
+// 结构化日志，参数是WLOGFIELD(key, value)列表
+#define WCLOGKVDEFLV(lv, lv_name, cat, args...)                                                                        \
+    if (WDTLOGCHECK(cat, lv)) {                                                                                        \
+        const util::log::log_kv_field_t log_wrapper_kv_fields[] = {args};                                              \
+        WDTLOGGETCAT(cat)->log_kv(WDTLOGFILENF(lv, lv_name), log_wrapper_kv_fields,                                    \
+                                  sizeof(log_wrapper_kv_fields) / sizeof(log_wrapper_kv_fields[0]));                   \
+    }
+
+#define WCLOGKVDEBUG(...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_DEBUG, "Debug", __VA_ARGS__)
+#define WCLOGKVNOTICE(...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_NOTICE, "Notice", __VA_ARGS__)
+#define WCLOGKVINFO(...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_INFO, "Info", __VA_ARGS__)
+#define WCLOGKVWARNING(...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_WARNING, "Warning", __VA_ARGS__)
+#define WCLOGKVERROR(...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_ERROR, "Error", __VA_ARGS__)
+#define WCLOGKVFATAL(...) WCLOGKVDEFLV(util::log::log_wrapper::level_t::LOG_LW_FATAL, "Fatal", __VA_ARGS__)
+
+#endif
+
+// 默认日志输出工具
+#define WLOGDEBUG(...) WCLOGDEBUG(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGNOTICE(...) WCLOGNOTICE(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGINFO(...) WCLOGINFO(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGWARNING(...) WCLOGWARNING(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGERROR(...) WCLOGERROR(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGFATAL(...) WCLOGFATAL(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+
+// 默认二进制日志输出工具
+#define WLOGBINDEBUG(...) WCLOGBINDEBUG(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGBINNOTICE(...) WCLOGBINNOTICE(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGBININFO(...) WCLOGBININFO(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGBINWARNING(...) WCLOGBINWARNING(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGBINERROR(...) WCLOGBINERROR(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGBINFATAL(...) WCLOGBINFATAL(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+
+// 默认限频日志输出工具
+#define WLOGRATEDEBUG(...) WCLOGRATEDEBUG(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGRATENOTICE(...) WCLOGRATENOTICE(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGRATEINFO(...) WCLOGRATEINFO(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGRATEWARNING(...) WCLOGRATEWARNING(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGRATEERROR(...) WCLOGRATEERROR(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGRATEFATAL(...) WCLOGRATEFATAL(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+
+// 默认采样日志输出工具
+#define WLOGSAMPLEDEBUG(...) WCLOGSAMPLEDEBUG(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGSAMPLENOTICE(...) WCLOGSAMPLENOTICE(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGSAMPLEINFO(...) WCLOGSAMPLEINFO(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGSAMPLEWARNING(...) WCLOGSAMPLEWARNING(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGSAMPLEERROR(...) WCLOGSAMPLEERROR(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGSAMPLEFATAL(...) WCLOGSAMPLEFATAL(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+
+// 默认结构化日志输出工具
+#define WLOGKVDEBUG(...) WCLOGKVDEBUG(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGKVNOTICE(...) WCLOGKVNOTICE(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGKVINFO(...) WCLOGKVINFO(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGKVWARNING(...) WCLOGKVWARNING(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGKVERROR(...) WCLOGKVERROR(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+#define WLOGKVFATAL(...) WCLOGKVFATAL(util::log::log_wrapper::categorize_t::DEFAULT, __VA_ARGS__)
+
+
+// 控制台输出工具
+#ifdef _MSC_VER
+#define PSTDTERMCOLOR(code, fmt, ...)                                              \
+    \
+{                                                                           \
+        util::cli::shell_stream::shell_stream_opr log_wrapper_pstd_ss(&std::cout); \
+        log_wrapper_pstd_ss.open(code);                                            \
+        log_wrapper_pstd_ss.close();                                               \
+        printf(fmt, __VA_ARGS__);                                                  \
+    \
+}
+
+#else
+#define PSTDTERMCOLOR(code, fmt, args...)                                          \
+    \
+{                                                                           \
+        util::cli::shell_stream::shell_stream_opr log_wrapper_pstd_ss(&std::cout); \
+        log_wrapper_pstd_ss.open(code);                                            \
+        log_wrapper_pstd_ss.close();                                               \
+        printf(fmt, ##args);                                                       \
+    \
+}
+
+#endif
+
+#define PSTDINFO(...) printf(__VA_ARGS__)
+#define PSTDNOTICE(...) PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_COLOR_YELLOW, __VA_ARGS__)
+#define PSTDWARNING(...) \
+    PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_SPEC_BOLD | util::cli::shell_font_style::SHELL_FONT_COLOR_YELLOW, __VA_ARGS__)
+#define PSTDERROR(...) \
+    PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_SPEC_BOLD | util::cli::shell_font_style::SHELL_FONT_COLOR_RED, __VA_ARGS__)
+#define PSTDFATAL(...) PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_COLOR_MAGENTA, __VA_ARGS__)
+#define PSTDOK(...) PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_COLOR_GREEN, __VA_ARGS__)
+//
+#ifndef NDEBUG
+#define PSTDDEBUG(...) PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_COLOR_CYAN, __VA_ARGS__)
+#define PSTDMARK                                                                                                         \
+    PSTDTERMCOLOR(util::cli::shell_font_style::SHELL_FONT_SPEC_BOLD | util::cli::shell_font_style::SHELL_FONT_COLOR_RED, \
+                  "Mark: %s:%s (function %s)\n", __FILE__, __LINE__, __FUNCTION__)
+#else
+#define PSTDDEBUG(...)
+#define PSTDMARK
+
+#endif
+
+#endif // _UTIL_LOG_LOG_WRAPPER_H_
@@ -0,0 +1,423 @@
+﻿/**
+ * @file lru_concurrent_pool.h
+ * @brief 多线程共享的lru对象池<br />
+ * Licensed under the MIT licenses.
+ *
+ * @note 按key的hash分成多个分片，每个分片是一个加锁的lru_intrusive_pool，不同分片之间没有竞争
+ * @note 分片前面还有每个线程一个的小缓存(magazine)，同一个线程push后马上pull的对象不需要访问分片
+ * @note 线程缓存按线程序号分配，线程数多于缓存数时多个线程共用一个缓存，只是会有锁竞争
+ * @note 线程缓存中的对象不参与LRU淘汰，gc()时会先全部放回分片
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ *
+ * @history
+ */
+
+#ifndef _UTIL_MEMPOOL_LRUCONCURRENTPOOL_H_
+#define _UTIL_MEMPOOL_LRUCONCURRENTPOOL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+#include "std/smart_ptr.h"
+#include "std/thread.h"
+
+#include "lock/atomic_int_type.h"
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+
+#include "lru_intrusive_pool.h"
+
+#ifndef LRU_CONCURRENT_POOL_MAGAZINE_SIZE
+#define LRU_CONCURRENT_POOL_MAGAZINE_SIZE 16
+#endif
+
+namespace util {
+    namespace mempool {
+        class lru_concurrent_pool_base {
+        public:
+            virtual size_t proc(time_t tick) = 0;
+            virtual size_t gc() = 0;
+
+        protected:
+            lru_concurrent_pool_base() {}
+            virtual ~lru_concurrent_pool_base() {}
+        };
+
+        /**
+         * @brief 定时驱动所有注册的lru_concurrent_pool回收对象，可以在任意线程调用
+         */
+        class lru_concurrent_pool_manager {
+        public:
+            typedef std::shared_ptr<lru_concurrent_pool_manager> ptr_t;
+
+        public:
+            static ptr_t create() { return ptr_t(new lru_concurrent_pool_manager()); }
+
+            /**
+             * @brief 定时回调
+             * @param tick 用于判定超时的tick时间，时间单位由业务逻辑决定
+             * @return 此次调用回收的元素的个数
+             */
+            size_t proc(time_t tick) {
+                lock::lock_holder<lock::spin_lock> lkholder(lock_);
+                size_t ret = 0;
+                for (size_t i = 0; i < pools_.size(); ++i) {
+                    ret += pools_[i]->proc(tick);
+                }
+                return ret;
+            }
+
+            /**
+             * @brief 主动GC
+             * @return 此次调用回收的元素的个数
+             */
+            size_t gc() {
+                lock::lock_holder<lock::spin_lock> lkholder(lock_);
+                size_t ret = 0;
+                for (size_t i = 0; i < pools_.size(); ++i) {
+                    ret += pools_[i]->gc();
+                }
+                return ret;
+            }
+
+            void add_pool(lru_concurrent_pool_base *pool) {
+                lock::lock_holder<lock::spin_lock> lkholder(lock_);
+                if (std::find(pools_.begin(), pools_.end(), pool) == pools_.end()) {
+                    pools_.push_back(pool);
+                }
+            }
+
+            void remove_pool(lru_concurrent_pool_base *pool) {
+                lock::lock_holder<lock::spin_lock> lkholder(lock_);
+                std::vector<lru_concurrent_pool_base *>::iterator iter = std::find(pools_.begin(), pools_.end(), pool);
+                if (iter != pools_.end()) {
+                    pools_.erase(iter);
+                }
+            }
+
+        private:
+            lru_concurrent_pool_manager() {}
+
+            lru_concurrent_pool_manager(const lru_concurrent_pool_manager &);
+            lru_concurrent_pool_manager &operator=(const lru_concurrent_pool_manager &);
+
+        private:
+            lock::spin_lock lock_;
+            std::vector<lru_concurrent_pool_base *> pools_;
+        };
+
+        namespace detail {
+            /**
+             * @brief 分片内部使用的行为，push/pull/reset已经由外层调用过，只转发gc
+             */
+            template <typename TObj, typename TAction>
+            struct lru_concurrent_shard_action {
+                void push(TObj *) {}
+                void pull(TObj *) {}
+                void reset(TObj *) {}
+                void gc(TObj *obj) {
+                    TAction act;
+                    act.gc(obj);
+                }
+            };
+
+            /**
+             * @brief 当前线程的序号，从0开始分配
+             */
+            inline size_t lru_concurrent_pool_thread_index() {
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+                static util::lock::atomic_int_type<size_t> index_alloc;
+                static THREAD_TLS size_t ret = 0; // 0表示还没有分配
+                if (0 == ret) {
+                    ret = index_alloc.fetch_add(1, util::lock::memory_order_relaxed) + 1;
+                }
+                return ret - 1;
+#else
+                return 0;
+#endif
+            }
+        }
+
+        template <typename TKey, typename TObj, typename TAction = lru_default_action<TObj>, typename THash = std::hash<TKey> >
+        class lru_concurrent_pool : public lru_concurrent_pool_base {
+        public:
+            typedef TKey key_t;
+            typedef TObj value_type;
+            typedef TAction action_type;
+            typedef lru_intrusive_pool<TKey, TObj, detail::lru_concurrent_shard_action<TObj, TAction> > shard_pool_type;
+
+        private:
+            struct shard_t {
+                lock::spin_lock lock;
+                shard_pool_type pool;
+                lru_intrusive_pool_manager::ptr_t mgr;
+            };
+
+            struct magazine_t {
+                lock::spin_lock lock;
+                size_t size;
+                key_t keys[LRU_CONCURRENT_POOL_MAGAZINE_SIZE];
+                value_type *objects[LRU_CONCURRENT_POOL_MAGAZINE_SIZE];
+
+                magazine_t() : size(0) {}
+            };
+
+            lru_concurrent_pool(const lru_concurrent_pool &);
+            lru_concurrent_pool &operator=(const lru_concurrent_pool &);
+
+        public:
+            /**
+             * @param shard_count 分片数，会向上取整到2的幂
+             * @param magazine_count 线程缓存数，一般设置为使用这个池的线程数
+             */
+            explicit lru_concurrent_pool(size_t shard_count = 16, size_t magazine_count = 64)
+                : shards_(NULL), shard_mask_(0), magazines_(NULL), magazine_count_(magazine_count > 0 ? magazine_count : 1) {
+                size_t n = 1;
+                while (n < shard_count) {
+                    n <<= 1;
+                }
+                shard_mask_ = n - 1;
+
+                shards_ = new shard_t[n];
+                for (size_t i = 0; i < n; ++i) {
+                    shards_[i].mgr = lru_intrusive_pool_manager::create();
+                    shards_[i].pool.init(shards_[i].mgr);
+                }
+
+                magazines_ = new magazine_t[magazine_count_];
+            }
+
+            virtual ~lru_concurrent_pool() {
+                set_manager(lru_concurrent_pool_manager::ptr_t());
+                clear();
+
+                delete[] magazines_;
+                delete[] shards_;
+            }
+
+            /**
+             * @brief 初始化
+             * @param m 所属的全局管理器，管理器会定时调用proc
+             */
+            int init(lru_concurrent_pool_manager::ptr_t m) {
+                set_manager(m);
+                return 0;
+            }
+
+            void set_manager(lru_concurrent_pool_manager::ptr_t m) {
+                if (mgr_) {
+                    mgr_->remove_pool(this);
+                }
+
+                mgr_ = m;
+                if (mgr_) {
+                    mgr_->add_pool(this);
+                }
+            }
+
+            /**
+             * @brief 设置所有分片合计的缓存上限，按分片数平分
+             */
+            void set_item_max_bound(size_t v) {
+                size_t per_shard = v / get_shard_count();
+                for (size_t i = 0; i <= shard_mask_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(shards_[i].lock);
+                    shards_[i].mgr->set_item_max_bound(per_shard > 0 ? per_shard : 1);
+                }
+            }
+
+            /**
+             * @brief 设置所有分片合计的gc()保留数量，按分片数平分
+             */
+            void set_item_min_bound(size_t v) {
+                size_t per_shard = v / get_shard_count();
+                for (size_t i = 0; i <= shard_mask_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(shards_[i].lock);
+                    shards_[i].mgr->set_item_min_bound(per_shard);
+                }
+            }
+
+            /**
+             * @brief 设置每个分片每次proc()或gc()最多回收的数量
+             */
+            void set_proc_item_count(size_t v) {
+                for (size_t i = 0; i <= shard_mask_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(shards_[i].lock);
+                    shards_[i].mgr->set_proc_item_count(v);
+                }
+            }
+
+            void set_list_tick_timeout(time_t v) {
+                for (size_t i = 0; i <= shard_mask_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(shards_[i].lock);
+                    shards_[i].mgr->set_list_tick_timeout(v);
+                }
+            }
+
+            inline size_t get_shard_count() const { return shard_mask_ + 1; }
+
+            inline size_t get_magazine_count() const { return magazine_count_; }
+
+            bool push(key_t id, TObj *obj) {
+                if (NULL == obj) {
+                    return false;
+                }
+
+                TAction act;
+                act.push(obj);
+
+                magazine_t &mag = get_magazine();
+                lock::lock_holder<lock::spin_lock> lkholder(mag.lock);
+                if (mag.size >= LRU_CONCURRENT_POOL_MAGAZINE_SIZE) {
+                    // 满了放回一半，留下最近push的
+                    flush_magazine(mag, LRU_CONCURRENT_POOL_MAGAZINE_SIZE / 2);
+                }
+
+                mag.keys[mag.size] = id;
+                mag.objects[mag.size] = obj;
+                ++mag.size;
+                return true;
+            }
+
+            TObj *pull(key_t id) {
+                value_type *ret = NULL;
+                {
+                    magazine_t &mag = get_magazine();
+                    lock::lock_holder<lock::spin_lock> lkholder(mag.lock);
+                    // FILO，从最近push的开始找
+                    for (size_t i = mag.size; i > 0; --i) {
+                        if (mag.keys[i - 1] == id) {
+                            ret = mag.objects[i - 1];
+                            for (size_t j = i; j < mag.size; ++j) {
+                                mag.keys[j - 1] = mag.keys[j];
+                                mag.objects[j - 1] = mag.objects[j];
+                            }
+                            --mag.size;
+                            break;
+                        }
+                    }
+                }
+
+                if (NULL == ret) {
+                    shard_t &shard = get_shard(id);
+                    lock::lock_holder<lock::spin_lock> lkholder(shard.lock);
+                    ret = shard.pool.pull(id);
+                }
+
+                if (NULL != ret) {
+                    TAction act;
+                    act.pull(ret);
+                    act.reset(ret);
+                }
+
+                return ret;
+            }
+
+            /**
+             * @brief 回收所有分片中超时或超出上限的对象
+             */
+            virtual size_t proc(time_t tick) {
+                size_t ret = 0;
+                for (size_t i = 0; i <= shard_mask_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(shards_[i].lock);
+                    ret += shards_[i].mgr->proc(tick);
+                }
+                return ret;
+            }
+
+            /**
+             * @brief 把所有线程缓存放回分片，再对每个分片执行gc
+             */
+            virtual size_t gc() {
+                flush_magazines();
+
+                size_t ret = 0;
+                for (size_t i = 0; i <= shard_mask_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(shards_[i].lock);
+                    ret += shards_[i].mgr->gc();
+                }
+                return ret;
+            }
+
+            /**
+             * @brief 把所有线程缓存放回分片
+             */
+            void flush_magazines() {
+                for (size_t i = 0; i < magazine_count_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(magazines_[i].lock);
+                    flush_magazine(magazines_[i], magazines_[i].size);
+                }
+            }
+
+            void clear() {
+                flush_magazines();
+
+                for (size_t i = 0; i <= shard_mask_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(shards_[i].lock);
+                    shards_[i].pool.clear();
+                }
+            }
+
+            /**
+             * @brief 获取缓存的对象数，多线程使用时只是近似值
+             */
+            size_t size() {
+                size_t ret = 0;
+                for (size_t i = 0; i < magazine_count_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(magazines_[i].lock);
+                    ret += magazines_[i].size;
+                }
+
+                for (size_t i = 0; i <= shard_mask_; ++i) {
+                    lock::lock_holder<lock::spin_lock> lkholder(shards_[i].lock);
+                    ret += shards_[i].pool.size();
+                }
+                return ret;
+            }
+
+            inline bool empty() { return 0 == size(); }
+
+        private:
+            inline shard_t &get_shard(const key_t &id) { return shards_[THash()(id) & shard_mask_]; }
+
+            inline magazine_t &get_magazine() { return magazines_[detail::lru_concurrent_pool_thread_index() % magazine_count_]; }
+
+            /**
+             * @brief 把线程缓存中最早push的n个对象放回分片，调用前需要锁住线程缓存
+             */
+            void flush_magazine(magazine_t &mag, size_t n) {
+                if (n > mag.size) {
+                    n = mag.size;
+                }
+
+                for (size_t i = 0; i < n; ++i) {
+                    shard_t &shard = get_shard(mag.keys[i]);
+                    lock::lock_holder<lock::spin_lock> lkholder(shard.lock);
+                    shard.pool.push(mag.keys[i], mag.objects[i]);
+                }
+
+                for (size_t i = n; i < mag.size; ++i) {
+                    mag.keys[i - n] = mag.keys[i];
+                    mag.objects[i - n] = mag.objects[i];
+                }
+                mag.size -= n;
+            }
+
+        private:
+            shard_t *shards_;
+            size_t shard_mask_;
+            magazine_t *magazines_;
+            size_t magazine_count_;
+            lru_concurrent_pool_manager::ptr_t mgr_;
+        };
+    }
+}
+
+#endif /* _UTIL_MEMPOOL_LRUCONCURRENTPOOL_H_ */
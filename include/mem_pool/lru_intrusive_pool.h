@@ -0,0 +1,448 @@
+﻿/**
+ * @file lru_intrusive_pool.h
+ * @brief 侵入式链表实现的lru对象池<br />
+ * Licensed under the MIT licenses.
+ *
+ * @note 和lru_pool的接口基本一致，区别是对象的包装节点和LRU链表指针放在一个节点里，节点按块预分配并复用
+ * @note 全局的LRU队列是侵入式双向链表，push、pull和gc都是O(1)，并且节点池够用时不会分配内存
+ * @note 每个key的链表头在第一次push这个key时创建，之后一直保留到clear()，所以key的种类不宜无限增长
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ *
+ * @history
+ */
+
+#ifndef _UTIL_MEMPOOL_LRUINTRUSIVEPOOL_H_
+#define _UTIL_MEMPOOL_LRUINTRUSIVEPOOL_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+#include "std/smart_ptr.h"
+
+#include "lru_object_pool.h"
+
+namespace util {
+    namespace mempool {
+        class lru_intrusive_pool_base;
+
+        /**
+         * @brief 全局LRU队列的节点，所有lru_intrusive_pool的节点都从这里派生
+         */
+        struct lru_intrusive_node_base {
+            lru_intrusive_node_base *lru_prev;
+            lru_intrusive_node_base *lru_next;
+            lru_intrusive_pool_base *owner;
+            time_t push_tick;
+        };
+
+        class lru_intrusive_pool_base {
+        public:
+            /**
+             * @brief 回收一个节点，管理器淘汰节点时调用
+             */
+            virtual void gc_node(lru_intrusive_node_base *node) = 0;
+
+        protected:
+            lru_intrusive_pool_base() {}
+            virtual ~lru_intrusive_pool_base() {}
+        };
+
+        /**
+         * 需要注意保证lru_intrusive_pool_manager所引用的所有lru_intrusive_pool仍然有效
+         */
+        class lru_intrusive_pool_manager {
+        public:
+            typedef std::shared_ptr<lru_intrusive_pool_manager> ptr_t;
+
+        public:
+            static ptr_t create() { return ptr_t(new lru_intrusive_pool_manager()); }
+
+#define _UTIL_MEMPOOL_LRUINTRUSIVEPOOL_SETTER_GETTER(x) \
+    void set_##x(size_t v) { x##_ = v; }                \
+    size_t get_##x() const { return x##_; }
+
+            _UTIL_MEMPOOL_LRUINTRUSIVEPOOL_SETTER_GETTER(item_min_bound);
+            _UTIL_MEMPOOL_LRUINTRUSIVEPOOL_SETTER_GETTER(item_max_bound);
+            _UTIL_MEMPOOL_LRUINTRUSIVEPOOL_SETTER_GETTER(proc_item_count);
+
+#undef _UTIL_MEMPOOL_LRUINTRUSIVEPOOL_SETTER_GETTER
+
+            void set_list_tick_timeout(time_t v) { list_tick_timeout_ = v; }
+
+            time_t get_list_tick_timeout() const { return list_tick_timeout_; }
+
+            /**
+             * @brief 获取实例缓存数量
+             */
+            inline size_t item_count() const { return item_count_; }
+
+            /**
+             * @brief 主动GC，从最久没有使用的对象开始回收，直到缓存数量不超过item_min_bound
+             * @note 每次最多回收proc_item_count个
+             * @return 此次调用回收的元素的个数
+             */
+            size_t gc() {
+                size_t ret = 0;
+                while (ret < proc_item_count_ && item_count_ > item_min_bound_ && NULL != lru_tail_) {
+                    lru_tail_->owner->gc_node(lru_tail_);
+                    ++ret;
+                }
+
+                return ret;
+            }
+
+            /**
+             * @brief 定时回调，回收超时的对象
+             * @param tick 用于判定超时的tick时间，时间单位由业务逻辑决定
+             * @note 每次最多回收proc_item_count个
+             * @return 此次调用回收的元素的个数
+             */
+            size_t proc(time_t tick) {
+                last_proc_tick_ = tick;
+
+                size_t ret = 0;
+                while (ret < proc_item_count_ && NULL != lru_tail_) {
+                    if (item_count_ <= item_max_bound_ && check_tick(lru_tail_->push_tick)) {
+                        break;
+                    }
+
+                    lru_tail_->owner->gc_node(lru_tail_);
+                    ++ret;
+                }
+
+                return ret;
+            }
+
+            /**
+             * @brief 把节点放到LRU队列头部，缓存数量超出item_max_bound时淘汰最久没有使用的节点
+             * @note 由lru_intrusive_pool调用
+             */
+            void link(lru_intrusive_node_base *node) {
+                node->push_tick = last_proc_tick_;
+                node->lru_prev = NULL;
+                node->lru_next = lru_head_;
+                if (NULL != lru_head_) {
+                    lru_head_->lru_prev = node;
+                } else {
+                    lru_tail_ = node;
+                }
+                lru_head_ = node;
+                ++item_count_;
+
+                // 每次最多多出一个，所以淘汰一个就够了
+                if (item_count_ > item_max_bound_ && lru_tail_ != node) {
+                    lru_tail_->owner->gc_node(lru_tail_);
+                }
+            }
+
+            /**
+             * @brief 把节点移出LRU队列
+             * @note 由lru_intrusive_pool调用
+             */
+            void unlink(lru_intrusive_node_base *node) {
+                if (NULL != node->lru_prev) {
+                    node->lru_prev->lru_next = node->lru_next;
+                } else {
+                    lru_head_ = node->lru_next;
+                }
+
+                if (NULL != node->lru_next) {
+                    node->lru_next->lru_prev = node->lru_prev;
+                } else {
+                    lru_tail_ = node->lru_prev;
+                }
+
+                node->lru_prev = NULL;
+                node->lru_next = NULL;
+                --item_count_;
+            }
+
+        private:
+            lru_intrusive_pool_manager()
+                : lru_head_(NULL), lru_tail_(NULL), item_count_(0), item_min_bound_(0), item_max_bound_(1024), proc_item_count_(16),
+                  last_proc_tick_(0), list_tick_timeout_(0) {}
+
+            lru_intrusive_pool_manager(const lru_intrusive_pool_manager &);
+            lru_intrusive_pool_manager &operator=(const lru_intrusive_pool_manager &);
+
+            inline bool check_tick(time_t tp) {
+                using std::abs;
+                return 0 == list_tick_timeout_ || abs(last_proc_tick_ - tp) <= list_tick_timeout_;
+            }
+
+        private:
+            lru_intrusive_node_base *lru_head_; // 最近push的节点
+            lru_intrusive_node_base *lru_tail_; // 最久没有使用的节点
+            size_t item_count_;
+            size_t item_min_bound_;
+            size_t item_max_bound_;
+            size_t proc_item_count_;
+
+            // 检查列表，tick有效期
+            time_t last_proc_tick_;
+            time_t list_tick_timeout_;
+        };
+
+        template <typename TKey, typename TObj, typename TAction = lru_default_action<TObj> >
+        class lru_intrusive_pool : public lru_intrusive_pool_base {
+        public:
+            typedef TKey key_t;
+            typedef TObj value_type;
+            typedef TAction action_type;
+
+            struct list_type;
+
+            struct node_type : public lru_intrusive_node_base {
+                value_type *object;
+                node_type *prev; // 同一个key的链表，空闲时next用作空闲链表
+                node_type *next;
+                list_type *list;
+            };
+
+            struct list_type {
+                node_type *head; // 最近push的节点，FILO
+                node_type *tail;
+                size_t size;
+                key_t id;
+
+                list_type() : head(NULL), tail(NULL), size(0), id() {}
+
+                inline bool empty() const { return NULL == head; }
+            };
+
+            typedef _UTIL_MEMPOOL_LRUOBJECTPOOL_MAP(key_t, list_type) cat_map_type;
+
+        private:
+            lru_intrusive_pool(const lru_intrusive_pool &);
+            lru_intrusive_pool &operator=(const lru_intrusive_pool &);
+
+        public:
+            lru_intrusive_pool() : free_nodes_(NULL), free_count_(0), chunk_size_(256), item_count_(0), clearing_(false) {}
+
+            virtual ~lru_intrusive_pool() {
+                clear();
+
+                for (size_t i = 0; i < chunks_.size(); ++i) {
+                    delete[] chunks_[i];
+                }
+                chunks_.clear();
+            }
+
+            /**
+             * @brief 初始化
+             * @param m 所属的全局管理器，为空时不会自动淘汰
+             */
+            int init(lru_intrusive_pool_manager::ptr_t m) {
+                set_manager(m);
+                return 0;
+            }
+
+            /**
+             * @brief 更换全局管理器，已缓存的对象会移到新管理器的LRU队列中
+             */
+            void set_manager(lru_intrusive_pool_manager::ptr_t m) {
+                if (m == mgr_) {
+                    return;
+                }
+
+                if (mgr_) {
+                    for (typename cat_map_type::iterator iter = data_.begin(); iter != data_.end(); ++iter) {
+                        for (node_type *node = iter->second.head; NULL != node; node = node->next) {
+                            mgr_->unlink(node);
+                        }
+                    }
+                }
+
+                // 加入新管理器时可能触发淘汰，淘汰时要从新管理器中移除
+                mgr_ = m;
+                if (mgr_) {
+                    for (typename cat_map_type::iterator iter = data_.begin(); iter != data_.end(); ++iter) {
+                        // 每个key从旧到新加入，被淘汰的只会是已经加入的节点
+                        for (node_type *node = iter->second.tail; NULL != node; node = node->prev) {
+                            mgr_->link(node);
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief 设置节点池每次扩展的节点数
+             */
+            void set_chunk_size(size_t v) { chunk_size_ = v > 0 ? v : 1; }
+
+            size_t get_chunk_size() const { return chunk_size_; }
+
+            /**
+             * @brief 预分配节点，保证至少有n个空闲节点
+             */
+            void reserve(size_t n) {
+                while (free_count_ < n) {
+                    alloc_chunk(n - free_count_ > chunk_size_ ? n - free_count_ : chunk_size_);
+                }
+            }
+
+            bool push(key_t id, TObj *obj) {
+                if (NULL == obj) {
+                    return false;
+                }
+
+                // clear过程中再推送的对象一律走GC
+                if (clearing_) {
+                    TAction act;
+                    act.gc(obj);
+                    return false;
+                }
+
+                if (NULL == free_nodes_) {
+                    alloc_chunk(chunk_size_);
+                }
+
+                list_type &ls = data_[id];
+                ls.id = id;
+
+                node_type *node = free_nodes_;
+                free_nodes_ = node->next;
+                --free_count_;
+
+                node->owner = this;
+                node->object = obj;
+                node->list = &ls;
+
+                // 推送node, FILO
+                node->prev = NULL;
+                node->next = ls.head;
+                if (NULL != ls.head) {
+                    ls.head->prev = node;
+                } else {
+                    ls.tail = node;
+                }
+                ls.head = node;
+                ++ls.size;
+                ++item_count_;
+
+                TAction act;
+                act.push(obj);
+
+                if (mgr_) {
+                    mgr_->link(node);
+                }
+
+                return true;
+            }
+
+            TObj *pull(key_t id) {
+                typename cat_map_type::iterator iter = data_.find(id);
+                if (iter == data_.end() || iter->second.empty()) {
+                    return NULL;
+                }
+
+                // 拉取node, FILO
+                node_type *node = iter->second.head;
+                value_type *obj = node->object;
+                release_node(node);
+
+                TAction act;
+                act.pull(obj);
+                act.reset(obj);
+
+                return obj;
+            }
+
+            virtual void gc_node(lru_intrusive_node_base *n) {
+                node_type *node = static_cast<node_type *>(n);
+                value_type *obj = node->object;
+                release_node(node);
+
+                TAction act;
+                act.gc(obj);
+            }
+
+            void clear() {
+                // 递归调用clear，直接返回
+                if (clearing_) {
+                    return;
+                }
+
+                clearing_ = true;
+                for (typename cat_map_type::iterator iter = data_.begin(); iter != data_.end(); ++iter) {
+                    while (NULL != iter->second.tail) {
+                        gc_node(iter->second.tail);
+                    }
+                }
+
+                data_.clear();
+                clearing_ = false;
+            }
+
+            inline bool empty() const { return 0 == item_count_; }
+
+            inline size_t size() const { return item_count_; }
+
+            /**
+             * @brief 获取空闲节点数
+             */
+            inline size_t free_size() const { return free_count_; }
+
+            const cat_map_type &data() const { return data_; }
+
+        private:
+            void alloc_chunk(size_t n) {
+                node_type *chunk = new node_type[n];
+                chunks_.push_back(chunk);
+
+                for (size_t i = 0; i < n; ++i) {
+                    chunk[i].next = free_nodes_;
+                    free_nodes_ = &chunk[i];
+                }
+                free_count_ += n;
+            }
+
+            void release_node(node_type *node) {
+                list_type *ls = node->list;
+                if (NULL != node->prev) {
+                    node->prev->next = node->next;
+                } else {
+                    ls->head = node->next;
+                }
+
+                if (NULL != node->next) {
+                    node->next->prev = node->prev;
+                } else {
+                    ls->tail = node->prev;
+                }
+                --ls->size;
+                --item_count_;
+
+                if (mgr_) {
+                    mgr_->unlink(node);
+                }
+
+                node->object = NULL;
+                node->list = NULL;
+                node->prev = NULL;
+                node->next = free_nodes_;
+                free_nodes_ = node;
+                ++free_count_;
+            }
+
+        private:
+            cat_map_type data_;
+            lru_intrusive_pool_manager::ptr_t mgr_;
+            std::vector<node_type *> chunks_;
+            node_type *free_nodes_;
+            size_t free_count_;
+            size_t chunk_size_;
+            size_t item_count_;
+            bool clearing_;
+        };
+    }
+}
+
+#endif /* _UTIL_MEMPOOL_LRUINTRUSIVEPOOL_H_ */
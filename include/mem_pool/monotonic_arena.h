@@ -0,0 +1,227 @@
+﻿/**
+ * @file monotonic_arena.h
+ * @brief 只分配不释放的内存区域，用于一次请求或一帧内的临时对象
+ * Licensed under the MIT licenses.
+ *
+ * @note 分配只是移动指针，单独释放是空操作，reset()或rewind()时一次性回收，内存块会保留给下一次使用
+ * @note 回收时不会调用析构函数，只能放不需要析构的对象，或者在回收前自己析构(比如先销毁使用这个区域的容器)
+ * @note 非线程安全
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ *
+ * @history
+ */
+
+#ifndef _UTIL_MEMPOOL_MONOTONIC_ARENA_H_
+#define _UTIL_MEMPOOL_MONOTONIC_ARENA_H_
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <stdint.h>
+
+#include "design_pattern/noncopyable.h"
+
+#ifndef MONOTONIC_ARENA_BLOCK_SIZE
+#define MONOTONIC_ARENA_BLOCK_SIZE (16 * 1024)
+#endif
+
+#ifndef MONOTONIC_ARENA_DEFAULT_ALIGN
+#define MONOTONIC_ARENA_DEFAULT_ALIGN 16
+#endif
+
+namespace util {
+    namespace mempool {
+        class monotonic_arena : public util::design_pattern::noncopyable {
+        public:
+            struct block_t {
+                block_t *next;
+                size_t size; // 不包含block_t的大小
+                bool external;
+            };
+
+            /**
+             * @brief 记录分配位置，用于rewind
+             */
+            struct marker_t {
+                block_t *block;
+                char *cur;
+            };
+
+        public:
+            /**
+             * @param block_size 每次申请的内存块大小，超过这个大小的分配会单独申请一块
+             */
+            explicit monotonic_arena(size_t block_size = MONOTONIC_ARENA_BLOCK_SIZE);
+
+            /**
+             * @brief 使用外部缓冲区作为第一个内存块，比如栈上的数组，不够时再申请
+             * @note 缓冲区需要在区域析构前一直有效，开头按指针对齐后用来存放block_t
+             */
+            monotonic_arena(void *buffer, size_t buffer_size, size_t block_size = MONOTONIC_ARENA_BLOCK_SIZE);
+
+            ~monotonic_arena();
+
+            /**
+             * @brief 分配内存
+             * @param align 对齐字节数，必须是2的幂
+             * @return 申请内存块失败时返回NULL
+             */
+            inline void *allocate(size_t sz, size_t align = MONOTONIC_ARENA_DEFAULT_ALIGN) {
+                uintptr_t cur = reinterpret_cast<uintptr_t>(cur_);
+                uintptr_t aligned = (cur + align - 1) & ~static_cast<uintptr_t>(align - 1);
+                if (NULL != cur_ && aligned + sz >= aligned && aligned + sz <= reinterpret_cast<uintptr_t>(end_)) {
+                    cur_ = reinterpret_cast<char *>(aligned + sz);
+                    return reinterpret_cast<void *>(aligned);
+                }
+
+                return allocate_slow(sz, align);
+            }
+
+            /**
+             * @brief 单独释放是空操作
+             */
+            inline void deallocate(void *, size_t) {}
+
+            /**
+             * @brief 复制字符串，结果以'\0'结尾
+             */
+            char *strdup(const char *str, size_t len);
+
+            inline marker_t get_marker() const {
+                marker_t ret;
+                ret.block = current_;
+                ret.cur = cur_;
+                return ret;
+            }
+
+            /**
+             * @brief 回收marker之后分配的所有内存，O(1)
+             */
+            void rewind(const marker_t &marker);
+
+            /**
+             * @brief 回收所有内存，保留内存块，O(1)
+             */
+            void reset();
+
+            /**
+             * @brief 回收所有内存，并释放除外部缓冲区以外的内存块
+             */
+            void release();
+
+            /**
+             * @brief 获取当前已分配的字节数(包含对齐和内存块末尾的浪费)
+             */
+            size_t used() const;
+
+            /**
+             * @brief 获取所有内存块的总大小
+             */
+            size_t capacity() const;
+
+            inline size_t get_block_size() const { return block_size_; }
+
+        private:
+            void *allocate_slow(size_t sz, size_t align);
+
+            void use_block(block_t *block);
+
+            static inline char *block_begin(block_t *block) { return reinterpret_cast<char *>(block) + sizeof(block_t); }
+
+        private:
+            block_t *head_;
+            block_t *current_;
+            char *cur_;
+            char *end_;
+            size_t block_size_;
+        };
+
+        /**
+         * @brief 回收作用域内在区域中分配的内存，可以嵌套
+         */
+        class monotonic_arena_scope : public util::design_pattern::noncopyable {
+        public:
+            explicit monotonic_arena_scope(monotonic_arena &arena) : arena_(arena), marker_(arena.get_marker()) {}
+            ~monotonic_arena_scope() { arena_.rewind(marker_); }
+
+        private:
+            monotonic_arena &arena_;
+            monotonic_arena::marker_t marker_;
+        };
+
+        /**
+         * @brief 使用monotonic_arena的STL分配器，容器需要在区域回收前销毁
+         */
+        template <typename T>
+        class monotonic_arena_allocator {
+        public:
+            typedef T value_type;
+            typedef T *pointer;
+            typedef const T *const_pointer;
+            typedef T &reference;
+            typedef const T &const_reference;
+            typedef size_t size_type;
+            typedef ptrdiff_t difference_type;
+
+            template <typename U>
+            struct rebind {
+                typedef monotonic_arena_allocator<U> other;
+            };
+
+            monotonic_arena_allocator(monotonic_arena &arena) : arena_(&arena) {}
+
+            template <typename U>
+            monotonic_arena_allocator(const monotonic_arena_allocator<U> &other) : arena_(other.get_arena()) {}
+
+            pointer address(reference x) const { return &x; }
+            const_pointer address(const_reference x) const { return &x; }
+
+            pointer allocate(size_type n, const void * = NULL) {
+                if (n > max_size()) {
+                    throw std::bad_alloc();
+                }
+
+                size_t align = sizeof(T) < MONOTONIC_ARENA_DEFAULT_ALIGN ? sizeof(T) : MONOTONIC_ARENA_DEFAULT_ALIGN;
+                // 不是2的幂时按默认值对齐
+                if (0 == align || 0 != (align & (align - 1))) {
+                    align = MONOTONIC_ARENA_DEFAULT_ALIGN;
+                }
+
+                void *ret = arena_->allocate(n * sizeof(T), align);
+                if (NULL == ret) {
+                    throw std::bad_alloc();
+                }
+                return static_cast<pointer>(ret);
+            }
+
+            void deallocate(pointer p, size_type n) { arena_->deallocate(p, n * sizeof(T)); }
+
+            size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+            void construct(pointer p, const T &val) { new (static_cast<void *>(p)) T(val); }
+            void destroy(pointer p) { p->~T(); }
+
+            inline monotonic_arena *get_arena() const { return arena_; }
+
+            template <typename U>
+            bool operator==(const monotonic_arena_allocator<U> &other) const {
+                return arena_ == other.get_arena();
+            }
+
+            template <typename U>
+            bool operator!=(const monotonic_arena_allocator<U> &other) const {
+                return arena_ != other.get_arena();
+            }
+
+        private:
+            monotonic_arena *arena_;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,178 @@
+﻿/**
+ * @file slab_allocator.h
+ * @brief 按大小分级的slab内存分配器
+ * Licensed under the MIT licenses.
+ *
+ * @note 小于等于SLAB_ALLOCATOR_MAX_SIZE的内存按大小分级，每级从SLAB_ALLOCATOR_CHUNK_SIZE大小的内存块中切分
+ * @note 每个线程每一级有一个小的空闲链表，不够时从全局空闲链表批量获取，过多时批量归还，只有批量操作需要加锁
+ * @note 线程退出时线程缓存会归还全局空闲链表(Windows下不归还)，内存块不会归还给系统
+ * @note 释放时需要传入申请时的大小，超过SLAB_ALLOCATOR_MAX_SIZE的内存直接使用malloc/free
+ *
+ * @version 1.0
+ * @author owent
+ * @date 2026-10-17
+ *
+ * @history
+ */
+
+#ifndef _UTIL_MEMPOOL_SLAB_ALLOCATOR_H_
+#define _UTIL_MEMPOOL_SLAB_ALLOCATOR_H_
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <stdint.h>
+
+#ifndef SLAB_ALLOCATOR_CHUNK_SIZE
+#define SLAB_ALLOCATOR_CHUNK_SIZE (64 * 1024)
+#endif
+
+#ifndef SLAB_ALLOCATOR_MAX_SIZE
+#define SLAB_ALLOCATOR_MAX_SIZE 4096
+#endif
+
+namespace util {
+    namespace mempool {
+        class slab_allocator {
+        public:
+            // 16-128按16分级，之后每翻一倍分4级
+            enum { SIZE_CLASS_COUNT = 28 };
+
+            /**
+             * @brief 申请内存，按16字节对齐
+             */
+            static void *allocate(size_t sz);
+
+            /**
+             * @brief 释放内存
+             * @param sz 申请时的大小
+             */
+            static void deallocate(void *p, size_t sz);
+
+            /**
+             * @brief 获取大小对应的级别，超过SLAB_ALLOCATOR_MAX_SIZE时返回SIZE_CLASS_COUNT
+             */
+            static size_t get_size_class(size_t sz);
+
+            /**
+             * @brief 获取级别对应的实际分配大小
+             */
+            static size_t get_class_size(size_t cls);
+
+            /**
+             * @brief 把当前线程缓存的内存全部归还到全局空闲链表
+             */
+            static void flush_thread_cache();
+
+            /**
+             * @brief 获取已申请的内存块数
+             */
+            static size_t get_chunk_count();
+
+            /**
+             * @brief 获取某一级全局空闲链表中的数量，不包含线程缓存
+             */
+            static size_t get_central_free_count(size_t cls);
+
+            /**
+             * @brief 申请内存并调用默认构造函数
+             */
+            template <typename T>
+            static T *create() {
+                void *p = allocate(sizeof(T));
+                if (NULL == p) {
+                    return NULL;
+                }
+                return new (p) T();
+            }
+
+            /**
+             * @brief 调用析构函数并释放内存
+             */
+            template <typename T>
+            static void destroy(T *obj) {
+                if (NULL == obj) {
+                    return;
+                }
+                obj->~T();
+                deallocate(obj, sizeof(T));
+            }
+        };
+
+        /**
+         * @brief 使用slab_allocator的STL分配器
+         */
+        template <typename T>
+        class slab_stl_allocator {
+        public:
+            typedef T value_type;
+            typedef T *pointer;
+            typedef const T *const_pointer;
+            typedef T &reference;
+            typedef const T &const_reference;
+            typedef size_t size_type;
+            typedef ptrdiff_t difference_type;
+
+            template <typename U>
+            struct rebind {
+                typedef slab_stl_allocator<U> other;
+            };
+
+            slab_stl_allocator() {}
+
+            template <typename U>
+            slab_stl_allocator(const slab_stl_allocator<U> &) {}
+
+            pointer address(reference x) const { return &x; }
+            const_pointer address(const_reference x) const { return &x; }
+
+            pointer allocate(size_type n, const void * = NULL) {
+                if (n > max_size()) {
+                    throw std::bad_alloc();
+                }
+
+                void *ret = slab_allocator::allocate(n * sizeof(T));
+                if (NULL == ret) {
+                    throw std::bad_alloc();
+                }
+                return static_cast<pointer>(ret);
+            }
+
+            void deallocate(pointer p, size_type n) { slab_allocator::deallocate(p, n * sizeof(T)); }
+
+            size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+            void construct(pointer p, const T &val) { new (static_cast<void *>(p)) T(val); }
+            void destroy(pointer p) { p->~T(); }
+
+            template <typename U>
+            bool operator==(const slab_stl_allocator<U> &) const {
+                return true;
+            }
+
+            template <typename U>
+            bool operator!=(const slab_stl_allocator<U> &) const {
+                return false;
+            }
+        };
+
+        /**
+         * @brief lru_pool的行为，对象由slab_allocator::create创建，gc时归还给slab_allocator
+         */
+        template <typename TObj>
+        struct lru_slab_action {
+            void push(TObj *) {}
+            void pull(TObj *) {}
+            void reset(TObj *) {}
+            void gc(TObj *obj) { slab_allocator::destroy(obj); }
+            size_t size(TObj *) {
+                size_t cls = slab_allocator::get_size_class(sizeof(TObj));
+                return cls < slab_allocator::SIZE_CLASS_COUNT ? slab_allocator::get_class_size(cls) : sizeof(TObj);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,444 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "config/compiler_features.h"
+#include "lock/atomic_int_type.h"
+#include "lock/lock_holder.h"
+
+#include "log/log_async_pipeline.h"
+#include "log/log_stats.h"
+#include "log/log_wrapper.h"
+
+#if !(defined(UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL) && UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL)
+#include <pthread.h>
+#endif
+
+namespace util {
+    namespace log {
+        struct log_async_pipeline::ring_t {
+            // 单调递增的写入/读取位置，实际下标需要与mask做与运算
+            util::lock::atomic_int_type<size_t> head;
+            util::lock::atomic_int_type<size_t> tail;
+            // 所属线程已退出，取空后可以回收
+            util::lock::atomic_int_type<uint32_t> closed;
+            size_t capacity;
+            size_t mask;
+            std::vector<uint64_t> buffer; // 使用uint64_t保证记录头8字节对齐
+
+            explicit ring_t(size_t sz) : capacity(sz), mask(sz - 1), buffer(sz / sizeof(uint64_t)) {
+                head.store(0);
+                tail.store(0);
+                closed.store(0);
+            }
+
+            inline char *data() { return reinterpret_cast<char *>(&buffer[0]); }
+        };
+
+        struct log_async_pipeline::flusher_t {
+            std::thread thd;
+            std::mutex mtx;
+            std::condition_variable cv;
+            util::lock::atomic_int_type<uint32_t> sleeping;
+            // 每个环形缓冲区只能有一个读取者，后台线程、stop()和flush()取数据时都要加锁
+            std::mutex drain_mtx;
+
+            flusher_t() { sleeping.store(0); }
+        };
+
+        namespace detail {
+            struct log_async_record_t {
+                log_wrapper *logger; // NULL表示是尾部的填充块，读取位置需要直接跳到缓冲区开头
+                log_formatter::caller_info_t caller;
+                const char *fmt; // 非NULL表示是二进制日志，内容是编码后的参数
+                size_t content_size;
+                size_t record_size;
+            };
+
+            static inline size_t log_async_align(size_t sz) { return (sz + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1); }
+
+            static const uint32_t LOG_ASYNC_PUSH_STOPPED = 0x80000000;
+
+            // 在同一个原子变量上登记生产者和停止标记，保证stop()最后一次写出前所有已写入缓冲区的记录都已发布
+            struct log_async_push_guard {
+                util::lock::seq_alloc_u32 &pushing;
+                bool stopped;
+
+                explicit log_async_push_guard(util::lock::seq_alloc_u32 &p) : pushing(p) {
+                    stopped = 0 != (pushing.add(1) & LOG_ASYNC_PUSH_STOPPED);
+                }
+
+                ~log_async_push_guard() { pushing.sub(1); }
+            };
+
+            struct log_async_tls_ring_holder {
+                log_async_pipeline::ring_ptr_t ring;
+
+                ~log_async_tls_ring_holder() {
+                    if (ring) {
+                        ring->closed.store(1, util::lock::memory_order_release);
+                    }
+                }
+            };
+
+#if defined(UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL) && UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL
+            static log_async_tls_ring_holder &get_log_async_tls_ring_holder() {
+                static thread_local log_async_tls_ring_holder ret;
+                return ret;
+            }
+#else
+            static pthread_once_t gt_get_log_async_tls_once = PTHREAD_ONCE_INIT;
+            static pthread_key_t gt_get_log_async_tls_key;
+
+            static void dtor_pthread_get_log_async_tls(void *p) {
+                log_async_tls_ring_holder *holder = reinterpret_cast<log_async_tls_ring_holder *>(p);
+                if (NULL != holder) {
+                    delete holder;
+                }
+            }
+
+            static void init_pthread_get_log_async_tls() {
+                (void)pthread_key_create(&gt_get_log_async_tls_key, dtor_pthread_get_log_async_tls);
+            }
+
+            static log_async_tls_ring_holder &get_log_async_tls_ring_holder() {
+                (void)pthread_once(&gt_get_log_async_tls_once, init_pthread_get_log_async_tls);
+                log_async_tls_ring_holder *holder = reinterpret_cast<log_async_tls_ring_holder *>(pthread_getspecific(gt_get_log_async_tls_key));
+                if (NULL == holder) {
+                    holder = new log_async_tls_ring_holder();
+                    pthread_setspecific(gt_get_log_async_tls_key, holder);
+                }
+                return *holder;
+            }
+#endif
+
+            // 0: 未创建, 1: 已创建, 2: 已析构
+            static util::lock::atomic_int_type<uint32_t> g_log_async_pipeline_status;
+        }
+
+        log_async_pipeline::log_async_pipeline()
+            : ring_size_(0), flush_interval_ms_(10), // 默认空闲时10毫秒检查一次
+              block_on_full_(true) {
+            set_ring_size(LOG_WRAPPER_ASYNC_RING_SIZE);
+            running_.set(0);
+            pushing_.set(detail::LOG_ASYNC_PUSH_STOPPED);
+            dropped_count_.set(0);
+        }
+
+        log_async_pipeline::~log_async_pipeline() {
+            stop();
+            detail::g_log_async_pipeline_status.store(2);
+        }
+
+        log_async_pipeline &log_async_pipeline::instance() {
+            static log_async_pipeline ret;
+            if (0 == detail::g_log_async_pipeline_status.load(util::lock::memory_order_acquire)) {
+                detail::g_log_async_pipeline_status.store(1, util::lock::memory_order_release);
+            }
+            return ret;
+        }
+
+        void log_async_pipeline::shutdown() {
+            if (1 != detail::g_log_async_pipeline_status.load(util::lock::memory_order_acquire)) {
+                return;
+            }
+
+            instance().stop();
+        }
+
+        int log_async_pipeline::start() {
+            if (!running_.compare_exchange(0, 1)) {
+                return 1;
+            }
+
+            if (!flusher_) {
+                flusher_ = std::make_shared<flusher_t>();
+                if (!flusher_) {
+                    running_.set(0);
+                    return -1;
+                }
+            }
+
+            pushing_.band(~detail::LOG_ASYNC_PUSH_STOPPED);
+            flusher_->thd = std::thread(flusher_main, this);
+            return 0;
+        }
+
+        void log_async_pipeline::stop() {
+            if (!running_.compare_exchange(1, 0)) {
+                return;
+            }
+
+            if (flusher_) {
+                wakeup();
+                if (flusher_->thd.joinable()) {
+                    flusher_->thd.join();
+                }
+            }
+
+            // 之后进入的生产者都会回退到同步写出，等待已经进入的生产者完成
+            pushing_.bor(detail::LOG_ASYNC_PUSH_STOPPED);
+            while (detail::LOG_ASYNC_PUSH_STOPPED != pushing_.get()) {
+                std::this_thread::yield();
+            }
+
+            // 后台线程已退出，写出剩余的数据
+            drain_all();
+        }
+
+        bool log_async_pipeline::is_running() const { return 0 != running_.get(); }
+
+        void log_async_pipeline::flush() {
+            std::vector<std::pair<ring_ptr_t, size_t> > checkpoints;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(rings_lock_);
+                checkpoints.reserve(rings_.size());
+                for (size_t i = 0; i < rings_.size(); ++i) {
+                    checkpoints.push_back(std::make_pair(rings_[i], rings_[i]->head.load(util::lock::memory_order_acquire)));
+                }
+            }
+
+            for (size_t i = 0; i < checkpoints.size(); ++i) {
+                while (is_running() && checkpoints[i].first->tail.load(util::lock::memory_order_acquire) < checkpoints[i].second) {
+                    wakeup();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
+            if (!is_running()) {
+                drain_all();
+            }
+        }
+
+        bool log_async_pipeline::push(log_wrapper *logger, const caller_info_t &caller, const char *content, size_t content_size) {
+            return push_record(logger, caller, NULL, content, content_size);
+        }
+
+        bool log_async_pipeline::push_binary(log_wrapper *logger, const caller_info_t &caller, const char *fmt, const char *data,
+                                             size_t data_size) {
+            if (NULL == fmt) {
+                return false;
+            }
+
+            return push_record(logger, caller, fmt, data, data_size);
+        }
+
+        bool log_async_pipeline::push_record(log_wrapper *logger, const caller_info_t &caller, const char *fmt, const char *content,
+                                             size_t content_size) {
+            if (!is_running() || NULL == logger) {
+                return false;
+            }
+
+            detail::log_async_push_guard guard(pushing_);
+            if (guard.stopped) {
+                return false;
+            }
+
+            ring_t *ring = mutable_tls_ring();
+            if (NULL == ring) {
+                return false;
+            }
+
+            // 单条记录不能超过缓冲区的一半，超出部分截断
+            const size_t header_size = sizeof(detail::log_async_record_t);
+            if (detail::log_async_align(header_size + content_size + 1) > ring->capacity / 2) {
+                content_size = ring->capacity / 2 - header_size - sizeof(uint64_t);
+            }
+            const size_t need = detail::log_async_align(header_size + content_size + 1);
+
+            unsigned char try_times = 0;
+            while (true) {
+                size_t head = ring->head.load(util::lock::memory_order_relaxed);
+                size_t tail = ring->tail.load(util::lock::memory_order_acquire);
+                size_t pos = head & ring->mask;
+                size_t contiguous = ring->capacity - pos;
+                size_t total = contiguous < need ? contiguous + need : need;
+
+                if (ring->capacity - (head - tail) >= total) {
+                    if (contiguous < need) {
+                        // 尾部空间不足，填充后从头开始写
+                        if (contiguous >= header_size) {
+                            detail::log_async_record_t *padding = new (ring->data() + pos) detail::log_async_record_t();
+                            padding->logger = NULL;
+                            padding->fmt = NULL;
+                            padding->content_size = 0;
+                            padding->record_size = contiguous;
+                        }
+                        head += contiguous;
+                        pos = 0;
+                    }
+
+                    detail::log_async_record_t *record = new (ring->data() + pos) detail::log_async_record_t();
+                    record->logger = logger;
+                    record->caller = caller;
+                    record->fmt = fmt;
+                    record->content_size = content_size;
+                    record->record_size = need;
+
+                    char *record_content = ring->data() + pos + header_size;
+                    if (content_size > 0) {
+                        memcpy(record_content, content, content_size);
+                    }
+                    record_content[content_size] = 0;
+
+                    ring->head.store(head + need, util::lock::memory_order_release);
+
+                    // 使用量超过一半时尽早唤醒后台线程
+                    if (ring->capacity - (head + need - tail) < ring->capacity / 2) {
+                        wakeup();
+                    }
+                    return true;
+                }
+
+                if (!block_on_full_) {
+                    dropped_count_.inc();
+                    log_stats::add(logger->get_category(), log_stats::counter_t::EN_LSC_DROPPED, 1);
+                    return true;
+                }
+
+                wakeup();
+                __UTIL_LOCK_SPIN_LOCK_WAIT(try_times);
+                if (try_times < 255) {
+                    ++try_times;
+                }
+
+                // 等待过程中被停止，交还给调用方同步写出
+                if (!is_running()) {
+                    return false;
+                }
+            }
+        }
+
+        void log_async_pipeline::set_ring_size(size_t sz) {
+            // 至少要能容纳几条记录
+            size_t ret = 4096;
+            while (ret < sz) {
+                ret <<= 1;
+            }
+
+            ring_size_ = ret;
+        }
+
+        log_async_pipeline::ring_t *log_async_pipeline::mutable_tls_ring() {
+            detail::log_async_tls_ring_holder &holder = detail::get_log_async_tls_ring_holder();
+            if (holder.ring) {
+                return holder.ring.get();
+            }
+
+            holder.ring = std::make_shared<ring_t>(ring_size_);
+            if (!holder.ring) {
+                return NULL;
+            }
+
+            lock::lock_holder<lock::spin_lock> lkholder(rings_lock_);
+            rings_.push_back(holder.ring);
+            return holder.ring.get();
+        }
+
+        size_t log_async_pipeline::drain(ring_t &ring) {
+            const size_t header_size = sizeof(detail::log_async_record_t);
+            size_t ret = 0;
+            size_t tail = ring.tail.load(util::lock::memory_order_relaxed);
+            size_t head = ring.head.load(util::lock::memory_order_acquire);
+
+            while (tail != head) {
+                size_t pos = tail & ring.mask;
+                size_t contiguous = ring.capacity - pos;
+
+                // 尾部不足一个记录头的空间不会被写入
+                if (contiguous < header_size) {
+                    tail += contiguous;
+                    continue;
+                }
+
+                detail::log_async_record_t *record = reinterpret_cast<detail::log_async_record_t *>(ring.data() + pos);
+                if (NULL == record->logger) {
+                    tail += contiguous;
+                    continue;
+                }
+
+                if (NULL == record->fmt) {
+                    record->logger->write_sinks(record->caller, ring.data() + pos + header_size, record->content_size);
+                } else {
+                    record->logger->write_binary(record->caller, record->fmt, ring.data() + pos + header_size, record->content_size);
+                }
+                tail += record->record_size;
+                ++ret;
+
+                // 尽早释放空间给生产者
+                ring.tail.store(tail, util::lock::memory_order_release);
+            }
+
+            ring.tail.store(tail, util::lock::memory_order_release);
+            return ret;
+        }
+
+        size_t log_async_pipeline::drain_all() {
+            if (!flusher_) {
+                return 0;
+            }
+
+            std::lock_guard<std::mutex> drain_holder(flusher_->drain_mtx);
+            std::vector<ring_ptr_t> rings;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(rings_lock_);
+                rings = rings_;
+            }
+
+            size_t ret = 0;
+            bool has_closed = false;
+            for (size_t i = 0; i < rings.size(); ++i) {
+                ret += drain(*rings[i]);
+                if (0 != rings[i]->closed.load(util::lock::memory_order_acquire)) {
+                    has_closed = true;
+                }
+            }
+
+            // 回收已退出线程的缓冲区
+            if (has_closed) {
+                lock::lock_holder<lock::spin_lock> lkholder(rings_lock_);
+                for (size_t i = 0; i < rings_.size();) {
+                    if (0 != rings_[i]->closed.load(util::lock::memory_order_acquire) &&
+                        rings_[i]->tail.load(util::lock::memory_order_acquire) == rings_[i]->head.load(util::lock::memory_order_acquire)) {
+                        rings_[i] = rings_.back();
+                        rings_.pop_back();
+                    } else {
+                        ++i;
+                    }
+                }
+            }
+
+            return ret;
+        }
+
+        void log_async_pipeline::wakeup() {
+            if (!flusher_ || 0 == flusher_->sleeping.load(util::lock::memory_order_acquire)) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lkholder(flusher_->mtx);
+            flusher_->cv.notify_one();
+        }
+
+        void log_async_pipeline::flusher_main(log_async_pipeline *self) {
+            std::shared_ptr<flusher_t> flusher = self->flusher_;
+
+            while (self->is_running()) {
+                if (self->drain_all() > 0) {
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lkholder(flusher->mtx);
+                flusher->sleeping.store(1, util::lock::memory_order_release);
+                if (self->is_running()) {
+                    flusher->cv.wait_for(lkholder, std::chrono::milliseconds(self->flush_interval_ms_));
+                }
+                flusher->sleeping.store(0, util::lock::memory_order_release);
+            }
+        }
+    }
+}
@@ -0,0 +1,224 @@
+﻿#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "lock/atomic_int_type.h"
+
+#include "log/log_background_worker.h"
+
+namespace util {
+    namespace log {
+        struct log_background_worker::worker_t {
+            struct timer_t {
+                timer_task_t task;
+                std::chrono::steady_clock::duration interval;
+                std::chrono::steady_clock::time_point next;
+            };
+
+            std::thread thd;
+            std::mutex mtx;
+            std::condition_variable task_cv;
+            std::condition_variable idle_cv;
+            std::list<task_t> tasks;
+            std::list<timer_t> timers;
+            size_t running_tasks;
+            bool started;
+            bool stopping;
+
+            worker_t() : running_tasks(0), started(false), stopping(false) {}
+        };
+
+        namespace detail {
+            // 0: 未创建, 1: 已创建, 2: 已析构
+            static util::lock::atomic_int_type<uint32_t> g_log_background_worker_status;
+        }
+
+        log_background_worker::log_background_worker() { worker_ = std::make_shared<worker_t>(); }
+
+        log_background_worker::~log_background_worker() {
+            detail::g_log_background_worker_status.store(2, util::lock::memory_order_release);
+            stop();
+        }
+
+        log_background_worker *log_background_worker::instance() {
+            if (2 == detail::g_log_background_worker_status.load(util::lock::memory_order_acquire)) {
+                return NULL;
+            }
+
+            static log_background_worker ret;
+            if (0 == detail::g_log_background_worker_status.load(util::lock::memory_order_acquire)) {
+                detail::g_log_background_worker_status.store(1, util::lock::memory_order_release);
+            }
+            return &ret;
+        }
+
+        bool log_background_worker::post(const task_t &task) {
+            log_background_worker *self = instance();
+            if (NULL == self || !task) {
+                return false;
+            }
+
+            return self->post_task(task);
+        }
+
+        bool log_background_worker::add_timer(const timer_task_t &task, time_t interval_ms) {
+            log_background_worker *self = instance();
+            if (NULL == self || !task || interval_ms <= 0) {
+                return false;
+            }
+
+            return self->add_timer_task(task, interval_ms);
+        }
+
+        void log_background_worker::flush() {
+            if (1 != detail::g_log_background_worker_status.load(util::lock::memory_order_acquire)) {
+                return;
+            }
+
+            instance()->wait_idle();
+        }
+
+        void log_background_worker::shutdown() {
+            if (1 != detail::g_log_background_worker_status.load(util::lock::memory_order_acquire)) {
+                return;
+            }
+
+            instance()->stop();
+        }
+
+        bool log_background_worker::post_task(const task_t &task) {
+            if (!worker_) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lkholder(worker_->mtx);
+            if (worker_->stopping) {
+                return false;
+            }
+
+            start_thread();
+            worker_->tasks.push_back(task);
+            worker_->task_cv.notify_one();
+            return true;
+        }
+
+        bool log_background_worker::add_timer_task(const timer_task_t &task, time_t interval_ms) {
+            if (!worker_) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lkholder(worker_->mtx);
+            if (worker_->stopping) {
+                return false;
+            }
+
+            start_thread();
+            worker_->timers.push_back(worker_t::timer_t());
+            worker_t::timer_t &timer = worker_->timers.back();
+            timer.task = task;
+            timer.interval = std::chrono::milliseconds(interval_ms);
+            timer.next = std::chrono::steady_clock::now() + timer.interval;
+            worker_->task_cv.notify_one();
+            return true;
+        }
+
+        void log_background_worker::start_thread() {
+            // 调用方持有worker_->mtx
+            if (!worker_->started) {
+                worker_->thd = std::thread(worker_main, this);
+                worker_->started = true;
+            }
+        }
+
+        void log_background_worker::wait_idle() {
+            if (!worker_) {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lkholder(worker_->mtx);
+            while (worker_->started && (!worker_->tasks.empty() || worker_->running_tasks > 0)) {
+                worker_->idle_cv.wait(lkholder);
+            }
+        }
+
+        void log_background_worker::stop() {
+            if (!worker_) {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lkholder(worker_->mtx);
+                if (worker_->stopping) {
+                    return;
+                }
+                worker_->stopping = true;
+                worker_->task_cv.notify_all();
+            }
+
+            if (worker_->thd.joinable()) {
+                worker_->thd.join();
+            }
+        }
+
+        void log_background_worker::worker_main(log_background_worker *self) {
+            std::shared_ptr<worker_t> worker = self->worker_;
+
+            std::unique_lock<std::mutex> lkholder(worker->mtx);
+            while (true) {
+                if (worker->tasks.empty()) {
+                    if (worker->stopping) {
+                        break;
+                    }
+
+                    // 没有普通任务时执行到期的定时任务，否则等到最早的定时任务到期
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    std::list<worker_t::timer_t>::iterator due = worker->timers.end();
+                    for (std::list<worker_t::timer_t>::iterator iter = worker->timers.begin(); iter != worker->timers.end(); ++iter) {
+                        if (due == worker->timers.end() || iter->next < due->next) {
+                            due = iter;
+                        }
+                    }
+
+                    if (due == worker->timers.end()) {
+                        worker->task_cv.wait(lkholder);
+                    } else if (due->next > now) {
+                        worker->task_cv.wait_until(lkholder, due->next);
+                    } else {
+                        // 执行期间从链表中取出，任务中可以再添加定时任务
+                        std::list<worker_t::timer_t> running;
+                        running.splice(running.begin(), worker->timers, due);
+
+                        lkholder.unlock();
+                        bool keep = running.front().task();
+                        lkholder.lock();
+
+                        if (keep) {
+                            running.front().next = std::chrono::steady_clock::now() + running.front().interval;
+                            worker->timers.splice(worker->timers.end(), running);
+                        }
+                    }
+                    continue;
+                }
+
+                task_t task;
+                task.swap(worker->tasks.front());
+                worker->tasks.pop_front();
+                ++worker->running_tasks;
+
+                lkholder.unlock();
+                task();
+                // 任务中持有的资源(比如待关闭的文件)在后台线程中释放
+                task_t().swap(task);
+                lkholder.lock();
+
+                --worker->running_tasks;
+                if (worker->tasks.empty() && 0 == worker->running_tasks) {
+                    worker->idle_cv.notify_all();
+                }
+            }
+
+            worker->idle_cv.notify_all();
+        }
+    }
+}
@@ -0,0 +1,592 @@
+﻿#include <cstdio>
+#include <cstring>
+
+#include "common/string_oprs.h"
+
+#include "log/log_binary_codec.h"
+
+namespace util {
+    namespace log {
+        namespace detail {
+            struct log_binary_arg_t {
+                enum type {
+                    EN_LBA_NONE = 0, // 不需要参数，原样输出
+                    EN_LBA_PERCENT,  // %%
+                    EN_LBA_INT,
+                    EN_LBA_UINT,
+                    EN_LBA_LONG,
+                    EN_LBA_ULONG,
+                    EN_LBA_LLONG,
+                    EN_LBA_ULLONG,
+                    EN_LBA_INTMAX,
+                    EN_LBA_UINTMAX,
+                    EN_LBA_SIZE,
+                    EN_LBA_PTRDIFF,
+                    EN_LBA_DOUBLE,
+                    EN_LBA_LDOUBLE,
+                    EN_LBA_PTR,
+                    EN_LBA_STR,
+                    EN_LBA_WSTR,      // 宽字符串，不支持还原
+                    EN_LBA_WRITE_BACK // %n，只消耗参数
+                };
+            };
+
+            struct log_binary_spec_t {
+                size_t begin; // 包含'%'
+                size_t end;
+                bool width_star;
+                bool precision_star;
+                int precision; // 没有指定精度时小于0
+                log_binary_arg_t::type arg;
+            };
+
+            struct log_binary_len_t {
+                enum type { EN_LBL_NONE = 0, EN_LBL_HH, EN_LBL_H, EN_LBL_L, EN_LBL_LL, EN_LBL_J, EN_LBL_Z, EN_LBL_T, EN_LBL_BIGL };
+            };
+
+            static inline bool log_binary_is_digit(char c) { return c >= '0' && c <= '9'; }
+
+            static inline bool log_binary_is_flag(char c) { return '-' == c || '+' == c || ' ' == c || '#' == c || '0' == c || '\'' == c; }
+
+            /**
+             * @brief 解析一个转换说明，fmt[begin]必须是'%'
+             * @return 格式串在转换说明中间结束时返回false
+             */
+            static bool log_binary_parse_spec(const char *fmt, size_t begin, log_binary_spec_t &out) {
+                size_t i = begin + 1;
+                out.begin = begin;
+                out.width_star = false;
+                out.precision_star = false;
+                out.precision = -1;
+                out.arg = log_binary_arg_t::EN_LBA_NONE;
+
+                while (fmt[i] && log_binary_is_flag(fmt[i])) {
+                    ++i;
+                }
+
+                if ('*' == fmt[i]) {
+                    out.width_star = true;
+                    ++i;
+                } else {
+                    while (log_binary_is_digit(fmt[i])) {
+                        ++i;
+                    }
+                }
+
+                if ('.' == fmt[i]) {
+                    ++i;
+                    if ('*' == fmt[i]) {
+                        out.precision_star = true;
+                        ++i;
+                    } else {
+                        out.precision = 0;
+                        while (log_binary_is_digit(fmt[i])) {
+                            out.precision = out.precision * 10 + (fmt[i] - '0');
+                            ++i;
+                        }
+                    }
+                }
+
+                log_binary_len_t::type len = log_binary_len_t::EN_LBL_NONE;
+                switch (fmt[i]) {
+                case 'h':
+                    if ('h' == fmt[i + 1]) {
+                        len = log_binary_len_t::EN_LBL_HH;
+                        ++i;
+                    } else {
+                        len = log_binary_len_t::EN_LBL_H;
+                    }
+                    ++i;
+                    break;
+                case 'l':
+                    if ('l' == fmt[i + 1]) {
+                        len = log_binary_len_t::EN_LBL_LL;
+                        ++i;
+                    } else {
+                        len = log_binary_len_t::EN_LBL_L;
+                    }
+                    ++i;
+                    break;
+                case 'q':
+                    len = log_binary_len_t::EN_LBL_LL;
+                    ++i;
+                    break;
+                case 'j':
+                    len = log_binary_len_t::EN_LBL_J;
+                    ++i;
+                    break;
+                case 'z':
+                    len = log_binary_len_t::EN_LBL_Z;
+                    ++i;
+                    break;
+                case 't':
+                    len = log_binary_len_t::EN_LBL_T;
+                    ++i;
+                    break;
+                case 'L':
+                    len = log_binary_len_t::EN_LBL_BIGL;
+                    ++i;
+                    break;
+                case 'I': // MSVC: I64, I32, I
+                    if ('6' == fmt[i + 1] && '4' == fmt[i + 2]) {
+                        len = log_binary_len_t::EN_LBL_LL;
+                        i += 3;
+                    } else if ('3' == fmt[i + 1] && '2' == fmt[i + 2]) {
+                        i += 3;
+                    } else {
+                        len = log_binary_len_t::EN_LBL_Z;
+                        ++i;
+                    }
+                    break;
+                default:
+                    break;
+                }
+
+                if (!fmt[i]) {
+                    out.end = i;
+                    return false;
+                }
+
+                switch (fmt[i]) {
+                case '%':
+                    out.arg = log_binary_arg_t::EN_LBA_PERCENT;
+                    break;
+                case 'd':
+                case 'i':
+                case 'c':
+                    switch (len) {
+                    case log_binary_len_t::EN_LBL_L:
+                        out.arg = 'c' == fmt[i] ? log_binary_arg_t::EN_LBA_UINT : log_binary_arg_t::EN_LBA_LONG;
+                        break;
+                    case log_binary_len_t::EN_LBL_LL:
+                        out.arg = log_binary_arg_t::EN_LBA_LLONG;
+                        break;
+                    case log_binary_len_t::EN_LBL_J:
+                        out.arg = log_binary_arg_t::EN_LBA_INTMAX;
+                        break;
+                    case log_binary_len_t::EN_LBL_Z:
+                        out.arg = log_binary_arg_t::EN_LBA_SIZE;
+                        break;
+                    case log_binary_len_t::EN_LBL_T:
+                        out.arg = log_binary_arg_t::EN_LBA_PTRDIFF;
+                        break;
+                    default:
+                        out.arg = log_binary_arg_t::EN_LBA_INT;
+                        break;
+                    }
+                    break;
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+                    switch (len) {
+                    case log_binary_len_t::EN_LBL_L:
+                        out.arg = log_binary_arg_t::EN_LBA_ULONG;
+                        break;
+                    case log_binary_len_t::EN_LBL_LL:
+                        out.arg = log_binary_arg_t::EN_LBA_ULLONG;
+                        break;
+                    case log_binary_len_t::EN_LBL_J:
+                        out.arg = log_binary_arg_t::EN_LBA_UINTMAX;
+                        break;
+                    case log_binary_len_t::EN_LBL_Z:
+                        out.arg = log_binary_arg_t::EN_LBA_SIZE;
+                        break;
+                    case log_binary_len_t::EN_LBL_T:
+                        out.arg = log_binary_arg_t::EN_LBA_PTRDIFF;
+                        break;
+                    default:
+                        out.arg = log_binary_arg_t::EN_LBA_UINT;
+                        break;
+                    }
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                    out.arg = log_binary_len_t::EN_LBL_BIGL == len ? log_binary_arg_t::EN_LBA_LDOUBLE : log_binary_arg_t::EN_LBA_DOUBLE;
+                    break;
+                case 's':
+                    out.arg = log_binary_len_t::EN_LBL_L == len ? log_binary_arg_t::EN_LBA_WSTR : log_binary_arg_t::EN_LBA_STR;
+                    break;
+                case 'p':
+                    out.arg = log_binary_arg_t::EN_LBA_PTR;
+                    break;
+                case 'n':
+                    out.arg = log_binary_arg_t::EN_LBA_WRITE_BACK;
+                    break;
+                default:
+                    out.arg = log_binary_arg_t::EN_LBA_NONE;
+                    break;
+                }
+
+                out.end = i + 1;
+                return true;
+            }
+
+            class log_binary_writer {
+            public:
+                log_binary_writer(char *buff, size_t bufz) : buff_(buff), bufz_(bufz), used_(0), truncated_(false) {}
+
+                template <typename T>
+                void write(const T &v) {
+                    write_bytes(&v, sizeof(v));
+                }
+
+                void write_bytes(const void *data, size_t sz) {
+                    if (truncated_ || bufz_ - used_ < sz) {
+                        truncated_ = true;
+                        return;
+                    }
+
+                    memcpy(buff_ + used_, data, sz);
+                    used_ += sz;
+                }
+
+                /**
+                 * @param precision 小于0时按'\0'结尾计算长度，否则最多读取precision个字节(%.Ns的参数可以不以'\0'结尾)
+                 */
+                void write_string(const char *s, int precision) {
+                    uint32_t len;
+                    if (NULL == s) {
+                        len = UINT32_MAX;
+                        write(len);
+                        return;
+                    }
+
+                    size_t slen = precision < 0 ? strlen(s) : strnlen(s, static_cast<size_t>(precision));
+                    // 长度 + 内容 + '\0'，空间不足时截断字符串
+                    if (truncated_ || bufz_ - used_ < sizeof(len) + 1) {
+                        truncated_ = true;
+                        return;
+                    }
+                    bool clipped = false;
+                    if (slen > bufz_ - used_ - sizeof(len) - 1) {
+                        slen = bufz_ - used_ - sizeof(len) - 1;
+                        clipped = true;
+                    }
+                    len = static_cast<uint32_t>(slen);
+                    write(len);
+                    write_bytes(s, slen);
+                    buff_[used_++] = 0;
+
+                    // 截断后的内容仍然可以解码，但要告诉调用方扩大缓冲区重试
+                    if (clipped) {
+                        truncated_ = true;
+                    }
+                }
+
+                inline bool truncated() const { return truncated_; }
+                inline size_t size() const { return used_; }
+
+            private:
+                char *buff_;
+                size_t bufz_;
+                size_t used_;
+                bool truncated_;
+            };
+
+            class log_binary_reader {
+            public:
+                log_binary_reader(const char *data, size_t datasz) : data_(data), datasz_(datasz), used_(0) {}
+
+                template <typename T>
+                bool read(T &v) {
+                    if (datasz_ - used_ < sizeof(v)) {
+                        return false;
+                    }
+
+                    memcpy(&v, data_ + used_, sizeof(v));
+                    used_ += sizeof(v);
+                    return true;
+                }
+
+                bool read_string(const char *&s) {
+                    uint32_t len;
+                    if (!read(len)) {
+                        return false;
+                    }
+
+                    if (UINT32_MAX == len) {
+                        s = "(null)";
+                        return true;
+                    }
+
+                    if (datasz_ - used_ < static_cast<size_t>(len) + 1) {
+                        return false;
+                    }
+
+                    s = data_ + used_;
+                    used_ += len + 1;
+                    return true;
+                }
+
+            private:
+                const char *data_;
+                size_t datasz_;
+                size_t used_;
+            };
+        }
+
+        size_t log_binary_codec::encode(char *buff, size_t bufz, const char *fmt, va_list ap, bool *truncated) {
+            if (NULL != truncated) {
+                *truncated = false;
+            }
+
+            if (NULL == buff || NULL == fmt) {
+                return 0;
+            }
+
+            detail::log_binary_writer writer(buff, bufz);
+            detail::log_binary_spec_t spec;
+            for (size_t i = 0; fmt[i] && !writer.truncated();) {
+                if ('%' != fmt[i]) {
+                    ++i;
+                    continue;
+                }
+
+                if (!detail::log_binary_parse_spec(fmt, i, spec)) {
+                    break;
+                }
+                i = spec.end;
+
+                if (spec.width_star) {
+                    writer.write(static_cast<int32_t>(va_arg(ap, int)));
+                }
+
+                if (spec.precision_star) {
+                    // 负数的精度和没有指定精度一样
+                    spec.precision = va_arg(ap, int);
+                    writer.write(static_cast<int32_t>(spec.precision));
+                }
+
+                switch (spec.arg) {
+                case detail::log_binary_arg_t::EN_LBA_INT:
+                    writer.write(static_cast<int64_t>(va_arg(ap, int)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_UINT:
+                    writer.write(static_cast<uint64_t>(va_arg(ap, unsigned int)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_LONG:
+                    writer.write(static_cast<int64_t>(va_arg(ap, long)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_ULONG:
+                    writer.write(static_cast<uint64_t>(va_arg(ap, unsigned long)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_LLONG:
+                    writer.write(static_cast<int64_t>(va_arg(ap, long long)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_ULLONG:
+                    writer.write(static_cast<uint64_t>(va_arg(ap, unsigned long long)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_INTMAX:
+                    writer.write(static_cast<int64_t>(va_arg(ap, intmax_t)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_UINTMAX:
+                    writer.write(static_cast<uint64_t>(va_arg(ap, uintmax_t)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_SIZE:
+                    writer.write(static_cast<uint64_t>(va_arg(ap, size_t)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_PTRDIFF:
+                    writer.write(static_cast<int64_t>(va_arg(ap, ptrdiff_t)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_DOUBLE:
+                    writer.write(va_arg(ap, double));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_LDOUBLE:
+                    writer.write(va_arg(ap, long double));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_PTR:
+                    writer.write(reinterpret_cast<uint64_t>(va_arg(ap, void *)));
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_STR:
+                    writer.write_string(va_arg(ap, const char *), spec.precision);
+                    break;
+                case detail::log_binary_arg_t::EN_LBA_WSTR:
+                case detail::log_binary_arg_t::EN_LBA_WRITE_BACK:
+                    (void)va_arg(ap, void *);
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            if (NULL != truncated) {
+                *truncated = writer.truncated();
+            }
+            return writer.size();
+        }
+
+        size_t log_binary_codec::decode(char *buff, size_t bufz, const char *fmt, const char *data, size_t datasz) {
+            if (NULL == buff || 0 == bufz) {
+                return 0;
+            }
+
+            if (NULL == fmt) {
+                buff[0] = '\0';
+                return 0;
+            }
+
+            detail::log_binary_reader reader(data, NULL == data ? 0 : datasz);
+            detail::log_binary_spec_t spec;
+            size_t ret = 0;
+            bool running = true;
+            // 替换掉*之后的转换说明
+            char spec_fmt[64];
+
+            for (size_t i = 0; fmt[i] && running && ret + 1 < bufz;) {
+                if ('%' != fmt[i]) {
+                    buff[ret++] = fmt[i++];
+                    continue;
+                }
+
+                if (!detail::log_binary_parse_spec(fmt, i, spec)) {
+                    break;
+                }
+                i = spec.end;
+
+                if (detail::log_binary_arg_t::EN_LBA_PERCENT == spec.arg) {
+                    buff[ret++] = '%';
+                    continue;
+                }
+
+                if (detail::log_binary_arg_t::EN_LBA_NONE == spec.arg || detail::log_binary_arg_t::EN_LBA_WRITE_BACK == spec.arg ||
+                    detail::log_binary_arg_t::EN_LBA_WSTR == spec.arg) {
+                    int32_t ignored;
+                    if ((spec.width_star && !reader.read(ignored)) || (spec.precision_star && !reader.read(ignored))) {
+                        break;
+                    }
+
+                    // 不支持的转换说明原样输出
+                    if (detail::log_binary_arg_t::EN_LBA_NONE == spec.arg) {
+                        for (size_t j = spec.begin; j < spec.end && ret + 1 < bufz; ++j) {
+                            buff[ret++] = fmt[j];
+                        }
+                    }
+                    continue;
+                }
+
+                // 重建转换说明
+                size_t spec_len = 0;
+                for (size_t j = spec.begin; j < spec.end && running; ++j) {
+                    if ('*' == fmt[j]) {
+                        int32_t star_val;
+                        if (!reader.read(star_val)) {
+                            running = false;
+                            break;
+                        }
+
+                        // 负数的精度和没有指定精度一样，"%.-1s"不是合法的转换说明
+                        if (j > spec.begin && '.' == fmt[j - 1] && star_val < 0) {
+                            --spec_len;
+                            continue;
+                        }
+
+                        int res = UTIL_STRFUNC_SNPRINTF(&spec_fmt[spec_len], sizeof(spec_fmt) - spec_len, "%d", static_cast<int>(star_val));
+                        if (res < 0 || static_cast<size_t>(res) >= sizeof(spec_fmt) - spec_len) {
+                            running = false;
+                            break;
+                        }
+                        spec_len += static_cast<size_t>(res);
+                    } else if (spec_len + 1 < sizeof(spec_fmt)) {
+                        spec_fmt[spec_len++] = fmt[j];
+                    } else {
+                        running = false;
+                    }
+                }
+
+                if (!running) {
+                    break;
+                }
+                spec_fmt[spec_len] = 0;
+
+                char *out = &buff[ret];
+                size_t outz = bufz - ret;
+                int res = -1;
+
+#define LOG_BINARY_DECODE_VALUE(STORE_TYPE, VALUE_TYPE)                                          \
+    {                                                                                            \
+        STORE_TYPE v;                                                                            \
+        if (!reader.read(v)) {                                                                   \
+            running = false;                                                                     \
+            break;                                                                               \
+        }                                                                                        \
+        res = UTIL_STRFUNC_SNPRINTF(out, outz, spec_fmt, static_cast<VALUE_TYPE>(v));            \
+        break;                                                                                   \
+    }
+
+                switch (spec.arg) {
+                case detail::log_binary_arg_t::EN_LBA_INT:
+                    LOG_BINARY_DECODE_VALUE(int64_t, int)
+                case detail::log_binary_arg_t::EN_LBA_UINT:
+                    LOG_BINARY_DECODE_VALUE(uint64_t, unsigned int)
+                case detail::log_binary_arg_t::EN_LBA_LONG:
+                    LOG_BINARY_DECODE_VALUE(int64_t, long)
+                case detail::log_binary_arg_t::EN_LBA_ULONG:
+                    LOG_BINARY_DECODE_VALUE(uint64_t, unsigned long)
+                case detail::log_binary_arg_t::EN_LBA_LLONG:
+                    LOG_BINARY_DECODE_VALUE(int64_t, long long)
+                case detail::log_binary_arg_t::EN_LBA_ULLONG:
+                    LOG_BINARY_DECODE_VALUE(uint64_t, unsigned long long)
+                case detail::log_binary_arg_t::EN_LBA_INTMAX:
+                    LOG_BINARY_DECODE_VALUE(int64_t, intmax_t)
+                case detail::log_binary_arg_t::EN_LBA_UINTMAX:
+                    LOG_BINARY_DECODE_VALUE(uint64_t, uintmax_t)
+                case detail::log_binary_arg_t::EN_LBA_SIZE:
+                    LOG_BINARY_DECODE_VALUE(uint64_t, size_t)
+                case detail::log_binary_arg_t::EN_LBA_PTRDIFF:
+                    LOG_BINARY_DECODE_VALUE(int64_t, ptrdiff_t)
+                case detail::log_binary_arg_t::EN_LBA_DOUBLE:
+                    LOG_BINARY_DECODE_VALUE(double, double)
+                case detail::log_binary_arg_t::EN_LBA_LDOUBLE:
+                    LOG_BINARY_DECODE_VALUE(long double, long double)
+                case detail::log_binary_arg_t::EN_LBA_PTR: {
+                    uint64_t v;
+                    if (!reader.read(v)) {
+                        running = false;
+                        break;
+                    }
+                    res = UTIL_STRFUNC_SNPRINTF(out, outz, spec_fmt, reinterpret_cast<void *>(static_cast<uintptr_t>(v)));
+                    break;
+                }
+                case detail::log_binary_arg_t::EN_LBA_STR: {
+                    const char *v;
+                    if (!reader.read_string(v)) {
+                        running = false;
+                        break;
+                    }
+                    res = UTIL_STRFUNC_SNPRINTF(out, outz, spec_fmt, v);
+                    break;
+                }
+                default:
+                    break;
+                }
+
+#undef LOG_BINARY_DECODE_VALUE
+
+                if (!running || res < 0) {
+                    break;
+                }
+
+                if (static_cast<size_t>(res) >= outz) {
+                    ret = bufz - 1;
+                    break;
+                }
+                ret += static_cast<size_t>(res);
+            }
+
+            if (ret < bufz) {
+                buff[ret] = '\0';
+            } else {
+                ret = bufz - 1;
+                buff[ret] = '\0';
+            }
+            return ret;
+        }
+    }
+}
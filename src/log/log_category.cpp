@@ -0,0 +1,166 @@
+﻿#include <cstring>
+
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+
+#include "log/log_category.h"
+
+#if defined(__cplusplus) &&                                                                                         \
+    (__cplusplus >= 201103L || (defined(_MSC_VER) && (_MSC_VER == 1500 && defined(_HAS_TR1)) || _MSC_VER > 1500) || \
+     (defined(__GNUC__) && defined(__GXX_EXPERIMENTAL_CXX0X__)))
+#include <unordered_map>
+#define LOG_CATEGORY_MAP(...) std::unordered_map<__VA_ARGS__>
+#else
+#include <map>
+#define LOG_CATEGORY_MAP(...) std::map<__VA_ARGS__>
+#endif
+
+namespace util {
+    namespace log {
+        struct log_category_registry_t {
+            typedef LOG_CATEGORY_MAP(std::string, log_category *) category_map_t;
+
+            lock::spin_lock lock;
+            log_category root;
+            category_map_t categories;
+
+            log_category_registry_t() : root(std::string(), NULL) {
+                root.logger_ = log_wrapper::categorize_t::DEFAULT;
+                root.refresh();
+            }
+
+            // 调用前需要加锁
+            log_category *find(const std::string &name) {
+                if (name.empty()) {
+                    return &root;
+                }
+
+                category_map_t::iterator iter = categories.find(name);
+                if (iter == categories.end()) {
+                    return NULL;
+                }
+
+                return iter->second;
+            }
+
+            // 调用前需要加锁，会先注册所有父分类
+            log_category *create(const std::string &name) {
+                log_category *ret = find(name);
+                if (NULL != ret) {
+                    return ret;
+                }
+
+                std::string::size_type dot = name.find_last_of('.');
+                log_category *parent = (std::string::npos == dot) ? &root : create(name.substr(0, dot));
+
+                ret = new log_category(name, parent);
+                parent->children_.push_back(ret);
+                categories[name] = ret;
+                ret->refresh();
+                return ret;
+            }
+        };
+
+        // 分类指针会被缓存在各个调用处，所以注册表不释放
+        static log_category_registry_t *get_log_category_registry() {
+            static log_category_registry_t *ret = new log_category_registry_t();
+            return ret;
+        }
+
+        log_category::log_category(const std::string &name, log_category *parent)
+            : name_(name), parent_(parent), level_(-1), logger_(-1) {
+            effective_level_.store(-1, util::lock::memory_order_relaxed);
+            effective_logger_.store(log_wrapper::categorize_t::DEFAULT, util::lock::memory_order_relaxed);
+        }
+
+        log_category *log_category::get(const char *name) {
+            log_category_registry_t *registry = get_log_category_registry();
+            std::string key = (NULL == name) ? std::string() : std::string(name);
+
+            lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+            return registry->create(key);
+        }
+
+        log_category *log_category::find(const char *name) {
+            log_category_registry_t *registry = get_log_category_registry();
+            std::string key = (NULL == name) ? std::string() : std::string(name);
+
+            lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+            return registry->find(key);
+        }
+
+        log_category &log_category::root() { return get_log_category_registry()->root; }
+
+        log_wrapper::level_t::type log_category::get_level() const {
+            int effective_level = effective_level_.load(util::lock::memory_order_relaxed);
+            if (effective_level >= 0) {
+                return static_cast<log_wrapper::level_t::type>(effective_level);
+            }
+
+            log_wrapper *logger = get_logger();
+            if (NULL == logger) {
+                return log_wrapper::level_t::LOG_LW_DISABLED;
+            }
+
+            return logger->get_level();
+        }
+
+        void log_category::set_level(log_wrapper::level_t::type level) {
+            log_category_registry_t *registry = get_log_category_registry();
+            lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+
+            level_ = static_cast<int>(level);
+            refresh();
+        }
+
+        void log_category::reset_level() {
+            log_category_registry_t *registry = get_log_category_registry();
+            lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+
+            level_ = -1;
+            refresh();
+        }
+
+        void log_category::set_logger(uint32_t cat) {
+            if (cat >= log_wrapper::categorize_t::MAX) {
+                return;
+            }
+
+            log_category_registry_t *registry = get_log_category_registry();
+            lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+
+            logger_ = static_cast<int64_t>(cat);
+            refresh();
+        }
+
+        void log_category::reset_logger() {
+            log_category_registry_t *registry = get_log_category_registry();
+            lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+
+            // 根分类没有可以继承的分类，重置为默认分类
+            logger_ = (NULL == parent_) ? static_cast<int64_t>(log_wrapper::categorize_t::DEFAULT) : -1;
+            refresh();
+        }
+
+        void log_category::refresh() {
+            int effective_level = level_;
+            if (effective_level < 0 && NULL != parent_) {
+                effective_level = parent_->effective_level_.load(util::lock::memory_order_relaxed);
+            }
+
+            uint32_t effective_logger = log_wrapper::categorize_t::DEFAULT;
+            if (logger_ >= 0) {
+                effective_logger = static_cast<uint32_t>(logger_);
+            } else if (NULL != parent_) {
+                effective_logger = parent_->effective_logger_.load(util::lock::memory_order_relaxed);
+            }
+
+            effective_logger_.store(effective_logger, util::lock::memory_order_relaxed);
+            effective_level_.store(effective_level, util::lock::memory_order_relaxed);
+
+            for (size_t i = 0; i < children_.size(); ++i) {
+                children_[i]->refresh();
+            }
+        }
+    }
+}
@@ -1,345 +1,487 @@
-﻿#include <cstdio>
-#include <cstring>
-
-#include "common/string_oprs.h"
-
-#include "time/time_utility.h"
-
-#include "log/log_formatter.h"
-
-namespace util {
-    namespace log {
-
-        log_formatter::caller_info_t::caller_info_t()
-            : level_id(level_t::LOG_LW_DISABLED), level_name(NULL), file_path(NULL), line_number(0), func_name(NULL), rotate_index(0) {}
-        log_formatter::caller_info_t::caller_info_t(level_t::type lid, const char *lname, const char *fpath, uint32_t lnum,
-                                                   const char *fnname)
-            : level_id(lid), level_name(lname), file_path(fpath), line_number(lnum), func_name(fnname), rotate_index(0) {}
-
-        log_formatter::caller_info_t::caller_info_t(level_t::type lid, const char *lname, const char *fpath, uint32_t lnum, const char *fnname, uint32_t ridx)
-            : level_id(lid), level_name(lname), file_path(fpath), line_number(lnum), func_name(fnname), rotate_index(ridx) {}
-
-        bool log_formatter::check(int32_t flags, int32_t checked) { return (flags & checked) == checked; }
-
-        struct tm *log_formatter::get_iso_tm() {
-            static time_t tm_tp = 0;
-            static struct tm tm_obj;
-            if (tm_tp != util::time::time_utility::get_now()) {
-                tm_tp = util::time::time_utility::get_now();
-                UTIL_STRFUNC_LOCALTIME_S(&tm_tp, &tm_obj);
-            }
-
-            return &tm_obj;
-        }
-
-        size_t log_formatter::format(char *buff, size_t bufz, const char *fmt, size_t fmtz, const caller_info_t &caller) {
-            if (NULL == buff || 0 == bufz) {
-                return 0;
-            }
-
-            if (NULL == fmt || 0 == fmtz) {
-                buff[0] = '\0';
-                return 0;
-            }
-
-            bool need_parse = false, running = true;
-            size_t ret = 0;
-            struct tm tm_obj_cache;
-            struct tm *tm_obj_ptr = NULL;
-
-// 时间加缓存，以防使用过程中时间变化
-#define LOG_FMT_FN_TM_MEM(VAR, EXPRESS) \
-    \
-int VAR;                                \
-    \
-if(NULL == tm_obj_ptr) {                \
-        tm_obj_cache = *get_iso_tm();   \
-        tm_obj_ptr = &tm_obj_cache;     \
-        VAR = tm_obj_ptr->EXPRESS;      \
-    \
-}                                \
-    else {                              \
-        VAR = tm_obj_ptr->EXPRESS;      \
-    \
-}
-
-            for (size_t i = 0; i < fmtz && ret < bufz && running; ++i) {
-                if (!need_parse) {
-                    if ('%' == fmt[i]) {
-                        need_parse = true;
-                    } else {
-                        buff[ret++] = fmt[i];
-                    }
-                    continue;
-                }
-
-                need_parse = false;
-                // 以后再优化
-                switch (fmt[i]) {
-                // =================== datetime ===================
-                case 'Y': {
-                    if (bufz - ret < 4) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(year, tm_year + 1900);
-                        buff[ret++] = static_cast<char>(year / 1000 + '0');
-                        buff[ret++] = static_cast<char>((year / 100) % 10 + '0');
-                        buff[ret++] = static_cast<char>((year / 10) % 10 + '0');
-                        buff[ret++] = static_cast<char>(year % 10 + '0');
-                    }
-                    break;
-                }
-                case 'y': {
-                    if (bufz - ret < 2) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(year, tm_year + 1900);
-                        buff[ret++] = static_cast<char>((year / 10) % 10 + '0');
-                        buff[ret++] = static_cast<char>(year % 10 + '0');
-                    }
-                    break;
-                }
-                case 'm': {
-                    if (bufz - ret < 2) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(mon, tm_mon + 1);
-                        buff[ret++] = static_cast<char>(mon / 10 + '0');
-                        buff[ret++] = static_cast<char>(mon % 10 + '0');
-                    }
-                    break;
-                }
-                case 'j': {
-                    if (bufz - ret < 3) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(yday, tm_yday);
-                        buff[ret++] = static_cast<char>(yday / 100 + '0');
-                        buff[ret++] = static_cast<char>((yday / 10) % 10 + '0');
-                        buff[ret++] = static_cast<char>(yday % 10 + '0');
-                    }
-                    break;
-                }
-                case 'd': {
-                    if (bufz - ret < 2) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(mday, tm_mday);
-                        buff[ret++] = static_cast<char>(mday / 10 + '0');
-                        buff[ret++] = static_cast<char>(mday % 10 + '0');
-                    }
-                    break;
-                }
-                case 'w': {
-                    LOG_FMT_FN_TM_MEM(wday, tm_wday);
-                    buff[ret++] = static_cast<char>(wday + '0');
-                    break;
-                }
-                case 'H': {
-                    if (bufz - ret < 2) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(hour, tm_hour);
-                        buff[ret++] = static_cast<char>(hour / 10 + '0');
-                        buff[ret++] = static_cast<char>(hour % 10 + '0');
-                    }
-                    break;
-                }
-                case 'I': {
-                    if (bufz - ret < 2) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(hour, tm_hour % 12 + 1);
-                        buff[ret++] = static_cast<char>(hour / 10 + '0');
-                        buff[ret++] = static_cast<char>(hour % 10 + '0');
-                    }
-                    break;
-                }
-                case 'M': {
-                    if (bufz - ret < 2) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(minite, tm_min);
-                        buff[ret++] = static_cast<char>(minite / 10 + '0');
-                        buff[ret++] = static_cast<char>(minite % 10 + '0');
-                    }
-                    break;
-                }
-                case 'S': {
-                    if (bufz - ret < 2) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(sec, tm_sec);
-                        buff[ret++] = static_cast<char>(sec / 10 + '0');
-                        buff[ret++] = static_cast<char>(sec % 10 + '0');
-                    }
-                    break;
-                }
-                case 'F': {
-                    if (bufz - ret < 10) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(year, tm_year + 1900);
-                        LOG_FMT_FN_TM_MEM(mon, tm_mon + 1);
-                        LOG_FMT_FN_TM_MEM(mday, tm_mday);
-                        buff[ret++] = static_cast<char>(year / 1000 + '0');
-                        buff[ret++] = static_cast<char>((year / 100) % 10 + '0');
-                        buff[ret++] = static_cast<char>((year / 10) % 10 + '0');
-                        buff[ret++] = static_cast<char>(year % 10 + '0');
-                        buff[ret++] = '-';
-                        buff[ret++] = static_cast<char>(mon / 10 + '0');
-                        buff[ret++] = static_cast<char>(mon % 10 + '0');
-                        buff[ret++] = '-';
-                        buff[ret++] = static_cast<char>(mday / 10 + '0');
-                        buff[ret++] = static_cast<char>(mday % 10 + '0');
-                    }
-                    break;
-                }
-                case 'T': {
-                    if (bufz - ret < 8) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(hour, tm_hour);
-                        LOG_FMT_FN_TM_MEM(minite, tm_min);
-                        LOG_FMT_FN_TM_MEM(sec, tm_sec);
-                        buff[ret++] = static_cast<char>(hour / 10 + '0');
-                        buff[ret++] = static_cast<char>(hour % 10 + '0');
-                        buff[ret++] = ':';
-                        buff[ret++] = static_cast<char>(minite / 10 + '0');
-                        buff[ret++] = static_cast<char>(minite % 10 + '0');
-                        buff[ret++] = ':';
-                        buff[ret++] = static_cast<char>(sec / 10 + '0');
-                        buff[ret++] = static_cast<char>(sec % 10 + '0');
-                    }
-                    break;
-                }
-                case 'R': {
-                    if (bufz - ret < 5) {
-                        running = false;
-                    } else {
-                        LOG_FMT_FN_TM_MEM(hour, tm_hour);
-                        LOG_FMT_FN_TM_MEM(minite, tm_min);
-                        buff[ret++] = static_cast<char>(hour / 10 + '0');
-                        buff[ret++] = static_cast<char>(hour % 10 + '0');
-                        buff[ret++] = ':';
-                        buff[ret++] = static_cast<char>(minite / 10 + '0');
-                        buff[ret++] = static_cast<char>(minite % 10 + '0');
-                    }
-                    break;
-                }
-
-                case 'f': {
-                    if (bufz - ret < 3) {
-                        running = false;
-                    } else {
-                        clock_t clk = (clock() / (CLOCKS_PER_SEC / 1000)) % 1000;
-                        buff[ret++] = static_cast<char>(clk / 100 + '0');
-                        buff[ret++] = static_cast<char>((clk / 10) % 10 + '0');
-                        buff[ret++] = static_cast<char>(clk % 10 + '0');
-                    }
-
-                    break;
-                }
-
-                // =================== caller data ===================
-                case 'L': {
-                    if (NULL != caller.level_name) {
-                        int res = UTIL_STRFUNC_SNPRINTF(&buff[ret], bufz - ret, "%8s", caller.level_name);
-                        if (res < 0) {
-                            running = false;
-                        } else {
-                            ret += static_cast<size_t>(res);
-                        }
-                    }
-                    break;
-                }
-                case 'l': {
-                    int res = UTIL_STRFUNC_SNPRINTF(&buff[ret], bufz - ret, "%d", static_cast<int>(caller.level_id));
-                    if (res < 0) {
-                        running = false;
-                    } else {
-                        ret += static_cast<size_t>(res);
-                    }
-                    break;
-                }
-                case 's': {
-                    if (NULL != caller.file_path) {
-                        int res = UTIL_STRFUNC_SNPRINTF(&buff[ret], bufz - ret, "%s", caller.file_path);
-                        if (res < 0) {
-                            running = false;
-                        } else {
-                            ret += static_cast<size_t>(res);
-                        }
-                    }
-                    break;
-                }
-                case 'n': {
-                    int res = UTIL_STRFUNC_SNPRINTF(&buff[ret], bufz - ret, "%u", caller.line_number);
-                    if (res < 0) {
-                        running = false;
-                    } else {
-                        ret += static_cast<size_t>(res);
-                    }
-                    break;
-                }
-                case 'C': {
-                    if (NULL != caller.func_name) {
-                        int res = UTIL_STRFUNC_SNPRINTF(&buff[ret], bufz - ret, "%s", caller.func_name);
-                        if (res < 0) {
-                            running = false;
-                        } else {
-                            ret += static_cast<size_t>(res);
-                        }
-                    }
-                    break;
-                }
-                // =================== rotate index ===================
-                case 'N': {
-                    int res = UTIL_STRFUNC_SNPRINTF(&buff[ret], bufz - ret, "%u", caller.rotate_index);
-                    if (res < 0) {
-                        running = false;
-                    } else {
-                        ret += static_cast<size_t>(res);
-                    }
-                    break;
-                }
-
-                // =================== unknown ===================
-                default: {
-                    buff[ret++] = fmt[i];
-                    break;
-                }
-                }
-            }
-
-#undef LOG_FMT_FN_TM_MEM
-
-            if (ret < bufz) {
-                buff[ret] = '\0';
-            } else {
-                buff[bufz - 1] = '\0';
-            }
-            return ret;
-        }
-
-        bool log_formatter::check_rotation_var(const char *fmt, size_t fmtz) {
-            for (size_t i = 0; fmt && i < fmtz - 1; ++i) {
-                if ('%' == fmt[i] && 'N' == fmt[i + 1]) {
-                    return true;
-                }
-            }
-
-            return false;
-        }
-
-        bool log_formatter::has_format(const char *fmt, size_t fmtz) {
-            for (size_t i = 0; fmt && i < fmtz - 1; ++i) {
-                if ('%' == fmt[i]) {
-                    return true;
-                }
-            }
-
-            return false;
-        }
-    }
-}
+﻿#include <cstdio>
+#include <cstring>
+
+#include "common/string_oprs.h"
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+#include "std/thread.h"
+
+#include "time/time_utility.h"
+
+#include "log/log_formatter.h"
+
+namespace util {
+    namespace log {
+        namespace detail {
+            struct log_formatter_time_cache_t {
+                time_t tp;
+                struct tm tm_obj;
+                char date[11]; // YYYY-MM-DD
+                char time[9];  // HH:MM:SS
+            };
+
+            static inline void log_formatter_write_2digits(char *buff, int v) {
+                buff[0] = static_cast<char>((v / 10) % 10 + '0');
+                buff[1] = static_cast<char>(v % 10 + '0');
+            }
+
+            static void log_formatter_render_date(log_formatter_time_cache_t &cache) {
+                int year = cache.tm_obj.tm_year + 1900;
+                log_formatter_write_2digits(&cache.date[0], year / 100);
+                log_formatter_write_2digits(&cache.date[2], year);
+                cache.date[4] = '-';
+                log_formatter_write_2digits(&cache.date[5], cache.tm_obj.tm_mon + 1);
+                cache.date[7] = '-';
+                log_formatter_write_2digits(&cache.date[8], cache.tm_obj.tm_mday);
+                cache.date[10] = 0;
+            }
+
+            static void log_formatter_render_time(log_formatter_time_cache_t &cache) {
+                log_formatter_write_2digits(&cache.time[0], cache.tm_obj.tm_hour);
+                cache.time[2] = ':';
+                log_formatter_write_2digits(&cache.time[3], cache.tm_obj.tm_min);
+                cache.time[5] = ':';
+                log_formatter_write_2digits(&cache.time[6], cache.tm_obj.tm_sec);
+                cache.time[8] = 0;
+            }
+
+            /**
+             * @brief 刷新时间缓存
+             * @note 时区和夏令时的切换都发生在整分钟，所以同一分钟内只需要修改秒数，跨分钟时才调用localtime
+             */
+            static void log_formatter_refresh_time_cache(log_formatter_time_cache_t &cache, time_t tp) {
+                if (cache.tp == tp && 0 != tp) {
+                    return;
+                }
+
+                if (0 != cache.tp && tp > cache.tp && tp - cache.tp + cache.tm_obj.tm_sec < 60) {
+                    cache.tm_obj.tm_sec += static_cast<int>(tp - cache.tp);
+                    cache.tp = tp;
+                    log_formatter_write_2digits(&cache.time[6], cache.tm_obj.tm_sec);
+                    return;
+                }
+
+                cache.tp = tp;
+                UTIL_STRFUNC_LOCALTIME_S(&cache.tp, &cache.tm_obj);
+                log_formatter_render_date(cache);
+                log_formatter_render_time(cache);
+            }
+
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+            // 每个线程独立缓存，不需要加锁，每秒最多刷新一次
+            static const log_formatter_time_cache_t &get_log_formatter_time_cache(time_t tp) {
+                static THREAD_TLS log_formatter_time_cache_t ret; // POD类型，线程启动时为0
+                log_formatter_refresh_time_cache(ret, tp);
+                return ret;
+            }
+#else
+            static const log_formatter_time_cache_t &get_log_formatter_time_cache(time_t tp, log_formatter_time_cache_t &out) {
+                static log_formatter_time_cache_t ret;
+                static lock::spin_lock ret_lock;
+
+                lock::lock_holder<lock::spin_lock> lkholder(ret_lock);
+                log_formatter_refresh_time_cache(ret, tp);
+                out = ret;
+                return out;
+            }
+#endif
+
+            struct log_formatter_context_t {
+                const log_formatter::caller_info_t &caller;
+                const log_formatter_time_cache_t *time_cache;
+#if !(defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED)
+                log_formatter_time_cache_t time_cache_copy;
+#endif
+
+                explicit log_formatter_context_t(const log_formatter::caller_info_t &c) : caller(c), time_cache(NULL) {}
+
+                // 一次格式化过程中只取一次时间，以防使用过程中时间变化
+                const log_formatter_time_cache_t &get_time() {
+                    if (NULL == time_cache) {
+                        time_t tp = 0 != caller.log_time ? caller.log_time : util::time::time_utility::get_now();
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+                        time_cache = &get_log_formatter_time_cache(tp);
+#else
+                        time_cache = &get_log_formatter_time_cache(tp, time_cache_copy);
+#endif
+                    }
+
+                    return *time_cache;
+                }
+
+                uint32_t get_nsec() const {
+                    if (0 != caller.log_time) {
+                        return caller.log_time_nsec % 1000000000;
+                    }
+
+                    return static_cast<uint32_t>((util::time::time_utility::get_now_usec() % 1000000) * 1000);
+                }
+            };
+
+            static log_formatter::format_op_t::type log_formatter_parse_op(char c, bool &known) {
+                known = true;
+                switch (c) {
+                case 'Y':
+                    return log_formatter::format_op_t::FOP_YEAR;
+                case 'y':
+                    return log_formatter::format_op_t::FOP_YEAR2;
+                case 'm':
+                    return log_formatter::format_op_t::FOP_MONTH;
+                case 'j':
+                    return log_formatter::format_op_t::FOP_YDAY;
+                case 'd':
+                    return log_formatter::format_op_t::FOP_MDAY;
+                case 'w':
+                    return log_formatter::format_op_t::FOP_WDAY;
+                case 'H':
+                    return log_formatter::format_op_t::FOP_HOUR;
+                case 'I':
+                    return log_formatter::format_op_t::FOP_HOUR12;
+                case 'M':
+                    return log_formatter::format_op_t::FOP_MINUTE;
+                case 'S':
+                    return log_formatter::format_op_t::FOP_SECOND;
+                case 'F':
+                    return log_formatter::format_op_t::FOP_DATE;
+                case 'T':
+                    return log_formatter::format_op_t::FOP_TIME;
+                case 'R':
+                    return log_formatter::format_op_t::FOP_HOUR_MINUTE;
+                case 'f':
+                    return log_formatter::format_op_t::FOP_MSEC;
+                case 'u':
+                    return log_formatter::format_op_t::FOP_USEC;
+                case 'i':
+                    return log_formatter::format_op_t::FOP_NSEC;
+                case 'L':
+                    return log_formatter::format_op_t::FOP_LEVEL_NAME;
+                case 'l':
+                    return log_formatter::format_op_t::FOP_LEVEL_ID;
+                case 's':
+                    return log_formatter::format_op_t::FOP_FILE_PATH;
+                case 'n':
+                    return log_formatter::format_op_t::FOP_LINE_NUMBER;
+                case 'C':
+                    return log_formatter::format_op_t::FOP_FUNC_NAME;
+                case 'N':
+                    return log_formatter::format_op_t::FOP_ROTATE_INDEX;
+                default:
+                    known = false;
+                    return log_formatter::format_op_t::FOP_LITERAL;
+                }
+            }
+
+            /**
+             * @brief 写出文本，空间不足时截断
+             * @note cap不包含结尾的'\0'
+             * @return 全部写出返回true
+             */
+            static inline bool log_formatter_write_text(char *buff, size_t cap, size_t &ret, const char *text, size_t len) {
+                bool full = cap - ret < len;
+                if (full) {
+                    len = cap - ret;
+                }
+
+                memcpy(&buff[ret], text, len);
+                ret += len;
+                return !full;
+            }
+
+            static inline bool log_formatter_write_uint(char *buff, size_t cap, size_t &ret, uint64_t v) {
+                char digits[24];
+                size_t len = 0;
+                do {
+                    digits[sizeof(digits) - 1 - len] = static_cast<char>(v % 10 + '0');
+                    v /= 10;
+                    ++len;
+                } while (v > 0);
+
+                return log_formatter_write_text(buff, cap, ret, &digits[sizeof(digits) - len], len);
+            }
+
+            // 输出定长的小数部分，不足位数时前面补0
+            static inline bool log_formatter_write_fraction(char *buff, size_t cap, size_t &ret, uint32_t v, size_t width) {
+                if (cap - ret < width) {
+                    return false;
+                }
+
+                for (size_t i = width; i > 0; --i) {
+                    buff[ret + i - 1] = static_cast<char>(v % 10 + '0');
+                    v /= 10;
+                }
+                ret += width;
+                return true;
+            }
+
+            /**
+             * @brief 输出一个格式化项
+             * @return 缓冲区不足时返回false
+             */
+            static bool log_formatter_write_op(char *buff, size_t cap, size_t &ret, log_formatter::format_op_t::type op,
+                                               log_formatter_context_t &ctx) {
+                switch (op) {
+                // =================== datetime ===================
+                case log_formatter::format_op_t::FOP_YEAR:
+                    return log_formatter_write_text(buff, cap, ret, &ctx.get_time().date[0], 4);
+                case log_formatter::format_op_t::FOP_YEAR2:
+                    return log_formatter_write_text(buff, cap, ret, &ctx.get_time().date[2], 2);
+                case log_formatter::format_op_t::FOP_MONTH:
+                    return log_formatter_write_text(buff, cap, ret, &ctx.get_time().date[5], 2);
+                case log_formatter::format_op_t::FOP_MDAY:
+                    return log_formatter_write_text(buff, cap, ret, &ctx.get_time().date[8], 2);
+                case log_formatter::format_op_t::FOP_DATE:
+                    return log_formatter_write_text(buff, cap, ret, ctx.get_time().date, 10);
+                case log_formatter::format_op_t::FOP_HOUR:
+                    return log_formatter_write_text(buff, cap, ret, &ctx.get_time().time[0], 2);
+                case log_formatter::format_op_t::FOP_MINUTE:
+                    return log_formatter_write_text(buff, cap, ret, &ctx.get_time().time[3], 2);
+                case log_formatter::format_op_t::FOP_SECOND:
+                    return log_formatter_write_text(buff, cap, ret, &ctx.get_time().time[6], 2);
+                case log_formatter::format_op_t::FOP_TIME:
+                    return log_formatter_write_text(buff, cap, ret, ctx.get_time().time, 8);
+                case log_formatter::format_op_t::FOP_HOUR_MINUTE:
+                    return log_formatter_write_text(buff, cap, ret, ctx.get_time().time, 5);
+                case log_formatter::format_op_t::FOP_YDAY: {
+                    if (cap - ret < 3) {
+                        return false;
+                    }
+                    int yday = ctx.get_time().tm_obj.tm_yday;
+                    buff[ret++] = static_cast<char>(yday / 100 + '0');
+                    log_formatter_write_2digits(&buff[ret], yday);
+                    ret += 2;
+                    return true;
+                }
+                case log_formatter::format_op_t::FOP_WDAY: {
+                    if (cap - ret < 1) {
+                        return false;
+                    }
+                    buff[ret++] = static_cast<char>(ctx.get_time().tm_obj.tm_wday + '0');
+                    return true;
+                }
+                case log_formatter::format_op_t::FOP_HOUR12: {
+                    if (cap - ret < 2) {
+                        return false;
+                    }
+                    log_formatter_write_2digits(&buff[ret], ctx.get_time().tm_obj.tm_hour % 12 + 1);
+                    ret += 2;
+                    return true;
+                }
+                case log_formatter::format_op_t::FOP_MSEC:
+                    return log_formatter_write_fraction(buff, cap, ret, ctx.get_nsec() / 1000000, 3);
+                case log_formatter::format_op_t::FOP_USEC:
+                    return log_formatter_write_fraction(buff, cap, ret, ctx.get_nsec() / 1000, 6);
+                case log_formatter::format_op_t::FOP_NSEC:
+                    return log_formatter_write_fraction(buff, cap, ret, ctx.get_nsec(), 9);
+
+                // =================== caller data ===================
+                case log_formatter::format_op_t::FOP_LEVEL_NAME: {
+                    if (NULL == ctx.caller.level_name) {
+                        return true;
+                    }
+
+                    // 等同于"%8s"
+                    size_t len = strlen(ctx.caller.level_name);
+                    while (len < 8) {
+                        if (ret >= cap) {
+                            return false;
+                        }
+                        buff[ret++] = ' ';
+                        ++len;
+                    }
+                    return log_formatter_write_text(buff, cap, ret, ctx.caller.level_name, strlen(ctx.caller.level_name));
+                }
+                case log_formatter::format_op_t::FOP_LEVEL_ID:
+                    return log_formatter_write_uint(buff, cap, ret, static_cast<uint64_t>(ctx.caller.level_id));
+                case log_formatter::format_op_t::FOP_FILE_PATH:
+                    if (NULL == ctx.caller.file_path) {
+                        return true;
+                    }
+                    return log_formatter_write_text(buff, cap, ret, ctx.caller.file_path, strlen(ctx.caller.file_path));
+                case log_formatter::format_op_t::FOP_LINE_NUMBER:
+                    return log_formatter_write_uint(buff, cap, ret, ctx.caller.line_number);
+                case log_formatter::format_op_t::FOP_FUNC_NAME:
+                    if (NULL == ctx.caller.func_name) {
+                        return true;
+                    }
+                    return log_formatter_write_text(buff, cap, ret, ctx.caller.func_name, strlen(ctx.caller.func_name));
+
+                // =================== rotate index ===================
+                case log_formatter::format_op_t::FOP_ROTATE_INDEX:
+                    return log_formatter_write_uint(buff, cap, ret, ctx.caller.rotate_index);
+
+                default:
+                    return true;
+                }
+            }
+        }
+
+        log_formatter::caller_info_t::caller_info_t()
+            : level_id(level_t::LOG_LW_DISABLED), level_name(NULL), file_path(NULL), line_number(0), func_name(NULL), rotate_index(0), log_time(0),
+              log_time_nsec(0) {}
+        log_formatter::caller_info_t::caller_info_t(level_t::type lid, const char *lname, const char *fpath, uint32_t lnum,
+                                                   const char *fnname)
+            : level_id(lid), level_name(lname), file_path(fpath), line_number(lnum), func_name(fnname), rotate_index(0), log_time(0),
+              log_time_nsec(0) {}
+
+        log_formatter::caller_info_t::caller_info_t(level_t::type lid, const char *lname, const char *fpath, uint32_t lnum, const char *fnname, uint32_t ridx)
+            : level_id(lid), level_name(lname), file_path(fpath), line_number(lnum), func_name(fnname), rotate_index(ridx), log_time(0),
+              log_time_nsec(0) {}
+
+        bool log_formatter::check(int32_t flags, int32_t checked) { return (flags & checked) == checked; }
+
+        size_t log_formatter::format(char *buff, size_t bufz, const char *fmt, size_t fmtz, const caller_info_t &caller) {
+            if (NULL == buff || 0 == bufz) {
+                return 0;
+            }
+
+            if (NULL == fmt || 0 == fmtz) {
+                buff[0] = '\0';
+                return 0;
+            }
+
+            // 保留结尾'\0'的位置
+            const size_t cap = bufz - 1;
+            detail::log_formatter_context_t ctx(caller);
+            bool need_parse = false, running = true;
+            size_t ret = 0;
+
+            for (size_t i = 0; i < fmtz && ret < cap && running; ++i) {
+                if (!need_parse) {
+                    if ('%' == fmt[i]) {
+                        need_parse = true;
+                    } else {
+                        buff[ret++] = fmt[i];
+                    }
+                    continue;
+                }
+
+                need_parse = false;
+                bool known;
+                format_op_t::type op = detail::log_formatter_parse_op(fmt[i], known);
+                if (known) {
+                    running = detail::log_formatter_write_op(buff, cap, ret, op, ctx);
+                } else {
+                    // =================== unknown ===================
+                    buff[ret++] = fmt[i];
+                }
+            }
+
+            buff[ret] = '\0';
+            return ret;
+        }
+
+        size_t log_formatter::format(char *buff, size_t bufz, const compiled_t &fmt, const caller_info_t &caller) {
+            if (NULL == buff || 0 == bufz) {
+                return 0;
+            }
+
+            const size_t cap = bufz - 1;
+            detail::log_formatter_context_t ctx(caller);
+            size_t ret = 0;
+            const char *literals = fmt.literals_.data();
+
+            for (std::vector<compiled_t::op_t>::const_iterator iter = fmt.ops_.begin(); iter != fmt.ops_.end(); ++iter) {
+                bool running;
+                if (format_op_t::FOP_LITERAL == iter->op) {
+                    running = detail::log_formatter_write_text(buff, cap, ret, literals + iter->offset, iter->length);
+                } else {
+                    running = detail::log_formatter_write_op(buff, cap, ret, iter->op, ctx);
+                }
+
+                if (!running) {
+                    break;
+                }
+            }
+
+            buff[ret] = '\0';
+            return ret;
+        }
+
+        log_formatter::compiled_t::compiled_t() : has_rotation_var_(false), has_time_var_(false), has_source_var_(false) {}
+
+        log_formatter::compiled_t::compiled_t(const std::string &fmt)
+            : has_rotation_var_(false), has_time_var_(false), has_source_var_(false) {
+            compile(fmt);
+        }
+
+        void log_formatter::compiled_t::compile(const std::string &fmt) {
+            source_ = fmt;
+            literals_.clear();
+            ops_.clear();
+            has_rotation_var_ = false;
+            has_time_var_ = false;
+            has_source_var_ = false;
+
+            op_t literal;
+            literal.op = format_op_t::FOP_LITERAL;
+            literal.offset = 0;
+            literal.length = 0;
+
+            bool need_parse = false;
+            for (size_t i = 0; i < fmt.size(); ++i) {
+                if (!need_parse) {
+                    if ('%' == fmt[i]) {
+                        need_parse = true;
+                    } else {
+                        literals_.push_back(fmt[i]);
+                        ++literal.length;
+                    }
+                    continue;
+                }
+
+                need_parse = false;
+                bool known;
+                op_t op;
+                op.op = detail::log_formatter_parse_op(fmt[i], known);
+                op.offset = 0;
+                op.length = 0;
+
+                // 未知的格式化项原样输出，合并到文本中
+                if (!known) {
+                    literals_.push_back(fmt[i]);
+                    ++literal.length;
+                    continue;
+                }
+
+                if (literal.length > 0) {
+                    ops_.push_back(literal);
+                    literal.offset = literals_.size();
+                    literal.length = 0;
+                }
+
+                if (format_op_t::FOP_ROTATE_INDEX == op.op) {
+                    has_rotation_var_ = true;
+                } else if (op.op >= format_op_t::FOP_YEAR && op.op <= format_op_t::FOP_NSEC) {
+                    has_time_var_ = true;
+                } else if (format_op_t::FOP_FILE_PATH == op.op || format_op_t::FOP_LINE_NUMBER == op.op) {
+                    has_source_var_ = true;
+                }
+                ops_.push_back(op);
+            }
+
+            if (literal.length > 0) {
+                ops_.push_back(literal);
+            }
+        }
+
+        bool log_formatter::check_rotation_var(const char *fmt, size_t fmtz) {
+            for (size_t i = 0; fmt && i < fmtz - 1; ++i) {
+                if ('%' == fmt[i] && 'N' == fmt[i + 1]) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool log_formatter::has_format(const char *fmt, size_t fmtz) {
+            for (size_t i = 0; fmt && i < fmtz - 1; ++i) {
+                if ('%' == fmt[i]) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    }
+}
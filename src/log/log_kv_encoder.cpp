@@ -0,0 +1,301 @@
+﻿#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/string_oprs.h"
+
+#include "log/log_kv_encoder.h"
+
+namespace util {
+    namespace log {
+        namespace detail {
+            static const char log_kv_encoder_digits[] = "00010203040506070809"
+                                                        "10111213141516171819"
+                                                        "20212223242526272829"
+                                                        "30313233343536373839"
+                                                        "40414243444546474849"
+                                                        "50515253545556575859"
+                                                        "60616263646566676869"
+                                                        "70717273747576777879"
+                                                        "80818283848586878889"
+                                                        "90919293949596979899";
+
+            static const char log_kv_encoder_hex[] = "0123456789abcdef";
+
+            // JSON和logfmt带引号的值都需要转义的字符
+            static inline bool log_kv_encoder_need_escape(unsigned char c) { return c < 0x20 || '"' == c || '\\' == c; }
+
+            static inline bool log_kv_encoder_need_quote(const char *data, size_t sz) {
+                if (0 == sz) {
+                    return true;
+                }
+
+                for (size_t i = 0; i < sz; ++i) {
+                    unsigned char c = static_cast<unsigned char>(data[i]);
+                    if (c <= ' ' || '=' == c || '"' == c || '\\' == c || 0x7f == c) {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+        }
+
+        log_kv_encoder::log_kv_encoder(char *buff, size_t bufz, format_t::type fmt)
+            : buff_(buff), bufz_(bufz), used_(0), field_start_(0), field_count_(0), fmt_(fmt), truncated_(false) {
+            // 至少要能放下"{}\0"
+            if (NULL == buff_ || bufz_ < 3) {
+                truncated_ = true;
+                return;
+            }
+
+            if (format_t::EN_KV_FMT_JSON == fmt_) {
+                buff_[used_++] = '{';
+            }
+        }
+
+        log_kv_encoder &log_kv_encoder::add_caller(const log_formatter::caller_info_t &caller) {
+            static log_formatter::compiled_t time_format("%Y-%m-%dT%H:%M:%S.%u");
+
+            char time_buffer[64];
+            size_t time_len = log_formatter::format(time_buffer, sizeof(time_buffer), time_format, caller);
+            add(log_kv_field_t("time", time_buffer, time_len));
+
+            if (NULL != caller.level_name) {
+                add(log_kv_field_t("level", caller.level_name));
+            } else {
+                add(log_kv_field_t("level", static_cast<int>(caller.level_id)));
+            }
+
+            if (NULL != caller.file_path) {
+                add(log_kv_field_t("file", caller.file_path));
+                add(log_kv_field_t("line", caller.line_number));
+            }
+
+            if (NULL != caller.func_name) {
+                add(log_kv_field_t("func", caller.func_name));
+            }
+
+            return *this;
+        }
+
+        log_kv_encoder &log_kv_encoder::add(const log_kv_field_t &field) {
+            if (!begin_field(field.key)) {
+                end_field(false);
+                return *this;
+            }
+
+            bool res = false;
+            switch (field.value_type) {
+            case log_kv_field_t::value_type_t::EN_KV_INT: {
+                char num[24];
+                res = write_raw(num, write_int(num, field.int_value));
+                break;
+            }
+            case log_kv_field_t::value_type_t::EN_KV_UINT: {
+                char num[24];
+                res = write_raw(num, write_uint(num, field.uint_value));
+                break;
+            }
+            case log_kv_field_t::value_type_t::EN_KV_DOUBLE: {
+                double v = field.double_value;
+                // NaN和无穷大相减的结果都是NaN，不依赖C++11的std::isfinite
+                if ((v - v) != (v - v) && format_t::EN_KV_FMT_JSON == fmt_) {
+                    res = write_raw("null", 4);
+                    break;
+                }
+
+                // 优先使用较短的表示，不能还原时才输出全部有效位
+                char num[32];
+                int len = UTIL_STRFUNC_SNPRINTF(num, sizeof(num), "%.15g", v);
+                if (len > 0 && static_cast<size_t>(len) < sizeof(num) && strtod(num, NULL) != v && v == v) {
+                    len = UTIL_STRFUNC_SNPRINTF(num, sizeof(num), "%.17g", v);
+                }
+
+                res = len > 0 && static_cast<size_t>(len) < sizeof(num) && write_raw(num, static_cast<size_t>(len));
+                break;
+            }
+            case log_kv_field_t::value_type_t::EN_KV_BOOL: {
+                res = field.bool_value ? write_raw("true", 4) : write_raw("false", 5);
+                break;
+            }
+            case log_kv_field_t::value_type_t::EN_KV_STRING: {
+                if (NULL == field.string_value.data && format_t::EN_KV_FMT_JSON == fmt_) {
+                    res = write_raw("null", 4);
+                } else {
+                    res = write_string(field.string_value.data, field.string_value.size, false);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+
+            end_field(res);
+            return *this;
+        }
+
+        size_t log_kv_encoder::finish() {
+            if (NULL == buff_ || 0 == bufz_) {
+                return 0;
+            }
+
+            if (bufz_ < 3) {
+                buff_[0] = 0;
+                return 0;
+            }
+
+            // 构造时已经预留了结尾的空间
+            if (format_t::EN_KV_FMT_JSON == fmt_) {
+                buff_[used_++] = '}';
+            }
+            buff_[used_] = 0;
+            return used_;
+        }
+
+        size_t log_kv_encoder::write_uint(char *buff, uint64_t v) {
+            char tmp[24];
+            char *end = tmp + sizeof(tmp);
+            char *p = end;
+
+            while (v >= 100) {
+                size_t idx = static_cast<size_t>(v % 100) * 2;
+                v /= 100;
+                *--p = detail::log_kv_encoder_digits[idx + 1];
+                *--p = detail::log_kv_encoder_digits[idx];
+            }
+
+            if (v >= 10) {
+                size_t idx = static_cast<size_t>(v) * 2;
+                *--p = detail::log_kv_encoder_digits[idx + 1];
+                *--p = detail::log_kv_encoder_digits[idx];
+            } else {
+                *--p = static_cast<char>('0' + v);
+            }
+
+            size_t len = static_cast<size_t>(end - p);
+            memcpy(buff, p, len);
+            return len;
+        }
+
+        size_t log_kv_encoder::write_int(char *buff, int64_t v) {
+            if (v >= 0) {
+                return write_uint(buff, static_cast<uint64_t>(v));
+            }
+
+            // 不能直接取负，INT64_MIN取负会溢出
+            buff[0] = '-';
+            return 1 + write_uint(buff + 1, 0 - static_cast<uint64_t>(v));
+        }
+
+        bool log_kv_encoder::begin_field(const char *key) {
+            if (truncated_ || NULL == key) {
+                return false;
+            }
+
+            field_start_ = used_;
+            if (field_count_ > 0) {
+                if (!write_char(format_t::EN_KV_FMT_JSON == fmt_ ? ',' : ' ')) {
+                    return false;
+                }
+            }
+
+            if (format_t::EN_KV_FMT_JSON == fmt_) {
+                return write_string(key, strlen(key), true) && write_char(':');
+            }
+
+            return write_raw(key, strlen(key)) && write_char('=');
+        }
+
+        void log_kv_encoder::end_field(bool success) {
+            if (success) {
+                ++field_count_;
+                return;
+            }
+
+            // 放不下的字段整个丢弃，之后的字段也不再写入，保证输出是完整的一行
+            if (!truncated_) {
+                used_ = field_start_;
+                truncated_ = true;
+            }
+        }
+
+        bool log_kv_encoder::write_raw(const char *data, size_t sz) {
+            // JSON结尾要预留'}'和'\0'，logfmt只需要预留'\0'
+            size_t reserve = format_t::EN_KV_FMT_JSON == fmt_ ? 2 : 1;
+            if (used_ + sz + reserve > bufz_) {
+                return false;
+            }
+
+            if (sz > 0) {
+                memcpy(buff_ + used_, data, sz);
+                used_ += sz;
+            }
+            return true;
+        }
+
+        bool log_kv_encoder::write_char(char c) { return write_raw(&c, 1); }
+
+        bool log_kv_encoder::write_string(const char *data, size_t sz, bool is_key) {
+            if (NULL == data) {
+                sz = 0;
+            }
+
+            if (format_t::EN_KV_FMT_LOGFMT == fmt_ && !is_key && !detail::log_kv_encoder_need_quote(data, sz)) {
+                return write_raw(data, sz);
+            }
+
+            if (!write_char('"')) {
+                return false;
+            }
+
+            // 连续的不需要转义的字符一次写入
+            size_t run_start = 0;
+            for (size_t i = 0; i < sz; ++i) {
+                unsigned char c = static_cast<unsigned char>(data[i]);
+                if (!detail::log_kv_encoder_need_escape(c)) {
+                    continue;
+                }
+
+                if (!write_raw(data + run_start, i - run_start)) {
+                    return false;
+                }
+                run_start = i + 1;
+
+                char escaped[6] = {'\\', 0, 0, 0, 0, 0};
+                size_t escaped_len = 2;
+                switch (c) {
+                case '"':
+                    escaped[1] = '"';
+                    break;
+                case '\\':
+                    escaped[1] = '\\';
+                    break;
+                case '\n':
+                    escaped[1] = 'n';
+                    break;
+                case '\r':
+                    escaped[1] = 'r';
+                    break;
+                case '\t':
+                    escaped[1] = 't';
+                    break;
+                default:
+                    escaped[1] = 'u';
+                    escaped[2] = '0';
+                    escaped[3] = '0';
+                    escaped[4] = detail::log_kv_encoder_hex[c >> 4];
+                    escaped[5] = detail::log_kv_encoder_hex[c & 0x0f];
+                    escaped_len = 6;
+                    break;
+                }
+
+                if (!write_raw(escaped, escaped_len)) {
+                    return false;
+                }
+            }
+
+            return write_raw(data + run_start, sz - run_start) && write_char('"');
+        }
+    }
+}
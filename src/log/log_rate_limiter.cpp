@@ -0,0 +1,46 @@
+﻿#include "time/time_utility.h"
+
+#include "log/log_rate_limiter.h"
+
+namespace util {
+    namespace log {
+        log_rate_limiter::log_rate_limiter(uint32_t max_per_second) : max_per_second_(max_per_second) {
+            window_.store(0, util::lock::memory_order_relaxed);
+            count_.store(0, util::lock::memory_order_relaxed);
+            suppressed_.store(0, util::lock::memory_order_relaxed);
+        }
+
+        bool log_rate_limiter::check(uint32_t &suppressed) {
+            time_t now_sec, now_nsec;
+            util::time::time_utility::get_sys_now(now_sec, now_nsec);
+
+            // 进入新的一秒时重置计数，只有一个线程能切换成功
+            time_t window = window_.load(util::lock::memory_order_relaxed);
+            if (window != now_sec && window_.compare_exchange_strong(window, now_sec, util::lock::memory_order_relaxed)) {
+                count_.store(0, util::lock::memory_order_relaxed);
+            }
+
+            if (count_.fetch_add(1, util::lock::memory_order_relaxed) >= max_per_second_) {
+                suppressed_.fetch_add(1, util::lock::memory_order_relaxed);
+                return false;
+            }
+
+            if (0 != suppressed_.load(util::lock::memory_order_relaxed)) {
+                suppressed = suppressed_.exchange(0, util::lock::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        log_sampler::log_sampler(uint32_t every_n) : every_n_(every_n <= 1 ? 1 : every_n) {
+            count_.store(0, util::lock::memory_order_relaxed);
+        }
+
+        bool log_sampler::check() {
+            if (1 == every_n_) {
+                return true;
+            }
+
+            return 0 == count_.fetch_add(1, util::lock::memory_order_relaxed) % every_n_;
+        }
+    }
+}
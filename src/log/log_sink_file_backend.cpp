@@ -1,243 +1,994 @@
-﻿#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-
-#include <iostream>
-#include <sstream>
-
-#include "lock/lock_holder.h"
-#include "common/file_system.h"
-#include "time/time_utility.h"
-
-#include "log/log_sink_file_backend.h"
-
-// 默认文件大小是256KB
-#define DEFAULT_FILE_SIZE 256 * 1024
-
-namespace util {
-    namespace log {
-
-        log_sink_file_backend::log_sink_file_backend()
-            : rotation_size_(10),    // 默认10个文件
-            max_file_size_(DEFAULT_FILE_SIZE), // 默认文件大小
-            check_interval_(60), // 默认文件切换检查周期为60秒
-            check_expire_point_(0), inited_(false) {
-
-            path_pattern_ = "%Y-%m-%d.%N.log";// 默认文件名规则
-
-            log_file_.auto_flush = false;
-            log_file_.rotation_index = 0;
-            log_file_.written_size = 0;
-        }
-
-        log_sink_file_backend::log_sink_file_backend(const std::string &file_name_pattern)
-            : rotation_size_(10),    // 默认10个文件
-            max_file_size_(DEFAULT_FILE_SIZE), // 默认文件大小
-            check_interval_(60), // 默认文件切换检查周期为60秒
-            check_expire_point_(0), inited_(false) {
-
-            log_file_.auto_flush = false;
-            log_file_.rotation_index = 0;
-            log_file_.written_size = 0;
-
-            set_file_pattern(file_name_pattern);
-        }
-
-        log_sink_file_backend::log_sink_file_backend(const log_sink_file_backend& other)
-            : rotation_size_(other.rotation_size_),     // 默认文件数量
-            max_file_size_(other.max_file_size_),       // 默认文件大小
-            check_interval_(other.check_interval_),     // 默认文件切换检查周期为60秒
-            check_expire_point_(0), inited_(false) {
-            path_pattern_ = other.path_pattern_;
-
-            log_file_.auto_flush = other.log_file_.auto_flush;
-
-            // 其他的部分都要重新初始化，不能复制
-        }
-
-        log_sink_file_backend::~log_sink_file_backend() {}
-
-        void log_sink_file_backend::set_file_pattern(const std::string &file_name_pattern) {
-            path_pattern_ = file_name_pattern;
-
-            // 设置文件路径模式， 如果文件已打开，需要重新执行初始化流程
-            if (log_file_.opened_file) {
-                inited_ = false;
-                init();
-            }
-        }
-
-        void log_sink_file_backend::operator()(const log_formatter::caller_info_t &caller, const char *content, size_t content_size) {
-            if (!inited_) {
-                init();
-            }
-            
-            if (log_file_.written_size > 0 && log_file_.written_size >= max_file_size_) {
-                rotate_log();
-            }
-            check_update();
-
-            std::shared_ptr<std::ofstream> f = open_log_file(true);
-
-            if (!f) {
-                return;
-            }
-
-            f->write(content, content_size);
-            f->put('\n');
-            if (log_file_.auto_flush) {
-                f->flush();
-            }
-
-            log_file_.written_size += content_size + 1;
-        }
-
-        void log_sink_file_backend::init() {
-            if (inited_) {
-                return;
-            }
-
-            inited_ = true;
-
-            check_expire_point_ = 0;
-            log_file_.rotation_index = 0;
-            reset_log_file();
-
-            log_formatter::caller_info_t caller;
-            char log_file[file_system::MAX_PATH_LEN];
-
-            for (size_t i = 0; max_file_size_ > 0 && i < rotation_size_; ++i) {
-                caller.rotate_index = (log_file_.rotation_index + i) % rotation_size_;
-                size_t fsz = 0;
-                log_formatter::format(log_file, sizeof(log_file), path_pattern_.c_str(), path_pattern_.size(), caller);
-                file_system::file_size(log_file, fsz);
-
-                // 文件不存在fsz也是0
-                if (fsz < max_file_size_) {
-                    log_file_.rotation_index = caller.rotate_index;
-                    break;
-                }
-            }
-
-            open_log_file(false);
-        }
-
-        std::shared_ptr<std::ofstream> log_sink_file_backend::open_log_file(bool destroy_content) {
-            if (log_file_.opened_file && log_file_.opened_file->good()) {
-                return log_file_.opened_file;
-            }
-
-            reset_log_file();
-
-            // 打开新文件要加锁
-            lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
-
-            char log_file[file_system::MAX_PATH_LEN];
-            log_formatter::caller_info_t caller;
-            caller.rotate_index = log_file_.rotation_index;
-            size_t file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_.c_str(), path_pattern_.size(), caller);
-            if (file_path_len <= 0) {
-                std::cerr << "log.format " << path_pattern_ << " failed"<< std::endl;
-                return std::shared_ptr<std::ofstream>();
-            }
-
-            std::shared_ptr<std::ofstream> of = std::make_shared<std::ofstream>();
-            if (!of) {
-                std::cerr << "log.file malloc failed" << path_pattern_ << std::endl;
-                return std::shared_ptr<std::ofstream>();
-            }
-
-            std::string dir_name;
-            util::file_system::dirname(log_file, file_path_len, dir_name);
-            if (!dir_name.empty() && !util::file_system::is_exist(dir_name.c_str())) {
-                util::file_system::mkdir(dir_name.c_str(), true);
-            }
-
-            // 销毁原先的内容
-            if (destroy_content) {
-                of->open(log_file, std::ios::binary | std::ios::out | std::ios::trunc);
-                if (!of->is_open()) {
-                    std::cerr << "log.file open " << static_cast<const char*>(log_file) << " failed" << path_pattern_ << std::endl;
-                    return std::shared_ptr<std::ofstream>();
-                }
-                of->close();
-            }
-
-            of->open(log_file, std::ios::binary | std::ios::out | std::ios::app);
-            if (!of->is_open()) {
-                std::cerr << "log.file open "<< static_cast<const char*>(log_file) <<" failed" << path_pattern_ << std::endl;
-                return std::shared_ptr<std::ofstream>();
-            }
-
-            of->seekp(0, std::ios_base::end);
-            log_file_.written_size = static_cast<size_t>(of->tellp());
-
-            log_file_.opened_file = of;
-            log_file_.file_path.assign(log_file, file_path_len);
-            return log_file_.opened_file;
-        }
-
-        void log_sink_file_backend::rotate_log() {
-            if (rotation_size_ > 0) {
-                log_file_.rotation_index = (log_file_.rotation_index + 1) % rotation_size_;
-            } else {
-                log_file_.rotation_index = 0;
-            }
-            reset_log_file();
-            check_expire_point_ = 0;
-        }
-
-        void log_sink_file_backend::check_update() {
-            if (0 != check_expire_point_) {
-                if (0 == check_interval_ || util::time::time_utility::get_now() < check_expire_point_) {
-                    return;
-                }
-            }
-
-            check_expire_point_ = util::time::time_utility::get_now() + check_interval_;
-            char log_file[file_system::MAX_PATH_LEN];
-            log_formatter::caller_info_t caller;
-            caller.rotate_index = log_file_.rotation_index;
-            size_t file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_.c_str(), path_pattern_.size(), caller);
-            if (file_path_len <= 0) {
-                return;
-            }
-
-            std::string new_file_path;
-            std::string old_file_path;
-
-            {
-                // 短时间加锁，防止文件路径变更
-                lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
-                old_file_path = log_file_.file_path;
-            }
-
-            new_file_path.assign(log_file, file_path_len);
-            if (new_file_path == old_file_path) {
-                return;
-            }
-
-            std::string new_dir;
-            std::string old_dir;
-            util::file_system::dirname(new_file_path.c_str(), new_file_path.size(), new_dir);
-            util::file_system::dirname(old_file_path.c_str(), old_file_path.size(), old_dir);
-
-            // 如果目录变化则重置序号
-            if (new_dir != old_dir) {
-                log_file_.rotation_index = 0;
-            }
-
-            reset_log_file();
-        }
-
-        void log_sink_file_backend::reset_log_file() {
-            // 更换日志文件需要加锁
-            lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
-
-            // 必须依赖析构来关闭文件，以防这个文件正在其他地方被引用
-            log_file_.opened_file.reset();
-            log_file_.written_size = 0;
-            //log_file_.file_path.clear(); // 保留上一个文件路径，即便已被关闭。用于rotate后的目录变更判定
-        }
-    }
-}
+﻿#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <errno.h>
+
+#include "config/atframe_utils_build_feature.h"
+
+#include "common/compiler_message.h"
+#include "lock/lock_holder.h"
+#include "common/file_system.h"
+#include "std/chrono.h"
+#include "time/time_utility.h"
+
+#include "log/log_background_worker.h"
+#include "log/log_sink_file_backend.h"
+
+#if defined(LOG_SINK_ENABLE_ZLIB) && LOG_SINK_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef UTIL_FS_WINDOWS_API
+#include <sys/stat.h>
+#define LOG_SINK_FILE_OPEN(path, flags) ::_open(path, (flags) | _O_BINARY, _S_IREAD | _S_IWRITE)
+#define LOG_SINK_FILE_WRITE(fd, buf, sz) ::_write(fd, buf, static_cast<unsigned int>(sz))
+#define LOG_SINK_FILE_CLOSE(fd) ::_close(fd)
+#define LOG_SINK_FILE_SEEK_END(fd) ::_lseeki64(fd, 0, SEEK_END)
+#define LOG_SINK_FILE_TRUNCATE(fd) ::_chsize_s(fd, 0)
+#define LOG_SINK_FILE_O_WRONLY _O_WRONLY
+#define LOG_SINK_FILE_O_CREAT _O_CREAT
+#define LOG_SINK_FILE_O_APPEND _O_APPEND
+#define LOG_SINK_FILE_O_TRUNC _O_TRUNC
+#else
+#include <sys/file.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define LOG_SINK_FILE_SHARED_SUPPORTED 1
+#define LOG_SINK_FILE_OPEN(path, flags) ::open(path, flags, 0644)
+#define LOG_SINK_FILE_WRITE(fd, buf, sz) ::write(fd, buf, sz)
+#define LOG_SINK_FILE_CLOSE(fd) ::close(fd)
+#define LOG_SINK_FILE_SEEK_END(fd) ::lseek(fd, 0, SEEK_END)
+#define LOG_SINK_FILE_TRUNCATE(fd) ::ftruncate(fd, 0)
+#define LOG_SINK_FILE_O_WRONLY O_WRONLY
+#define LOG_SINK_FILE_O_CREAT O_CREAT
+#define LOG_SINK_FILE_O_APPEND O_APPEND
+#define LOG_SINK_FILE_O_TRUNC O_TRUNC
+#endif
+
+// 默认文件大小是256KB
+#define DEFAULT_FILE_SIZE 256 * 1024
+
+// 后台线程预先创建文件时使用的临时文件后缀
+#define LOG_SINK_FILE_PREPARING_SUFFIX ".preparing"
+
+namespace util {
+    namespace log {
+        /**
+         * @brief 带用户态缓冲区的文件写出器，直接使用文件描述符，一次系统调用写出整块数据
+         * @note 多个线程可能同时写同一个后端，后台线程也会定时写出，操作缓冲区的接口都要加锁
+         */
+        struct log_sink_file_backend::file_writer_t {
+            lock::spin_lock lock;
+            int fd;
+            std::vector<char> buffer;
+            size_t used;
+            std::chrono::steady_clock::time_point last_flush;
+            // 不为空时，最后一个引用释放、文件关闭后在后台线程中把这个文件压缩成compress_dst_path
+            std::string compress_src_path;
+            std::string compress_dst_path;
+
+            file_writer_t() : fd(-1), used(0), last_flush(std::chrono::steady_clock::now()) {}
+
+            ~file_writer_t();
+
+            bool open(const char *path, bool truncate, size_t buffer_size) {
+                close();
+
+                int flags = LOG_SINK_FILE_O_WRONLY | LOG_SINK_FILE_O_CREAT | LOG_SINK_FILE_O_APPEND;
+                if (truncate) {
+                    flags |= LOG_SINK_FILE_O_TRUNC;
+                }
+
+                fd = LOG_SINK_FILE_OPEN(path, flags);
+                if (fd < 0) {
+                    return false;
+                }
+
+                buffer.resize(buffer_size);
+                used = 0;
+                last_flush = std::chrono::steady_clock::now();
+                return true;
+            }
+
+            void close() {
+                lock::lock_holder<lock::spin_lock> lkholder(lock);
+                if (fd < 0) {
+                    return;
+                }
+
+                flush_buffer();
+                LOG_SINK_FILE_CLOSE(fd);
+                fd = -1;
+            }
+
+            inline bool good() const { return fd >= 0; }
+
+            // 清空文件内容
+            bool truncate() {
+                lock::lock_holder<lock::spin_lock> lkholder(lock);
+                used = 0;
+                return fd >= 0 && 0 == LOG_SINK_FILE_TRUNCATE(fd);
+            }
+
+            size_t file_size() const {
+                if (fd < 0) {
+                    return 0;
+                }
+
+                long long ret = static_cast<long long>(LOG_SINK_FILE_SEEK_END(fd));
+                return ret > 0 ? static_cast<size_t>(ret) : 0;
+            }
+
+            bool write_direct(const char *data, size_t sz) {
+                while (sz > 0 && fd >= 0) {
+                    long long res = static_cast<long long>(LOG_SINK_FILE_WRITE(fd, data, sz));
+                    if (res < 0) {
+                        if (EINTR == errno) {
+                            continue;
+                        }
+                        return false;
+                    }
+
+                    data += res;
+                    sz -= static_cast<size_t>(res);
+                }
+
+                return 0 == sz;
+            }
+
+            // 一次系统调用写出一行，共享模式下不会和其他进程的日志交错
+            bool write_direct_line(const char *content, size_t content_size) {
+#if defined(LOG_SINK_FILE_SHARED_SUPPORTED) && LOG_SINK_FILE_SHARED_SUPPORTED
+                struct iovec iov[2];
+                iov[0].iov_base = const_cast<char *>(content);
+                iov[0].iov_len = content_size;
+                iov[1].iov_base = const_cast<char *>("\n");
+                iov[1].iov_len = 1;
+
+                ssize_t res;
+                do {
+                    res = ::writev(fd, iov, 2);
+                } while (res < 0 && EINTR == errno);
+
+                if (res < 0) {
+                    return false;
+                }
+
+                // 只写出部分时继续写剩下的部分
+                size_t written = static_cast<size_t>(res);
+                if (written < content_size) {
+                    return write_direct(content + written, content_size - written) && write_direct("\n", 1);
+                } else if (written == content_size) {
+                    return write_direct("\n", 1);
+                }
+                return true;
+#else
+                return write_direct(content, content_size) && write_direct("\n", 1);
+#endif
+            }
+
+            bool flush() {
+                lock::lock_holder<lock::spin_lock> lkholder(lock);
+                return flush_buffer();
+            }
+
+            /**
+             * @brief 写入一行日志，会自动追加换行符
+             * @param auto_flush 是否写入后马上写出缓冲区
+             * @param interval_ms 缓冲区数据最大停留时间，超过时写出
+             * @param pending 输出写入后缓冲区中还没有写出的数据长度
+             */
+            bool write_line(const char *content, size_t content_size, bool auto_flush, time_t interval_ms, size_t &pending) {
+                lock::lock_holder<lock::spin_lock> lkholder(lock);
+                bool ret = append_line(content, content_size);
+                if (ret && auto_flush) {
+                    ret = flush_buffer();
+                } else if (ret && used > 0 && interval_ms > 0 &&
+                           std::chrono::steady_clock::now() - last_flush >= std::chrono::milliseconds(interval_ms)) {
+                    ret = flush_buffer();
+                }
+
+                pending = used;
+                return ret;
+            }
+
+        private:
+            // 以下接口调用前需要持有lock
+            bool flush_buffer() {
+                last_flush = std::chrono::steady_clock::now();
+                if (0 == used) {
+                    return true;
+                }
+
+                bool ret = write_direct(&buffer[0], used);
+                used = 0;
+                return ret;
+            }
+
+            bool append_line(const char *content, size_t content_size) {
+                if (buffer.size() - used < content_size + 1) {
+                    if (!flush_buffer()) {
+                        return false;
+                    }
+
+                    // 超过缓冲区大小的日志直接写出
+                    if (buffer.size() < content_size + 1) {
+                        return write_direct_line(content, content_size);
+                    }
+                }
+
+                if (content_size > 0) {
+                    memcpy(&buffer[used], content, content_size);
+                }
+                buffer[used + content_size] = '\n';
+                used += content_size + 1;
+                return true;
+            }
+        };
+
+        /**
+         * @brief 后台线程预先打开的下一个轮转文件
+         */
+        struct log_sink_file_backend::prepared_file_t {
+            lock::spin_lock lock;
+            std::string file_path; // 正在或已经预先打开的文件路径
+            std::string temp_path; // 预先创建的临时文件，切换时改名为file_path，为空表示直接打开的file_path
+            uint64_t sequence;     // 每次请求或取走后递增，后台任务完成时序号不一致说明已经被替换
+            file_writer_ptr_t writer;
+
+            prepared_file_t() : sequence(0) {}
+        };
+
+        namespace detail {
+            // 关闭预先打开但没有使用的文件，并删除临时文件
+            static void log_sink_file_backend_discard_file(log_sink_file_backend::file_writer_ptr_t writer, const std::string &temp_path) {
+                if (writer) {
+                    writer->close();
+                }
+
+                if (!temp_path.empty()) {
+                    util::file_system::remove(temp_path.c_str());
+                }
+            }
+
+            static void log_sink_file_backend_async_discard(log_sink_file_backend::file_writer_ptr_t &writer, std::string &temp_path) {
+                if (!writer && temp_path.empty()) {
+                    return;
+                }
+
+                if (!log_background_worker::post(std::bind(log_sink_file_backend_discard_file, writer, temp_path))) {
+                    log_sink_file_backend_discard_file(writer, temp_path);
+                }
+                writer.reset();
+                temp_path.clear();
+            }
+
+            static void log_sink_file_backend_prepare_file(std::shared_ptr<log_sink_file_backend::prepared_file_t> prepared,
+                                                           const std::string &file_path, uint64_t sequence, size_t buffer_size,
+                                                           bool create) {
+                {
+                    lock::lock_holder<lock::spin_lock> lkholder(prepared->lock);
+                    if (prepared->sequence != sequence) {
+                        return;
+                    }
+                }
+
+                log_sink_file_backend::file_writer_ptr_t writer = std::make_shared<log_sink_file_backend::file_writer_t>();
+                if (!writer) {
+                    return;
+                }
+
+                std::string temp_path;
+                if (create) {
+                    std::string dir_name;
+                    util::file_system::dirname(file_path.c_str(), file_path.size(), dir_name);
+                    if (!dir_name.empty() && !util::file_system::is_exist(dir_name.c_str())) {
+                        util::file_system::mkdir(dir_name.c_str(), true);
+                    }
+
+                    // 不能直接清空file_path，切换到这个文件之前它还是一个有效的历史日志
+                    temp_path = file_path + LOG_SINK_FILE_PREPARING_SUFFIX;
+                    if (!writer->open(temp_path.c_str(), true, buffer_size)) {
+                        return;
+                    }
+                } else {
+                    if (!util::file_system::is_exist(file_path.c_str()) || !writer->open(file_path.c_str(), false, buffer_size)) {
+                        return;
+                    }
+                }
+
+                {
+                    lock::lock_holder<lock::spin_lock> lkholder(prepared->lock);
+                    if (prepared->sequence == sequence) {
+                        prepared->writer.swap(writer);
+                        prepared->temp_path.swap(temp_path);
+                        return;
+                    }
+                }
+
+                // 准备期间已经被替换或取走
+                log_sink_file_backend_discard_file(writer, temp_path);
+            }
+
+            static void log_sink_file_backend_release_file(log_sink_file_backend::file_writer_ptr_t) {}
+
+            // 定时写出缓冲区，文件关闭或释放后移除定时任务
+            static bool log_sink_file_backend_flush_timer(std::weak_ptr<log_sink_file_backend::file_writer_t> writer) {
+                log_sink_file_backend::file_writer_ptr_t f = writer.lock();
+                if (!f || !f->good()) {
+                    return false;
+                }
+
+                f->flush();
+                return true;
+            }
+
+#if defined(LOG_SINK_FILE_SHARED_SUPPORTED) && LOG_SINK_FILE_SHARED_SUPPORTED
+            // lock文件的前4个字节记录当前的轮转序号
+            static bool log_sink_file_backend_read_shared_index(int fd, uint32_t &index) {
+                ssize_t res;
+                do {
+                    res = ::pread(fd, &index, sizeof(index), 0);
+                } while (res < 0 && EINTR == errno);
+
+                return res == static_cast<ssize_t>(sizeof(index));
+            }
+
+            static bool log_sink_file_backend_write_shared_index(int fd, uint32_t index) {
+                ssize_t res;
+                do {
+                    res = ::pwrite(fd, &index, sizeof(index), 0);
+                } while (res < 0 && EINTR == errno);
+
+                return res == static_cast<ssize_t>(sizeof(index));
+            }
+
+            static void log_sink_file_backend_lock_shared(int fd, bool lock) {
+                while (0 != ::flock(fd, lock ? LOCK_EX : LOCK_UN) && EINTR == errno) {
+                }
+            }
+#endif
+
+            // 在后台线程中写出缓冲区并关闭文件
+            static void log_sink_file_backend_async_release(log_sink_file_backend::file_writer_ptr_t &writer) {
+                if (!writer) {
+                    return;
+                }
+
+                if (log_background_worker::post(std::bind(log_sink_file_backend_release_file, writer))) {
+                    writer.reset();
+                }
+            }
+
+            // 流式压缩，不会把整个文件读进内存
+            static bool log_sink_file_backend_gzip_file(const std::string &src_path, const std::string &dst_path) {
+#if defined(LOG_SINK_ENABLE_ZLIB) && LOG_SINK_ENABLE_ZLIB
+                FILE *src = NULL;
+                UTIL_FS_OPEN(src_err, src, src_path.c_str(), "rb");
+                COMPILER_UNUSED(src_err);
+                if (NULL == src) {
+                    return false;
+                }
+
+                gzFile dst = gzopen(dst_path.c_str(), "wb");
+                if (NULL == dst) {
+                    fclose(src);
+                    return false;
+                }
+
+                bool ret = true;
+                char buffer[64 * 1024];
+                while (ret) {
+                    size_t read_sz = fread(buffer, 1, sizeof(buffer), src);
+                    if (read_sz > 0 && gzwrite(dst, buffer, static_cast<unsigned int>(read_sz)) != static_cast<int>(read_sz)) {
+                        ret = false;
+                    }
+
+                    if (read_sz < sizeof(buffer)) {
+                        ret = ret && 0 == ferror(src);
+                        break;
+                    }
+                }
+
+                fclose(src);
+                if (Z_OK != gzclose(dst)) {
+                    ret = false;
+                }
+
+                if (!ret) {
+                    util::file_system::remove(dst_path.c_str());
+                }
+                return ret;
+#else
+                COMPILER_UNUSED(&src_path);
+                COMPILER_UNUSED(&dst_path);
+                return false;
+#endif
+            }
+
+            // 在后台线程中压缩已经关闭的旧文件
+            static void log_sink_file_backend_compress_file(const std::string &src_path, const std::string &dst_path) {
+                if (log_sink_file_backend_gzip_file(src_path, dst_path)) {
+                    util::file_system::remove(src_path.c_str());
+                } else {
+                    // 压缩失败时保留原文件内容
+                    util::file_system::rename(src_path.c_str(), (src_path + ".failed").c_str());
+                }
+            }
+        }
+
+        log_sink_file_backend::file_writer_t::~file_writer_t() {
+            close();
+
+            // 同步写出时其他线程可能还持有这个文件，所以压缩要等到最后一个引用释放之后
+            if (!compress_src_path.empty()) {
+                if (!log_background_worker::post(
+                        std::bind(detail::log_sink_file_backend_compress_file, compress_src_path, compress_dst_path))) {
+                    detail::log_sink_file_backend_compress_file(compress_src_path, compress_dst_path);
+                }
+            }
+        }
+
+        log_sink_file_backend::log_sink_file_backend()
+            : rotation_size_(10),    // 默认10个文件
+            max_file_size_(DEFAULT_FILE_SIZE), // 默认文件大小
+            check_interval_(60), // 默认文件切换检查周期为60秒
+            check_expire_point_(0), buffer_size_(LOG_SINK_FILE_BACKEND_BUFFER_SIZE),
+            flush_interval_(1000), // 默认缓冲区内的数据最多停留1秒
+            compress_(false), shared_(false), inited_(false), shared_lock_fd_(-1) {
+
+            path_pattern_.compile("%Y-%m-%d.%N.log");// 默认文件名规则
+            prepared_file_ = std::make_shared<prepared_file_t>();
+
+            log_file_.auto_flush = false;
+            log_file_.rotation_index = 0;
+            log_file_.written_size.store(0, util::lock::memory_order_relaxed);
+        }
+
+        log_sink_file_backend::log_sink_file_backend(const std::string &file_name_pattern)
+            : rotation_size_(10),    // 默认10个文件
+            max_file_size_(DEFAULT_FILE_SIZE), // 默认文件大小
+            check_interval_(60), // 默认文件切换检查周期为60秒
+            check_expire_point_(0), buffer_size_(LOG_SINK_FILE_BACKEND_BUFFER_SIZE),
+            flush_interval_(1000), // 默认缓冲区内的数据最多停留1秒
+            compress_(false), shared_(false), inited_(false), shared_lock_fd_(-1) {
+
+            log_file_.auto_flush = false;
+            log_file_.rotation_index = 0;
+            log_file_.written_size.store(0, util::lock::memory_order_relaxed);
+            prepared_file_ = std::make_shared<prepared_file_t>();
+
+            set_file_pattern(file_name_pattern);
+        }
+
+        log_sink_file_backend::log_sink_file_backend(const log_sink_file_backend& other)
+            : rotation_size_(other.rotation_size_),     // 默认文件数量
+            max_file_size_(other.max_file_size_),       // 默认文件大小
+            check_interval_(other.check_interval_),     // 默认文件切换检查周期为60秒
+            check_expire_point_(0), buffer_size_(other.buffer_size_), flush_interval_(other.flush_interval_),
+            compress_(other.compress_), shared_(other.shared_), inited_(false), shared_lock_fd_(-1) {
+            path_pattern_ = other.path_pattern_;
+
+            log_file_.auto_flush = other.log_file_.auto_flush;
+            prepared_file_ = std::make_shared<prepared_file_t>();
+
+            // 其他的部分都要重新初始化，不能复制
+        }
+
+        log_sink_file_backend::~log_sink_file_backend() {
+            flush();
+            close_shared_lock();
+            discard_prepared_file();
+        }
+
+        void log_sink_file_backend::set_file_pattern(const std::string &file_name_pattern) {
+            path_pattern_.compile(file_name_pattern);
+            discard_prepared_file();
+
+            // 设置文件路径模式， 如果文件已打开，需要重新执行初始化流程
+            if (log_file_.opened_file) {
+                inited_ = false;
+                init();
+            }
+        }
+
+        void log_sink_file_backend::operator()(const log_formatter::caller_info_t &caller, const char *content, size_t content_size) {
+            if (!inited_) {
+                init();
+            }
+            
+            size_t written_size = log_file_.written_size.load(util::lock::memory_order_relaxed);
+            if (written_size > 0 && written_size >= max_file_size_) {
+                rotate_log();
+            }
+            check_update();
+
+            // 共享模式下只有执行轮转的进程在文件锁内清空文件
+            file_writer_ptr_t f = open_log_file(!shared_);
+
+            if (!f) {
+                return;
+            }
+
+            size_t pending = 0;
+            f->write_line(content, content_size, log_file_.auto_flush, flush_interval_, pending);
+
+            size_t new_written_size;
+            if (shared_ && 0 == pending) {
+                // 其他进程也在写这个文件，写出后以文件的实际大小为准
+                new_written_size = f->file_size();
+                written_size = log_file_.written_size.exchange(new_written_size, util::lock::memory_order_relaxed);
+            } else {
+                written_size = log_file_.written_size.fetch_add(content_size + 1, util::lock::memory_order_relaxed);
+                new_written_size = written_size + content_size + 1;
+            }
+
+            // 写过3/4后再预先打开下一个文件，只有越过这个位置的那次写入会触发
+            size_t prepare_size = max_file_size_ - max_file_size_ / 4;
+            if (written_size < prepare_size && new_written_size >= prepare_size) {
+                prepare_next_file();
+            }
+        }
+
+        void log_sink_file_backend::flush() {
+            file_writer_ptr_t f;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
+                f = log_file_.opened_file;
+            }
+
+            if (f) {
+                f->flush();
+            }
+        }
+
+        bool log_sink_file_backend::is_shared_supported() {
+#if defined(LOG_SINK_FILE_SHARED_SUPPORTED) && LOG_SINK_FILE_SHARED_SUPPORTED
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        bool log_sink_file_backend::is_compress_supported() {
+#if defined(LOG_SINK_ENABLE_ZLIB) && LOG_SINK_ENABLE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void log_sink_file_backend::init() {
+            if (inited_) {
+                return;
+            }
+
+            inited_ = true;
+
+            check_expire_point_ = 0;
+            log_file_.rotation_index = 0;
+            reset_log_file();
+
+            log_formatter::caller_info_t caller;
+            char log_file[file_system::MAX_PATH_LEN];
+
+            for (size_t i = 0; max_file_size_ > 0 && i < rotation_size_; ++i) {
+                caller.rotate_index = (log_file_.rotation_index + i) % rotation_size_;
+                size_t fsz = 0;
+                log_formatter::format(log_file, sizeof(log_file), path_pattern_, caller);
+                file_system::file_size(log_file, fsz);
+
+                // 文件不存在fsz也是0
+                if (fsz < max_file_size_) {
+                    log_file_.rotation_index = caller.rotate_index;
+                    break;
+                }
+            }
+
+            open_log_file(false);
+        }
+
+        log_sink_file_backend::file_writer_ptr_t log_sink_file_backend::open_log_file(bool destroy_content) {
+            if (log_file_.opened_file && log_file_.opened_file->good()) {
+                return log_file_.opened_file;
+            }
+
+            reset_log_file();
+
+            if (shared_) {
+                sync_shared_index();
+            }
+
+            // 打开新文件要加锁
+            lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
+
+            char log_file[file_system::MAX_PATH_LEN];
+            log_formatter::caller_info_t caller;
+            caller.rotate_index = log_file_.rotation_index;
+            size_t file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_, caller);
+            if (file_path_len <= 0) {
+                std::cerr << "log.format " << path_pattern_.get_source() << " failed"<< std::endl;
+                return file_writer_ptr_t();
+            }
+
+            // 优先使用后台线程预先打开的文件
+            file_writer_ptr_t of;
+            std::string temp_path;
+            {
+                lock::lock_holder<lock::spin_lock> prepared_lkholder(prepared_file_->lock);
+                if (prepared_file_->file_path == log_file) {
+                    of.swap(prepared_file_->writer);
+                    temp_path.swap(prepared_file_->temp_path);
+                    prepared_file_->file_path.clear();
+                    ++prepared_file_->sequence;
+                }
+            }
+
+            if (of && of->good()) {
+                if (!temp_path.empty()) {
+                    // 预先创建的是空文件，改名替换原来的文件就相当于销毁原先的内容
+                    if (destroy_content && util::file_system::rename(temp_path.c_str(), log_file)) {
+                        temp_path.clear();
+                    } else {
+                        detail::log_sink_file_backend_async_discard(of, temp_path);
+                    }
+                } else if (destroy_content) {
+                    // 直接打开的已有文件不在这里清空
+                    detail::log_sink_file_backend_async_discard(of, temp_path);
+                }
+            } else {
+                detail::log_sink_file_backend_async_discard(of, temp_path);
+            }
+
+            if (!of) {
+                of = std::make_shared<file_writer_t>();
+                if (!of) {
+                    std::cerr << "log.file malloc failed" << path_pattern_.get_source() << std::endl;
+                    return file_writer_ptr_t();
+                }
+
+                std::string dir_name;
+                util::file_system::dirname(log_file, file_path_len, dir_name);
+                if (!dir_name.empty() && !util::file_system::is_exist(dir_name.c_str())) {
+                    util::file_system::mkdir(dir_name.c_str(), true);
+                }
+
+                // 销毁原先的内容
+                if (!of->open(log_file, destroy_content, buffer_size_)) {
+                    std::cerr << "log.file open "<< static_cast<const char*>(log_file) <<" failed" << path_pattern_.get_source() << std::endl;
+                    return file_writer_ptr_t();
+                }
+            }
+
+            log_file_.written_size.store(of->file_size(), util::lock::memory_order_relaxed);
+
+            log_file_.opened_file = of;
+            log_file_.file_path.assign(log_file, file_path_len);
+
+            // 没有新日志时也要在flush_interval_内写出缓冲区
+            if (!log_file_.auto_flush && flush_interval_ > 0 && buffer_size_ > 0) {
+                log_background_worker::add_timer(std::bind(detail::log_sink_file_backend_flush_timer, std::weak_ptr<file_writer_t>(of)),
+                                                 flush_interval_);
+            }
+
+            return log_file_.opened_file;
+        }
+
+        void log_sink_file_backend::prepare_next_file() {
+            if (rotation_size_ <= 1 || max_file_size_ == 0) {
+                return;
+            }
+
+            lock::lock_holder<lock::spin_lock> fs_lkholder(fs_lock_);
+
+            char log_file[file_system::MAX_PATH_LEN];
+            log_formatter::caller_info_t caller;
+            caller.rotate_index = (log_file_.rotation_index + 1) % rotation_size_;
+            size_t file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_, caller);
+            if (file_path_len <= 0) {
+                return;
+            }
+
+            prepare_file(log_file, file_path_len);
+        }
+
+        void log_sink_file_backend::prepare_file(const char *file_path, size_t file_path_len) {
+            file_writer_ptr_t stale_writer;
+            std::string stale_temp_path;
+            uint64_t sequence;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(prepared_file_->lock);
+                if (prepared_file_->file_path == file_path) {
+                    return;
+                }
+
+                prepared_file_->file_path.assign(file_path, file_path_len);
+                sequence = ++prepared_file_->sequence;
+                stale_writer.swap(prepared_file_->writer);
+                stale_temp_path.swap(prepared_file_->temp_path);
+            }
+
+            // 后台线程按顺序执行任务，旧的临时文件会在重新准备同一个路径之前被删除
+            detail::log_sink_file_backend_async_discard(stale_writer, stale_temp_path);
+
+            log_background_worker::post(std::bind(detail::log_sink_file_backend_prepare_file, prepared_file_,
+                                                  std::string(file_path, file_path_len), sequence, buffer_size_, !shared_));
+        }
+
+        void log_sink_file_backend::discard_prepared_file() {
+            if (!prepared_file_) {
+                return;
+            }
+
+            file_writer_ptr_t writer;
+            std::string temp_path;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(prepared_file_->lock);
+                prepared_file_->file_path.clear();
+                ++prepared_file_->sequence;
+                writer.swap(prepared_file_->writer);
+                temp_path.swap(prepared_file_->temp_path);
+            }
+
+            detail::log_sink_file_backend_async_discard(writer, temp_path);
+        }
+
+        void log_sink_file_backend::rotate_log() {
+            if (shared_) {
+                rotate_shared_log();
+                return;
+            }
+
+            if (compress_) {
+                compress_current_file();
+            }
+
+            if (rotation_size_ > 0) {
+                log_file_.rotation_index = (log_file_.rotation_index + 1) % rotation_size_;
+            } else {
+                log_file_.rotation_index = 0;
+            }
+
+            // 轮转回同一个文件时直接清空，旧的缓冲区一起丢弃，不需要等后台线程写完再重新打开
+            if (!compress_ && truncate_same_file()) {
+                check_expire_point_ = 0;
+                return;
+            }
+
+            reset_log_file();
+            check_expire_point_ = 0;
+        }
+
+        bool log_sink_file_backend::truncate_same_file() {
+            lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
+            if (!log_file_.opened_file || !log_file_.opened_file->good()) {
+                return false;
+            }
+
+            char log_file[file_system::MAX_PATH_LEN];
+            log_formatter::caller_info_t caller;
+            caller.rotate_index = log_file_.rotation_index;
+            size_t file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_, caller);
+            if (file_path_len <= 0 || log_file_.file_path != log_file) {
+                return false;
+            }
+
+            if (!log_file_.opened_file->truncate()) {
+                return false;
+            }
+
+            log_file_.written_size.store(0, util::lock::memory_order_relaxed);
+            return true;
+        }
+
+        void log_sink_file_backend::rotate_shared_log() {
+            uint32_t next_index = rotation_size_ > 0 ? (log_file_.rotation_index + 1) % rotation_size_ : 0;
+
+#if defined(LOG_SINK_FILE_SHARED_SUPPORTED) && LOG_SINK_FILE_SHARED_SUPPORTED
+            int lock_fd = open_shared_lock();
+            if (lock_fd >= 0) {
+                // 先写出自己的缓冲区，再按文件的实际大小判断是否需要轮转
+                flush();
+
+                detail::log_sink_file_backend_lock_shared(lock_fd, true);
+                uint32_t shared_index = 0;
+                if (!detail::log_sink_file_backend_read_shared_index(lock_fd, shared_index) || shared_index >= rotation_size_) {
+                    shared_index = log_file_.rotation_index;
+                }
+
+                next_index = shared_index;
+                // 其他进程已经轮转过时直接切换到新的序号
+                size_t fsz = 0;
+                if (shared_index == log_file_.rotation_index && file_system::file_size(log_file_.file_path.c_str(), fsz) &&
+                    fsz >= max_file_size_) {
+                    char log_file[file_system::MAX_PATH_LEN];
+                    log_formatter::caller_info_t caller;
+                    caller.rotate_index = rotation_size_ > 0 ? (shared_index + 1) % rotation_size_ : 0;
+                    size_t file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_, caller);
+
+                    // 在锁内清空下一个文件，其他进程切换过去时不再清空
+                    file_writer_t truncated_file;
+                    if (file_path_len > 0 && truncated_file.open(log_file, true, 0)) {
+                        truncated_file.close();
+                        next_index = caller.rotate_index;
+                        detail::log_sink_file_backend_write_shared_index(lock_fd, next_index);
+                    }
+                }
+                detail::log_sink_file_backend_lock_shared(lock_fd, false);
+            }
+#endif
+
+            log_file_.rotation_index = next_index;
+            reset_log_file();
+            check_expire_point_ = 0;
+        }
+
+        int log_sink_file_backend::open_shared_lock() {
+#if defined(LOG_SINK_FILE_SHARED_SUPPORTED) && LOG_SINK_FILE_SHARED_SUPPORTED
+            // lock文件放在第0个轮转文件旁边，路径规则中的时间变化时会换一个lock文件
+            const char lock_suffix[] = ".lock";
+            char lock_file[file_system::MAX_PATH_LEN];
+            log_formatter::caller_info_t caller;
+            caller.rotate_index = 0;
+            size_t file_path_len = log_formatter::format(lock_file, sizeof(lock_file) - sizeof(lock_suffix), path_pattern_, caller);
+            if (file_path_len <= 0) {
+                return -1;
+            }
+            memcpy(lock_file + file_path_len, lock_suffix, sizeof(lock_suffix));
+
+            if (shared_lock_fd_ >= 0 && shared_lock_path_ == lock_file) {
+                return shared_lock_fd_;
+            }
+
+            close_shared_lock();
+
+            std::string dir_name;
+            util::file_system::dirname(lock_file, file_path_len, dir_name);
+            if (!dir_name.empty() && !util::file_system::is_exist(dir_name.c_str())) {
+                util::file_system::mkdir(dir_name.c_str(), true);
+            }
+
+            shared_lock_fd_ = ::open(lock_file, O_RDWR | O_CREAT, 0644);
+            if (shared_lock_fd_ >= 0) {
+                shared_lock_path_ = lock_file;
+            } else {
+                std::cerr << "log.file open " << static_cast<const char *>(lock_file) << " failed" << std::endl;
+            }
+            return shared_lock_fd_;
+#else
+            return -1;
+#endif
+        }
+
+        void log_sink_file_backend::close_shared_lock() {
+#if defined(LOG_SINK_FILE_SHARED_SUPPORTED) && LOG_SINK_FILE_SHARED_SUPPORTED
+            if (shared_lock_fd_ >= 0) {
+                ::close(shared_lock_fd_);
+            }
+#endif
+            shared_lock_fd_ = -1;
+            shared_lock_path_.clear();
+        }
+
+        void log_sink_file_backend::sync_shared_index() {
+#if defined(LOG_SINK_FILE_SHARED_SUPPORTED) && LOG_SINK_FILE_SHARED_SUPPORTED
+            int lock_fd = open_shared_lock();
+            if (lock_fd < 0) {
+                return;
+            }
+
+            detail::log_sink_file_backend_lock_shared(lock_fd, true);
+            uint32_t shared_index = 0;
+            if (detail::log_sink_file_backend_read_shared_index(lock_fd, shared_index) && shared_index < rotation_size_) {
+                log_file_.rotation_index = shared_index;
+            } else {
+                detail::log_sink_file_backend_write_shared_index(lock_fd, log_file_.rotation_index);
+            }
+            detail::log_sink_file_backend_lock_shared(lock_fd, false);
+#endif
+        }
+
+        void log_sink_file_backend::compress_current_file() {
+            file_writer_ptr_t writer;
+            std::string file_path;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
+                if (!log_file_.opened_file || log_file_.file_path.empty()) {
+                    return;
+                }
+
+                file_path = log_file_.file_path;
+                // 先改名，之后轮转回这个路径时直接创建新文件，不需要等待压缩完成
+                // 已打开的文件描述符仍然指向改名后的文件，缓冲区里的数据也会写到改名后的文件里
+                std::string rotating_path = file_path + ".rotating";
+                if (!util::file_system::rename(file_path.c_str(), rotating_path.c_str())) {
+                    return;
+                }
+
+                // 在析构时压缩，这之前其他线程还能继续写入
+                log_file_.opened_file->compress_src_path.swap(rotating_path);
+                log_file_.opened_file->compress_dst_path = file_path + ".gz";
+                writer.swap(log_file_.opened_file);
+            }
+
+            detail::log_sink_file_backend_async_release(writer);
+        }
+
+        void log_sink_file_backend::check_update() {
+            if (0 != check_expire_point_) {
+                if (0 == check_interval_ || util::time::time_utility::get_now() < check_expire_point_) {
+                    return;
+                }
+            }
+
+            check_expire_point_ = util::time::time_utility::get_now() + check_interval_;
+            char log_file[file_system::MAX_PATH_LEN];
+            log_formatter::caller_info_t caller;
+            caller.rotate_index = log_file_.rotation_index;
+            size_t file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_, caller);
+            if (file_path_len <= 0) {
+                return;
+            }
+
+            std::string new_file_path;
+            std::string old_file_path;
+
+            {
+                // 短时间加锁，防止文件路径变更
+                lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
+                old_file_path = log_file_.file_path;
+            }
+
+            std::string new_dir;
+            std::string old_dir;
+            util::file_system::dirname(old_file_path.c_str(), old_file_path.size(), old_dir);
+
+            new_file_path.assign(log_file, file_path_len);
+            if (new_file_path == old_file_path) {
+                // 路径中有时间时，预先打开下一次检查时会切换到的文件，跨天之类的切换也只需要替换指针
+                if (0 != check_interval_ && path_pattern_.has_time_var()) {
+                    caller.log_time = check_expire_point_;
+                    file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_, caller);
+                    if (file_path_len > 0 && old_file_path != log_file) {
+                        util::file_system::dirname(log_file, file_path_len, new_dir);
+                        // 目录变化时序号会重置
+                        if (new_dir != old_dir && 0 != caller.rotate_index) {
+                            caller.rotate_index = 0;
+                            file_path_len = log_formatter::format(log_file, sizeof(log_file), path_pattern_, caller);
+                        }
+
+                        if (file_path_len > 0) {
+                            prepare_file(log_file, file_path_len);
+                        }
+                    }
+                }
+                return;
+            }
+
+            util::file_system::dirname(new_file_path.c_str(), new_file_path.size(), new_dir);
+
+            // 如果目录变化则重置序号
+            if (new_dir != old_dir) {
+                log_file_.rotation_index = 0;
+            }
+
+            reset_log_file();
+        }
+
+        void log_sink_file_backend::reset_log_file() {
+            // 更换日志文件需要加锁
+            lock::lock_holder<lock::spin_lock> lkholder(fs_lock_);
+
+            // 必须依赖析构来关闭文件，以防这个文件正在其他地方被引用，最后一个引用在后台线程中释放
+            detail::log_sink_file_backend_async_release(log_file_.opened_file);
+            log_file_.opened_file.reset();
+            log_file_.written_size.store(0, util::lock::memory_order_relaxed);
+            //log_file_.file_path.clear(); // 保留上一个文件路径，即便已被关闭。用于rotate后的目录变更判定
+        }
+    }
+}
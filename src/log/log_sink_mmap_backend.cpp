@@ -0,0 +1,782 @@
+﻿#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <iostream>
+#include <vector>
+
+#include "common/file_system.h"
+#include "lock/atomic_int_type.h"
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+#include "std/thread.h"
+
+#include "log/log_background_worker.h"
+#include "log/log_sink_mmap_backend.h"
+
+#ifdef UTIL_FS_WINDOWS_API
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+// 后台线程预先创建文件时使用的临时文件后缀
+#define LOG_SINK_MMAP_PREPARING_SUFFIX ".preparing"
+
+namespace util {
+    namespace log {
+        namespace detail {
+            // 文件尾部'\0'的长度，即剩余可写的空间
+            static size_t log_sink_mmap_get_free_size(const char *file_path) {
+                FILE *f = NULL;
+                UTIL_FS_OPEN(res, f, file_path, "rb");
+                if (NULL == f) {
+                    return 0;
+                }
+                (void)res;
+
+                size_t ret = 0;
+                char block[4096];
+                fseek(f, 0, SEEK_END);
+                long left = ftell(f);
+                while (left > 0) {
+                    long read_sz = left > static_cast<long>(sizeof(block)) ? static_cast<long>(sizeof(block)) : left;
+                    left -= read_sz;
+                    fseek(f, left, SEEK_SET);
+                    if (fread(block, 1, static_cast<size_t>(read_sz), f) != static_cast<size_t>(read_sz)) {
+                        break;
+                    }
+
+                    long i = read_sz;
+                    while (i > 0 && 0 == block[i - 1]) {
+                        --i;
+                    }
+                    ret += static_cast<size_t>(read_sz - i);
+                    if (i > 0) {
+                        break;
+                    }
+                }
+
+                fclose(f);
+                return ret;
+            }
+        }
+
+
+        struct log_sink_mmap_backend::mapping_t {
+            struct status_t {
+                enum type {
+                    EN_MMS_FREE = 0, // 未映射，可以复用
+                    EN_MMS_PENDING,  // 已投递到后台线程，还没开始打开
+                    EN_MMS_OPENING,  // 正在锁外打开
+                    EN_MMS_READY,    // 预先打开的下一个文件
+                    EN_MMS_CURRENT,  // 当前写入的文件
+                    EN_MMS_RETIRED,  // 已切换走，等待最后一个写入者离开后解除映射
+                    EN_MMS_CLOSING,  // 正在锁外解除映射
+                };
+            };
+
+            char *data;
+            size_t size;
+            util::lock::atomic_int_type<size_t> cursor;      // 下一次写入的位置，只增不减，可能超过size
+            util::lock::atomic_int_type<size_t> writers;     // 正在写入的线程数，不为0时不能解除映射
+            util::lock::atomic_int_type<uint32_t> generation; // 每次成为当前文件时更新，用于识别被复用的映射
+            std::string file_path;
+            status_t::type status; // 以下字段只在mapping_set_t::mapping_lock内访问
+            bool remove_on_close;  // 预先创建但没有用到的临时文件，解除映射后删除
+#ifdef UTIL_FS_WINDOWS_API
+            HANDLE file_handle;
+            HANDLE mapping_handle;
+#else
+            int fd;
+#endif
+
+            mapping_t() : data(NULL), size(0), status(status_t::EN_MMS_FREE), remove_on_close(false) {
+                cursor.store(0);
+                writers.store(0);
+                generation.store(0);
+#ifdef UTIL_FS_WINDOWS_API
+                file_handle = INVALID_HANDLE_VALUE;
+                mapping_handle = NULL;
+#else
+                fd = -1;
+#endif
+            }
+
+            ~mapping_t() { close(); }
+
+            bool open(const char *path, size_t sz, bool destroy_content) {
+                close();
+                file_path = path;
+                size = sz;
+
+                std::string dir_name;
+                util::file_system::dirname(file_path.c_str(), file_path.size(), dir_name);
+                if (!dir_name.empty() && !util::file_system::is_exist(dir_name.c_str())) {
+                    util::file_system::mkdir(dir_name.c_str(), true);
+                }
+
+#ifdef UTIL_FS_WINDOWS_API
+                file_handle = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                          destroy_content ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+                if (INVALID_HANDLE_VALUE == file_handle) {
+                    return false;
+                }
+
+                LARGE_INTEGER file_sz;
+                file_sz.QuadPart = static_cast<LONGLONG>(sz);
+                if (!SetFilePointerEx(file_handle, file_sz, NULL, FILE_BEGIN) || !SetEndOfFile(file_handle)) {
+                    close();
+                    return false;
+                }
+
+                mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READWRITE, file_sz.HighPart, file_sz.LowPart, NULL);
+                if (NULL == mapping_handle) {
+                    close();
+                    return false;
+                }
+
+                data = reinterpret_cast<char *>(MapViewOfFile(mapping_handle, FILE_MAP_ALL_ACCESS, 0, 0, sz));
+                if (NULL == data) {
+                    close();
+                    return false;
+                }
+#else
+                fd = ::open(path, O_RDWR | O_CREAT, 0644);
+                if (fd < 0) {
+                    return false;
+                }
+
+                // 先截断到0再扩展，保证新文件的内容都是'\0'
+                if ((destroy_content && 0 != ftruncate(fd, 0)) || 0 != ftruncate(fd, static_cast<off_t>(sz))) {
+                    close();
+                    return false;
+                }
+
+                void *addr = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (MAP_FAILED == addr) {
+                    close();
+                    return false;
+                }
+                data = reinterpret_cast<char *>(addr);
+#endif
+
+                // 已有的文件从最后一个非'\0'字符后开始写
+                size_t pos = 0;
+                if (!destroy_content) {
+                    pos = sz;
+                    while (pos > 0 && 0 == data[pos - 1]) {
+                        --pos;
+                    }
+                }
+                cursor.store(pos, util::lock::memory_order_release);
+                return true;
+            }
+
+            void flush() {
+                if (NULL == data) {
+                    return;
+                }
+
+#ifdef UTIL_FS_WINDOWS_API
+                FlushViewOfFile(data, 0);
+#else
+                msync(data, size, MS_ASYNC);
+#endif
+            }
+
+            void close() {
+#ifdef UTIL_FS_WINDOWS_API
+                if (NULL != data) {
+                    UnmapViewOfFile(data);
+                }
+                if (NULL != mapping_handle) {
+                    CloseHandle(mapping_handle);
+                    mapping_handle = NULL;
+                }
+                if (INVALID_HANDLE_VALUE != file_handle) {
+                    CloseHandle(file_handle);
+                    file_handle = INVALID_HANDLE_VALUE;
+                }
+#else
+                if (NULL != data) {
+                    munmap(data, size);
+                }
+                if (fd >= 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+#endif
+                data = NULL;
+
+                if (remove_on_close) {
+                    remove_on_close = false;
+                    util::file_system::remove(file_path.c_str());
+                }
+            }
+        };
+
+        /**
+         * @brief 一个后端的所有映射，后台任务也会持有
+         * @note 映射只在这里释放，写入者用mapping_t::writers标记正在使用，所以发布当前映射只需要一个原子指针
+         */
+        struct log_sink_mmap_backend::mapping_set_t {
+            lock::spin_lock mapping_lock;
+            util::lock::atomic_int_type<uintptr_t> current; // 当前写入的mapping_t，0表示还没有打开
+            std::vector<mapping_ptr_t> mappings;
+            mapping_t *prepared;     // 预先打开的下一个文件，file_path是临时文件，切换时改名
+            mapping_t *preparing;    // 已投递到后台线程，正在准备的下一个文件
+            uint32_t rotation_index; // 当前文件的轮转序号
+            uint32_t prepare_sequence;
+            uint32_t generation;
+            bool inited;
+            bool opening;         // 有写入者正在锁外打开当前文件
+            bool destroy_content; // 下一次打开当前文件时是否清空
+
+            mapping_set_t()
+                : prepared(NULL), preparing(NULL), rotation_index(0), prepare_sequence(0), generation(0), inited(false), opening(false),
+                  destroy_content(false) {
+                current.store(0);
+            }
+
+            // 以下接口都需要在mapping_lock内调用
+            mapping_t *alloc() {
+                for (size_t i = 0; i < mappings.size(); ++i) {
+                    if (mapping_t::status_t::EN_MMS_FREE == mappings[i]->status) {
+                        return mappings[i].get();
+                    }
+                }
+
+                mapping_ptr_t ret = std::make_shared<mapping_t>();
+                mappings.push_back(ret);
+                return ret.get();
+            }
+
+            void publish(mapping_t *mapping) {
+                mapping->status = mapping_t::status_t::EN_MMS_CURRENT;
+                mapping->generation.store(++generation, util::lock::memory_order_relaxed);
+                current.store(reinterpret_cast<uintptr_t>(mapping), util::lock::memory_order_seq_cst);
+            }
+
+            // 切换走当前文件，返回是否需要回收
+            bool retire_current() {
+                mapping_t *mapping = reinterpret_cast<mapping_t *>(current.load(util::lock::memory_order_relaxed));
+                current.store(0, util::lock::memory_order_seq_cst);
+                if (NULL == mapping) {
+                    return false;
+                }
+
+                mapping->status = mapping_t::status_t::EN_MMS_RETIRED;
+                return true;
+            }
+
+            // 丢弃预先打开的文件，返回是否需要回收
+            bool discard_prepared() {
+                bool ret = false;
+                if (NULL != prepared) {
+                    prepared->status = mapping_t::status_t::EN_MMS_RETIRED;
+                    prepared->remove_on_close = true;
+                    prepared = NULL;
+                    ret = true;
+                }
+
+                // 还没开始执行的任务直接取消，正在打开的在完成后丢弃
+                if (NULL != preparing && mapping_t::status_t::EN_MMS_PENDING == preparing->status) {
+                    preparing->status = mapping_t::status_t::EN_MMS_FREE;
+                }
+                preparing = NULL;
+                return ret;
+            }
+
+            /**
+             * @brief 把已经没有写入者的旧映射解除映射
+             * @param file_path 不为NULL时只处理这个文件
+             * @return 还有写入者没离开时返回false
+             */
+            bool reclaim(const std::string *file_path) {
+                std::vector<mapping_t *> closing;
+                bool ret = true;
+                {
+                    lock::lock_holder<lock::spin_lock> lkholder(mapping_lock);
+                    for (size_t i = 0; i < mappings.size(); ++i) {
+                        mapping_t *mapping = mappings[i].get();
+                        if (NULL != file_path && *file_path != mapping->file_path) {
+                            continue;
+                        }
+
+                        // 其他线程正在解除映射的也要等待，它可能还要删除文件
+                        if (mapping_t::status_t::EN_MMS_CLOSING == mapping->status) {
+                            ret = false;
+                            continue;
+                        }
+                        if (mapping_t::status_t::EN_MMS_RETIRED != mapping->status) {
+                            continue;
+                        }
+
+                        // 和写入者的writers加一、再检查current配对，要么这里看到写入者，要么写入者看到映射已经切换走
+                        if (0 != mapping->writers.load(util::lock::memory_order_seq_cst)) {
+                            ret = false;
+                            continue;
+                        }
+
+                        mapping->status = mapping_t::status_t::EN_MMS_CLOSING;
+                        closing.push_back(mapping);
+                    }
+                }
+
+                if (closing.empty()) {
+                    return ret;
+                }
+
+                // munmap要等待其他CPU刷新TLB，不放在锁内
+                for (size_t i = 0; i < closing.size(); ++i) {
+                    closing[i]->close();
+                }
+
+                lock::lock_holder<lock::spin_lock> lkholder(mapping_lock);
+                for (size_t i = 0; i < closing.size(); ++i) {
+                    closing[i]->status = mapping_t::status_t::EN_MMS_FREE;
+                }
+                return ret;
+            }
+
+            // 要截断的文件可能还被旧映射使用，先等它们解除映射
+            void wait_reclaim(const std::string &file_path) {
+                while (!reclaim(&file_path)) {
+                    THREAD_YIELD();
+                }
+            }
+        };
+
+        namespace detail {
+            static void log_sink_mmap_backend_reclaim(log_sink_mmap_backend::mapping_set_ptr_t mappings) { mappings->reclaim(NULL); }
+
+            static void log_sink_mmap_backend_async_reclaim(const log_sink_mmap_backend::mapping_set_ptr_t &mappings) {
+                if (!log_background_worker::post(std::bind(log_sink_mmap_backend_reclaim, mappings))) {
+                    mappings->reclaim(NULL);
+                }
+            }
+
+            // 在后台线程中创建并映射下一个文件的临时文件，不能动原来的文件，切换前它还是有效的历史日志
+            static void log_sink_mmap_backend_prepare(log_sink_mmap_backend::mapping_set_ptr_t mappings, log_sink_mmap_backend::mapping_t *mapping,
+                                                      uint32_t sequence, std::string file_path, size_t file_size) {
+                file_path += LOG_SINK_MMAP_PREPARING_SUFFIX;
+                {
+                    lock::lock_holder<lock::spin_lock> lkholder(mappings->mapping_lock);
+                    // 已经同步切换过或者修改了路径规则
+                    if (mapping != mappings->preparing || sequence != mappings->prepare_sequence) {
+                        return;
+                    }
+                    mapping->status = log_sink_mmap_backend::mapping_t::status_t::EN_MMS_OPENING;
+                }
+
+                mappings->wait_reclaim(file_path);
+                bool res = mapping->open(file_path.c_str(), file_size, true);
+                if (!res) {
+                    std::cerr << "log.mmap open " << file_path << " failed" << std::endl;
+                }
+
+                bool need_reclaim = false;
+                {
+                    lock::lock_holder<lock::spin_lock> lkholder(mappings->mapping_lock);
+                    if (!res) {
+                        mapping->close();
+                        mapping->status = log_sink_mmap_backend::mapping_t::status_t::EN_MMS_FREE;
+                    } else if (mapping == mappings->preparing && sequence == mappings->prepare_sequence) {
+                        mapping->status = log_sink_mmap_backend::mapping_t::status_t::EN_MMS_READY;
+                        mappings->prepared = mapping;
+                    } else {
+                        mapping->status = log_sink_mmap_backend::mapping_t::status_t::EN_MMS_RETIRED;
+                        mapping->remove_on_close = true;
+                        need_reclaim = true;
+                    }
+
+                    if (mapping == mappings->preparing && sequence == mappings->prepare_sequence) {
+                        mappings->preparing = NULL;
+                    }
+                }
+
+                if (need_reclaim) {
+                    mappings->reclaim(NULL);
+                }
+            }
+        }
+
+        log_sink_mmap_backend::log_sink_mmap_backend()
+            : rotation_size_(10),                       // 默认10个文件
+              file_size_(LOG_SINK_MMAP_BACKEND_FILE_SIZE), // 默认文件大小
+              mappings_(std::make_shared<mapping_set_t>()) {
+            path_pattern_.compile("%Y-%m-%d.%N.mmap.log"); // 默认文件名规则
+        }
+
+        log_sink_mmap_backend::log_sink_mmap_backend(const std::string &file_name_pattern)
+            : rotation_size_(10),                       // 默认10个文件
+              file_size_(LOG_SINK_MMAP_BACKEND_FILE_SIZE), // 默认文件大小
+              mappings_(std::make_shared<mapping_set_t>()) {
+            set_file_pattern(file_name_pattern);
+        }
+
+        log_sink_mmap_backend::log_sink_mmap_backend(const log_sink_mmap_backend &other)
+            : path_pattern_(other.path_pattern_), rotation_size_(other.rotation_size_), file_size_(other.file_size_),
+              mappings_(std::make_shared<mapping_set_t>()) {
+            // 映射的文件要重新打开，不能复制
+        }
+
+        log_sink_mmap_backend::~log_sink_mmap_backend() {
+            bool need_reclaim;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(mappings_->mapping_lock);
+                need_reclaim = mappings_->discard_prepared();
+            }
+
+            // 还在执行的后台任务持有mappings_，映射在它们结束后释放
+            if (need_reclaim) {
+                mappings_->reclaim(NULL);
+            }
+        }
+
+        void log_sink_mmap_backend::set_file_pattern(const std::string &file_name_pattern) {
+            bool need_reclaim;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(mappings_->mapping_lock);
+                path_pattern_.compile(file_name_pattern);
+
+                // 设置文件路径模式， 如果文件已打开，需要重新执行初始化流程
+                need_reclaim = mappings_->retire_current();
+                need_reclaim = mappings_->discard_prepared() || need_reclaim;
+                mappings_->inited = false;
+            }
+
+            if (need_reclaim) {
+                detail::log_sink_mmap_backend_async_reclaim(mappings_);
+            }
+        }
+
+        void log_sink_mmap_backend::operator()(const log_formatter::caller_info_t &, const char *content, size_t content_size) {
+            mapping_t *mapping = acquire_mapping();
+
+            // 单行日志不能超过文件大小
+            while (NULL != mapping) {
+                size_t len = content_size + 1;
+                if (len > mapping->size) {
+                    content_size = mapping->size - 1;
+                    len = mapping->size;
+                }
+
+                size_t pos = mapping->cursor.fetch_add(len, util::lock::memory_order_acq_rel);
+                if (pos + len <= mapping->size) {
+                    memcpy(mapping->data + pos, content, content_size);
+                    mapping->data[pos + content_size] = '\n';
+
+                    // 写过3/4后在后台线程中准备下一个文件，只有越过这个位置的那次写入会触发
+                    size_t prepare_pos = mapping->size - mapping->size / 4;
+                    if (pos < prepare_pos && pos + len >= prepare_pos) {
+                        prepare_next_mapping(mapping);
+                    }
+
+                    release_mapping(mapping);
+                    return;
+                }
+
+                // 当前文件已满，剩余的空间保持'\0'，切换到下一个文件
+                uint32_t generation = mapping->generation.load(util::lock::memory_order_relaxed);
+                release_mapping(mapping);
+                rotate_mapping(mapping, generation);
+                mapping = acquire_mapping();
+            }
+        }
+
+        void log_sink_mmap_backend::flush() {
+            mapping_t *mapping = pin_mapping();
+            if (NULL != mapping) {
+                mapping->flush();
+                release_mapping(mapping);
+            }
+        }
+
+        void log_sink_mmap_backend::init() {
+            if (mappings_->inited) {
+                return;
+            }
+
+            mappings_->inited = true;
+            mappings_->rotation_index = 0;
+            mappings_->destroy_content = false;
+
+            // 继续写最近一次修改的文件
+            char log_file[file_system::MAX_PATH_LEN];
+            bool found = false;
+            time_t last_modify_sec = 0;
+            long last_modify_nsec = 0;
+            size_t last_free_size = 0; // 0表示未计算
+            for (uint32_t i = 0; i < rotation_size_; ++i) {
+                format_file_path(log_file, sizeof(log_file), i);
+
+                time_t modify_sec;
+                long modify_nsec = 0;
+#ifdef UTIL_FS_WINDOWS_API
+                struct _stat64 st;
+                if (0 != _stat64(log_file, &st)) {
+                    continue;
+                }
+                modify_sec = static_cast<time_t>(st.st_mtime);
+#else
+                struct stat st;
+                if (0 != stat(log_file, &st)) {
+                    continue;
+                }
+                modify_sec = st.st_mtime;
+#if defined(__APPLE__)
+                modify_nsec = static_cast<long>(st.st_mtimespec.tv_nsec);
+#elif defined(__linux__)
+                modify_nsec = static_cast<long>(st.st_mtim.tv_nsec);
+#endif
+#endif
+                bool pick = !found || modify_sec > last_modify_sec || (modify_sec == last_modify_sec && modify_nsec > last_modify_nsec);
+                // 修改时间的精度不够时，剩余空间更多的是后写的文件
+                if (!pick && modify_sec == last_modify_sec && modify_nsec == last_modify_nsec) {
+                    if (0 == last_free_size) {
+                        format_file_path(log_file, sizeof(log_file), mappings_->rotation_index);
+                        last_free_size = detail::log_sink_mmap_get_free_size(log_file);
+                        format_file_path(log_file, sizeof(log_file), i);
+                    }
+
+                    size_t free_size = detail::log_sink_mmap_get_free_size(log_file);
+                    if (free_size > last_free_size) {
+                        pick = true;
+                        last_free_size = free_size;
+                    }
+                } else if (pick) {
+                    last_free_size = 0;
+                }
+
+                if (pick) {
+                    found = true;
+                    last_modify_sec = modify_sec;
+                    last_modify_nsec = modify_nsec;
+                    mappings_->rotation_index = i;
+                }
+            }
+        }
+
+        size_t log_sink_mmap_backend::format_file_path(char *buff, size_t bufz, uint32_t rotation_index) const {
+            log_formatter::caller_info_t caller;
+            caller.rotate_index = rotation_index;
+            return log_formatter::format(buff, bufz, path_pattern_, caller);
+        }
+
+        uint32_t log_sink_mmap_backend::get_next_rotation_index(uint32_t rotation_index) const {
+            if (rotation_size_ > 0) {
+                return (rotation_index + 1) % rotation_size_;
+            }
+
+            return 0;
+        }
+
+        log_sink_mmap_backend::mapping_t *log_sink_mmap_backend::pin_mapping() {
+            while (true) {
+                mapping_t *ret = reinterpret_cast<mapping_t *>(mappings_->current.load(util::lock::memory_order_acquire));
+                if (NULL == ret) {
+                    return NULL;
+                }
+
+                // 先标记再确认它还是当前映射，之后回收流程一定能看到这个写入者
+                ret->writers.fetch_add(1, util::lock::memory_order_seq_cst);
+                if (reinterpret_cast<uintptr_t>(ret) == mappings_->current.load(util::lock::memory_order_seq_cst)) {
+                    return ret;
+                }
+                release_mapping(ret);
+            }
+        }
+
+        void log_sink_mmap_backend::release_mapping(mapping_t *mapping) { mapping->writers.fetch_sub(1, util::lock::memory_order_release); }
+
+        log_sink_mmap_backend::mapping_t *log_sink_mmap_backend::acquire_mapping() {
+            while (true) {
+                mapping_t *ret = pin_mapping();
+                if (NULL != ret) {
+                    return ret;
+                }
+
+                if (!open_current_mapping()) {
+                    return NULL;
+                }
+            }
+        }
+
+        bool log_sink_mmap_backend::open_current_mapping() {
+            mapping_set_t &mappings = *mappings_;
+            mapping_t *mapping = NULL;
+            std::string file_path;
+            bool destroy_content = false;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(mappings.mapping_lock);
+                if (0 != mappings.current.load(util::lock::memory_order_acquire)) {
+                    return true;
+                }
+
+                if (!mappings.opening) {
+                    init();
+
+                    char log_file[file_system::MAX_PATH_LEN];
+                    size_t file_path_len = format_file_path(log_file, sizeof(log_file), mappings.rotation_index);
+                    if (file_path_len <= 0) {
+                        std::cerr << "log.format " << path_pattern_.get_source() << " failed" << std::endl;
+                        return false;
+                    }
+
+                    file_path.assign(log_file, file_path_len);
+                    destroy_content = mappings.destroy_content;
+                    mapping = mappings.alloc();
+                    mapping->status = mapping_t::status_t::EN_MMS_OPENING;
+                    mappings.opening = true;
+                }
+            }
+
+            // 其他写入者正在打开，等它完成
+            if (NULL == mapping) {
+                THREAD_YIELD();
+                return true;
+            }
+
+            // 打开、扩展和映射文件都是系统调用，不放在锁内
+            if (destroy_content) {
+                mappings.wait_reclaim(file_path);
+            }
+            bool res = mapping->open(file_path.c_str(), file_size_, destroy_content);
+            if (!res) {
+                std::cerr << "log.mmap open " << file_path << " failed" << path_pattern_.get_source() << std::endl;
+            }
+
+            lock::lock_holder<lock::spin_lock> lkholder(mappings.mapping_lock);
+            mappings.opening = false;
+            // 失败时丢弃这一行，下一次写入时重试，不再清空内容
+            mappings.destroy_content = false;
+            if (!res) {
+                mapping->close();
+                mapping->status = mapping_t::status_t::EN_MMS_FREE;
+                return false;
+            }
+
+            mappings.publish(mapping);
+            return true;
+        }
+
+        void log_sink_mmap_backend::rotate_mapping(mapping_t *full_mapping, uint32_t generation) {
+            bool need_reclaim = false;
+            bool need_wait = false;
+            mapping_t *next_mapping = NULL;
+            std::string file_path;
+            std::string temp_path;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(mappings_->mapping_lock);
+
+                // 已经被其他线程切换过了
+                if (reinterpret_cast<uintptr_t>(full_mapping) != mappings_->current.load(util::lock::memory_order_acquire) ||
+                    generation != full_mapping->generation.load(util::lock::memory_order_relaxed)) {
+                    return;
+                }
+
+                if (NULL != mappings_->prepared) {
+                    // 下一个文件已经准备好，改名后替换指针，改名期间其他写入者等待
+                    next_mapping = mappings_->prepared;
+                    mappings_->prepared = NULL;
+                    need_reclaim = mappings_->retire_current();
+                    mappings_->rotation_index = get_next_rotation_index(mappings_->rotation_index);
+
+                    char log_file[file_system::MAX_PATH_LEN];
+                    size_t file_path_len = format_file_path(log_file, sizeof(log_file), mappings_->rotation_index);
+                    if (file_path_len > 0) {
+                        file_path.assign(log_file, file_path_len);
+                        temp_path = next_mapping->file_path;
+                        next_mapping->status = mapping_t::status_t::EN_MMS_OPENING;
+                        mappings_->opening = true;
+                    } else {
+                        next_mapping->status = mapping_t::status_t::EN_MMS_RETIRED;
+                        next_mapping->remove_on_close = true;
+                        next_mapping = NULL;
+                        mappings_->destroy_content = true;
+                    }
+                } else if (NULL != mappings_->preparing && mapping_t::status_t::EN_MMS_OPENING == mappings_->preparing->status) {
+                    // 后台线程正在打开下一个文件，不能同时截断它
+                    need_wait = true;
+                } else {
+                    // 后台线程还没处理到，改为由第一个写入者在锁外打开
+                    mappings_->discard_prepared();
+                    need_reclaim = mappings_->retire_current();
+                    mappings_->rotation_index = get_next_rotation_index(mappings_->rotation_index);
+                    mappings_->destroy_content = true;
+                }
+            }
+
+            if (need_wait) {
+                THREAD_YIELD();
+            }
+
+            // 旧的映射仍然指向被替换掉的文件，改名不影响它们，不需要等待回收
+            if (NULL != next_mapping) {
+                bool res = util::file_system::rename(temp_path.c_str(), file_path.c_str());
+
+                lock::lock_holder<lock::spin_lock> lkholder(mappings_->mapping_lock);
+                mappings_->opening = false;
+                if (res) {
+                    next_mapping->file_path = file_path;
+                    mappings_->publish(next_mapping);
+                } else {
+                    // 改名失败(比如平台不允许改名已映射的文件)时丢弃临时文件，由第一个写入者在锁外打开
+                    next_mapping->status = mapping_t::status_t::EN_MMS_RETIRED;
+                    next_mapping->remove_on_close = true;
+                    mappings_->destroy_content = true;
+                    need_reclaim = true;
+                }
+            }
+
+            // 旧文件在最后一个写入者离开后由后台线程解除映射
+            if (need_reclaim) {
+                detail::log_sink_mmap_backend_async_reclaim(mappings_);
+            }
+        }
+
+        void log_sink_mmap_backend::prepare_next_mapping(mapping_t *mapping) {
+            mapping_t *next_mapping;
+            uint32_t sequence;
+            std::string file_path;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(mappings_->mapping_lock);
+                if (reinterpret_cast<uintptr_t>(mapping) != mappings_->current.load(util::lock::memory_order_acquire) ||
+                    NULL != mappings_->preparing || NULL != mappings_->prepared) {
+                    return;
+                }
+
+                char log_file[file_system::MAX_PATH_LEN];
+                size_t file_path_len = format_file_path(log_file, sizeof(log_file), get_next_rotation_index(mappings_->rotation_index));
+                // 下一个文件就是当前文件时(比如只有一个文件)不能提前截断
+                if (file_path_len <= 0 || mapping->file_path == log_file) {
+                    return;
+                }
+
+                file_path.assign(log_file, file_path_len);
+                next_mapping = mappings_->alloc();
+                next_mapping->status = mapping_t::status_t::EN_MMS_PENDING;
+                mappings_->preparing = next_mapping;
+                sequence = ++mappings_->prepare_sequence;
+            }
+
+            if (!log_background_worker::post(
+                    std::bind(detail::log_sink_mmap_backend_prepare, mappings_, next_mapping, sequence, file_path, file_size_))) {
+                // 后台线程不可用时切换时再打开
+                lock::lock_holder<lock::spin_lock> lkholder(mappings_->mapping_lock);
+                if (sequence == mappings_->prepare_sequence) {
+                    mappings_->discard_prepared();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,393 @@
+﻿#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <iostream>
+#include <vector>
+
+#include "common/string_oprs.h"
+#include "lock/atomic_int_type.h"
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+#include "std/chrono.h"
+
+#include "log/log_background_worker.h"
+#include "log/log_sink_socket_backend.h"
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define LOG_SINK_SOCKET_SUPPORTED 1
+#endif
+
+namespace util {
+    namespace log {
+        struct log_sink_socket_backend::socket_impl_t {
+            lock::spin_lock lock;
+            std::string address;
+            int fd;
+            std::vector<char> buffer;
+            size_t used;
+            std::vector<std::pair<size_t, size_t> > records; // 缓冲区内每行日志的起始位置和长度
+            std::chrono::steady_clock::time_point last_flush;
+            bool timer_added; // 是否已经添加了定时发送的任务
+            util::lock::atomic_int_type<uint64_t> sent_count;
+            util::lock::atomic_int_type<uint64_t> dropped_count;
+
+#if defined(LOG_SINK_SOCKET_SUPPORTED) && LOG_SINK_SOCKET_SUPPORTED
+            sockaddr_storage addr;
+            socklen_t addr_len;
+#if defined(__linux__)
+            std::vector<mmsghdr> msgs;
+#endif
+            std::vector<iovec> iovs;
+#endif
+
+            socket_impl_t() : fd(-1), used(0), last_flush(std::chrono::steady_clock::now()), timer_added(false) {
+#if defined(LOG_SINK_SOCKET_SUPPORTED) && LOG_SINK_SOCKET_SUPPORTED
+                memset(&addr, 0, sizeof(addr));
+                addr_len = 0;
+#endif
+            }
+
+            // 最后一个共享的对象释放时发送剩下的日志
+            ~socket_impl_t() {
+                send_batch();
+                close();
+            }
+
+            void close() {
+#if defined(LOG_SINK_SOCKET_SUPPORTED) && LOG_SINK_SOCKET_SUPPORTED
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+#endif
+                fd = -1;
+            }
+
+            inline bool good() const { return fd >= 0; }
+
+            // 丢弃缓冲区内的日志
+            void drop() {
+                dropped_count.fetch_add(static_cast<uint64_t>(records.size()), util::lock::memory_order_relaxed);
+                records.clear();
+                used = 0;
+            }
+
+            // 发送缓冲区内的日志，调用前需要加锁
+            void send_batch();
+        };
+
+        namespace detail {
+#if defined(LOG_SINK_SOCKET_SUPPORTED) && LOG_SINK_SOCKET_SUPPORTED
+            static bool log_sink_socket_resolve(const std::string &address, sockaddr_storage &addr, socklen_t &addr_len) {
+                memset(&addr, 0, sizeof(addr));
+                addr_len = 0;
+
+                if (0 == UTIL_STRFUNC_STRNCASE_CMP(address.c_str(), "unix:", 5)) {
+                    sockaddr_un *un_addr = reinterpret_cast<sockaddr_un *>(&addr);
+                    std::string path = address.substr(5);
+                    if (path.empty() || path.size() >= sizeof(un_addr->sun_path)) {
+                        return false;
+                    }
+
+                    un_addr->sun_family = AF_UNIX;
+                    memcpy(un_addr->sun_path, path.c_str(), path.size() + 1);
+                    addr_len = static_cast<socklen_t>(sizeof(sockaddr_un));
+                    return true;
+                }
+
+                if (0 != UTIL_STRFUNC_STRNCASE_CMP(address.c_str(), "udp:", 4)) {
+                    return false;
+                }
+
+                // udp:<host>:<port> 或 udp:[<ipv6>]:<port>
+                std::string host_port = address.substr(4);
+                std::string::size_type sep = host_port.find_last_of(':');
+                if (std::string::npos == sep || 0 == sep || sep + 1 >= host_port.size()) {
+                    return false;
+                }
+
+                std::string host = host_port.substr(0, sep);
+                std::string port = host_port.substr(sep + 1);
+                if (host.size() >= 2 && '[' == host[0] && ']' == host[host.size() - 1]) {
+                    host = host.substr(1, host.size() - 2);
+                }
+
+                addrinfo hints;
+                memset(&hints, 0, sizeof(hints));
+                hints.ai_family = AF_UNSPEC;
+                hints.ai_socktype = SOCK_DGRAM;
+                hints.ai_flags = AI_NUMERICSERV;
+
+                addrinfo *result = NULL;
+                if (0 != getaddrinfo(host.c_str(), port.c_str(), &hints, &result) || NULL == result) {
+                    return false;
+                }
+
+                bool ret = false;
+                if (result->ai_addrlen <= sizeof(addr)) {
+                    memcpy(&addr, result->ai_addr, result->ai_addrlen);
+                    addr_len = static_cast<socklen_t>(result->ai_addrlen);
+                    ret = true;
+                }
+                freeaddrinfo(result);
+                return ret;
+            }
+
+            static int log_sink_socket_open(int family) {
+                int fd = ::socket(family, SOCK_DGRAM, 0);
+                if (fd < 0) {
+                    return -1;
+                }
+
+                // 非阻塞发送，发送缓冲区满时直接丢弃
+                int flags = fcntl(fd, F_GETFL, 0);
+                if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+                    ::close(fd);
+                    return -1;
+                }
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+                return fd;
+            }
+#endif
+
+            // 日志很少时也要在flush_interval内发送，对象释放后移除定时任务
+            static bool log_sink_socket_flush_timer(std::weak_ptr<log_sink_socket_backend::socket_impl_t> impl, time_t interval_ms) {
+                log_sink_socket_backend::socket_impl_ptr_t s = impl.lock();
+                if (!s) {
+                    return false;
+                }
+
+                lock::lock_holder<lock::spin_lock> lkholder(s->lock);
+                if (!s->records.empty() && std::chrono::steady_clock::now() - s->last_flush >= std::chrono::milliseconds(interval_ms)) {
+                    s->send_batch();
+                }
+                return true;
+            }
+
+            static int log_sink_socket_syslog_severity(log_formatter::level_t::type level) {
+                switch (level) {
+                case log_formatter::level_t::LOG_LW_FATAL:
+                    return 2; // LOG_CRIT
+                case log_formatter::level_t::LOG_LW_ERROR:
+                    return 3; // LOG_ERR
+                case log_formatter::level_t::LOG_LW_WARNING:
+                    return 4; // LOG_WARNING
+                case log_formatter::level_t::LOG_LW_INFO:
+                case log_formatter::level_t::LOG_LW_NOTICE:
+                    return 6; // LOG_INFO
+                default:
+                    return 7; // LOG_DEBUG
+                }
+            }
+        }
+
+        log_sink_socket_backend::log_sink_socket_backend()
+            : batch_size_(32),                                 // 默认32行发送一次
+              flush_interval_(100),                            // 默认缓冲区内的日志最多停留100毫秒
+              max_datagram_size_(8192), syslog_facility_(-1), impl_(std::make_shared<socket_impl_t>()) {}
+
+        log_sink_socket_backend::log_sink_socket_backend(const std::string &address)
+            : batch_size_(32),                                 // 默认32行发送一次
+              flush_interval_(100),                            // 默认缓冲区内的日志最多停留100毫秒
+              max_datagram_size_(8192), syslog_facility_(-1), impl_(std::make_shared<socket_impl_t>()) {
+            set_address(address);
+        }
+
+        log_sink_socket_backend::log_sink_socket_backend(const log_sink_socket_backend &other)
+            : batch_size_(other.batch_size_), flush_interval_(other.flush_interval_), max_datagram_size_(other.max_datagram_size_),
+              syslog_facility_(other.syslog_facility_), impl_(other.impl_) {
+            // 共享套接字和缓冲区，添加到log_wrapper时会被复制，原来的对象仍然可以flush()
+        }
+
+        log_sink_socket_backend::~log_sink_socket_backend() {}
+
+        bool log_sink_socket_backend::set_address(const std::string &address) {
+            lock::lock_holder<lock::spin_lock> lkholder(impl_->lock);
+            impl_->send_batch();
+            impl_->close();
+            impl_->address = address;
+
+#if defined(LOG_SINK_SOCKET_SUPPORTED) && LOG_SINK_SOCKET_SUPPORTED
+            if (!detail::log_sink_socket_resolve(address, impl_->addr, impl_->addr_len)) {
+                std::cerr << "log.socket resolve " << address << " failed" << std::endl;
+                return false;
+            }
+
+            impl_->fd = detail::log_sink_socket_open(impl_->addr.ss_family);
+            if (impl_->fd < 0) {
+                std::cerr << "log.socket open " << address << " failed" << std::endl;
+                return false;
+            }
+
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        log_sink_socket_backend &log_sink_socket_backend::set_batch_size(size_t sz) {
+            if (0 == sz) {
+                sz = 1;
+            }
+
+            flush();
+            batch_size_ = sz;
+            return *this;
+        }
+
+        void log_sink_socket_backend::operator()(const log_formatter::caller_info_t &caller, const char *content, size_t content_size) {
+            lock::lock_holder<lock::spin_lock> lkholder(impl_->lock);
+            if (!impl_->good()) {
+                impl_->dropped_count.fetch_add(1, util::lock::memory_order_relaxed);
+                return;
+            }
+
+            if (impl_->buffer.size() != LOG_SINK_SOCKET_BACKEND_BUFFER_SIZE) {
+                impl_->buffer.resize(LOG_SINK_SOCKET_BACKEND_BUFFER_SIZE);
+            }
+
+            char syslog_pri[16];
+            size_t syslog_pri_len = 0;
+            if (syslog_facility_ >= 0) {
+                int len = UTIL_STRFUNC_SNPRINTF(syslog_pri, sizeof(syslog_pri), "<%d>",
+                                                syslog_facility_ * 8 + detail::log_sink_socket_syslog_severity(caller.level_id));
+                syslog_pri_len = len > 0 && static_cast<size_t>(len) < sizeof(syslog_pri) ? static_cast<size_t>(len) : 0;
+            }
+
+            // 超过单个数据报长度的部分截断
+            size_t max_size = max_datagram_size_ > 0 ? max_datagram_size_ : LOG_SINK_SOCKET_BACKEND_BUFFER_SIZE;
+            if (syslog_pri_len >= max_size) {
+                syslog_pri_len = 0;
+            }
+            if (syslog_pri_len + content_size > max_size) {
+                content_size = max_size - syslog_pri_len;
+            }
+
+            size_t record_size = syslog_pri_len + content_size;
+            if (impl_->used + record_size > impl_->buffer.size()) {
+                impl_->send_batch();
+            }
+
+            if (syslog_pri_len > 0) {
+                memcpy(&impl_->buffer[impl_->used], syslog_pri, syslog_pri_len);
+            }
+            if (content_size > 0) {
+                memcpy(&impl_->buffer[impl_->used + syslog_pri_len], content, content_size);
+            }
+            impl_->records.push_back(std::make_pair(impl_->used, record_size));
+            impl_->used += record_size;
+
+            if (impl_->records.size() >= batch_size_) {
+                impl_->send_batch();
+            } else if (flush_interval_ > 0) {
+                if (std::chrono::steady_clock::now() - impl_->last_flush >= std::chrono::milliseconds(flush_interval_)) {
+                    impl_->send_batch();
+                } else if (!impl_->timer_added) {
+                    impl_->timer_added = true;
+                    log_background_worker::add_timer(
+                        std::bind(detail::log_sink_socket_flush_timer, std::weak_ptr<socket_impl_t>(impl_), flush_interval_), flush_interval_);
+                }
+            }
+        }
+
+        void log_sink_socket_backend::flush() {
+            lock::lock_holder<lock::spin_lock> lkholder(impl_->lock);
+            impl_->send_batch();
+        }
+
+        const std::string &log_sink_socket_backend::get_address() const { return impl_->address; }
+
+        uint64_t log_sink_socket_backend::get_sent_count() const { return impl_->sent_count.load(util::lock::memory_order_relaxed); }
+
+        uint64_t log_sink_socket_backend::get_dropped_count() const {
+            return impl_->dropped_count.load(util::lock::memory_order_relaxed);
+        }
+
+        bool log_sink_socket_backend::is_supported() {
+#if defined(LOG_SINK_SOCKET_SUPPORTED) && LOG_SINK_SOCKET_SUPPORTED
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void log_sink_socket_backend::socket_impl_t::send_batch() {
+            socket_impl_t &impl = *this;
+            impl.last_flush = std::chrono::steady_clock::now();
+            if (impl.records.empty()) {
+                return;
+            }
+
+            if (!impl.good()) {
+                impl.drop();
+                return;
+            }
+
+#if defined(LOG_SINK_SOCKET_SUPPORTED) && LOG_SINK_SOCKET_SUPPORTED
+            size_t count = impl.records.size();
+            if (impl.iovs.size() < count) {
+                impl.iovs.resize(count);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                impl.iovs[i].iov_base = &impl.buffer[impl.records[i].first];
+                impl.iovs[i].iov_len = impl.records[i].second;
+            }
+
+            size_t sent = 0;
+#if defined(__linux__)
+            // 一次系统调用发送多个数据报
+            if (impl.msgs.size() < count) {
+                impl.msgs.resize(count);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                memset(&impl.msgs[i], 0, sizeof(mmsghdr));
+                impl.msgs[i].msg_hdr.msg_name = &impl.addr;
+                impl.msgs[i].msg_hdr.msg_namelen = impl.addr_len;
+                impl.msgs[i].msg_hdr.msg_iov = &impl.iovs[i];
+                impl.msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            while (sent < count) {
+                int res = ::sendmmsg(impl.fd, &impl.msgs[sent], static_cast<unsigned int>(count - sent), MSG_DONTWAIT);
+                if (res < 0 && EINTR == errno) {
+                    continue;
+                }
+
+                // 发送缓冲区满或接收方不存在时丢弃剩下的日志
+                if (res <= 0) {
+                    break;
+                }
+                sent += static_cast<size_t>(res);
+            }
+#else
+            for (; sent < count; ++sent) {
+                ssize_t res;
+                do {
+                    res = ::sendto(impl.fd, impl.iovs[sent].iov_base, impl.iovs[sent].iov_len, 0,
+                                   reinterpret_cast<const sockaddr *>(&impl.addr), impl.addr_len);
+                } while (res < 0 && EINTR == errno);
+
+                if (res < 0) {
+                    break;
+                }
+            }
+#endif
+
+            impl.sent_count.fetch_add(static_cast<uint64_t>(sent), util::lock::memory_order_relaxed);
+            impl.dropped_count.fetch_add(static_cast<uint64_t>(count - sent), util::lock::memory_order_relaxed);
+            impl.records.clear();
+            impl.used = 0;
+#else
+            impl.drop();
+#endif
+        }
+    }
+}
@@ -0,0 +1,258 @@
+﻿#include <cstring>
+#include <list>
+
+#include "lock/atomic_int_type.h"
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+#include "std/chrono.h"
+#include "std/thread.h"
+
+#include "log/log_stats.h"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+namespace util {
+    namespace log {
+        namespace detail {
+            /**
+             * @brief 每个线程的计数器，只有所属线程写入，读取时其他线程只做relaxed读取
+             */
+            struct log_stats_thread_block_t {
+                util::lock::atomic_int_type<uint64_t> counters[log_wrapper::categorize_t::MAX][log_stats::counter_t::EN_LSC_MAX];
+            };
+
+            struct log_stats_registry_t {
+                lock::spin_lock lock;
+                std::list<log_stats_thread_block_t *> blocks;
+                log_stats::snapshot_t retired;  // 已退出线程的数据
+                log_stats::snapshot_t baseline; // reset()时的数据
+
+                log_stats_registry_t() {
+                    memset(&retired, 0, sizeof(retired));
+                    memset(&baseline, 0, sizeof(baseline));
+                }
+            };
+
+            // 线程退出的时机可能晚于全局变量析构，所以注册表不释放
+            static log_stats_registry_t *get_log_stats_registry() {
+                static log_stats_registry_t *ret = new log_stats_registry_t();
+                return ret;
+            }
+
+            static void log_stats_collect(const log_stats_thread_block_t &block, log_stats::snapshot_t &out) {
+                for (uint32_t cat = 0; cat < log_wrapper::categorize_t::MAX; ++cat) {
+                    for (size_t i = 0; i < log_stats::counter_t::EN_LSC_MAX; ++i) {
+                        out.categories[cat].counters[i] += block.counters[cat][i].load(util::lock::memory_order_relaxed);
+                    }
+                }
+            }
+
+            static void log_stats_release_block(void *p) {
+                log_stats_thread_block_t *block = reinterpret_cast<log_stats_thread_block_t *>(p);
+                if (NULL == block) {
+                    return;
+                }
+
+                log_stats_registry_t *registry = get_log_stats_registry();
+                {
+                    lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+                    log_stats_collect(*block, registry->retired);
+                    registry->blocks.remove(block);
+                }
+                delete block;
+            }
+
+            static log_stats_thread_block_t *log_stats_create_block() {
+                log_stats_thread_block_t *block = new log_stats_thread_block_t();
+                log_stats_registry_t *registry = get_log_stats_registry();
+                lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+                registry->blocks.push_back(block);
+                return block;
+            }
+
+#if !defined(_WIN32)
+            static pthread_once_t gt_log_stats_tls_once = PTHREAD_ONCE_INIT;
+            static pthread_key_t gt_log_stats_tls_key;
+
+            static void init_pthread_log_stats_tls() { (void)pthread_key_create(&gt_log_stats_tls_key, log_stats_release_block); }
+#endif
+
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+            static log_stats_thread_block_t *get_log_stats_block() {
+                static THREAD_TLS log_stats_thread_block_t *ret = NULL;
+                if (NULL == ret) {
+                    ret = log_stats_create_block();
+#if !defined(_WIN32)
+                    // 线程退出时把数据合并到已退出线程的数据中，Windows下线程数据一直保留
+                    (void)pthread_once(&gt_log_stats_tls_once, init_pthread_log_stats_tls);
+                    pthread_setspecific(gt_log_stats_tls_key, ret);
+#endif
+                }
+                return ret;
+            }
+#else
+            static log_stats_thread_block_t *get_log_stats_block() {
+                (void)pthread_once(&gt_log_stats_tls_once, init_pthread_log_stats_tls);
+                log_stats_thread_block_t *ret = reinterpret_cast<log_stats_thread_block_t *>(pthread_getspecific(gt_log_stats_tls_key));
+                if (NULL == ret) {
+                    ret = log_stats_create_block();
+                    pthread_setspecific(gt_log_stats_tls_key, ret);
+                }
+                return ret;
+            }
+#endif
+
+            // 只有当前线程写入，不需要原子加法
+            static inline void log_stats_add(util::lock::atomic_int_type<uint64_t> &counter, uint64_t value) {
+                counter.store(counter.load(util::lock::memory_order_relaxed) + value, util::lock::memory_order_relaxed);
+            }
+        }
+
+        uint64_t log_stats::category_t::get_total_lines() const {
+            uint64_t ret = 0;
+            for (int i = 0; i < LEVEL_COUNT; ++i) {
+                ret += counters[counter_t::EN_LSC_LINES + i];
+            }
+            return ret;
+        }
+
+        void log_stats::snapshot(snapshot_t &out) {
+            detail::log_stats_registry_t *registry = detail::get_log_stats_registry();
+
+            lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+            memcpy(&out, &registry->retired, sizeof(out));
+            for (std::list<detail::log_stats_thread_block_t *>::iterator iter = registry->blocks.begin(); iter != registry->blocks.end();
+                 ++iter) {
+                detail::log_stats_collect(**iter, out);
+            }
+
+            for (uint32_t cat = 0; cat < log_wrapper::categorize_t::MAX; ++cat) {
+                for (size_t i = 0; i < counter_t::EN_LSC_MAX; ++i) {
+                    out.categories[cat].counters[i] -= registry->baseline.categories[cat].counters[i];
+                }
+            }
+        }
+
+        void log_stats::reset() {
+            detail::log_stats_registry_t *registry = detail::get_log_stats_registry();
+
+            lock::lock_holder<lock::spin_lock> lkholder(registry->lock);
+            memcpy(&registry->baseline, &registry->retired, sizeof(registry->baseline));
+            for (std::list<detail::log_stats_thread_block_t *>::iterator iter = registry->blocks.begin(); iter != registry->blocks.end();
+                 ++iter) {
+                detail::log_stats_collect(**iter, registry->baseline);
+            }
+        }
+
+        bool log_stats::get_sink_stats(const log_wrapper &logger, uint32_t sink_id, sink_t &out) {
+            log_wrapper::sink_table_ptr_t table = logger.get_sinks();
+            if (!table) {
+                return false;
+            }
+
+            for (size_t i = 0; i < table->routers.size(); ++i) {
+                const log_wrapper::log_router_t &router = *table->routers[i];
+                if (router.sink_id != sink_id) {
+                    continue;
+                }
+
+                for (size_t j = 0; j < sink_counter_t::EN_LSSC_MAX; ++j) {
+                    out.counters[j] = router.stats ? router.stats->counters[j].load(util::lock::memory_order_relaxed) : 0;
+                }
+                return true;
+            }
+
+            return false;
+        }
+
+        uint64_t log_stats::get_latency_bucket_bound(size_t bucket) {
+            if (bucket + 1 >= LATENCY_BUCKET_COUNT) {
+                return 0;
+            }
+
+            return static_cast<uint64_t>(1) << (bucket + LATENCY_BUCKET_SHIFT);
+        }
+
+        size_t log_stats::get_latency_bucket(uint64_t ns) {
+            ns >>= LATENCY_BUCKET_SHIFT;
+            size_t ret = 0;
+            while (ns > 0 && ret + 1 < LATENCY_BUCKET_COUNT) {
+                ns >>= 1;
+                ++ret;
+            }
+
+            return ret;
+        }
+
+        uint64_t log_stats::now_ns() {
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        void log_stats::add(uint32_t cat, counter_t::type counter, uint64_t value) {
+            if (cat >= log_wrapper::categorize_t::MAX || counter >= counter_t::EN_LSC_MAX) {
+                return;
+            }
+
+            detail::log_stats_add(detail::get_log_stats_block()->counters[cat][counter], value);
+        }
+
+        void log_stats::add_line(uint32_t cat, log_wrapper::level_t::type level, uint64_t bytes) {
+            if (cat >= log_wrapper::categorize_t::MAX || level < 0 || static_cast<int>(level) >= static_cast<int>(LEVEL_COUNT)) {
+                return;
+            }
+
+            detail::log_stats_thread_block_t *block = detail::get_log_stats_block();
+            detail::log_stats_add(block->counters[cat][counter_t::EN_LSC_LINES + level], 1);
+            detail::log_stats_add(block->counters[cat][counter_t::EN_LSC_BYTES], bytes);
+        }
+
+        void log_stats::add_format_latency(uint32_t cat, uint64_t ns) {
+            if (cat >= log_wrapper::categorize_t::MAX) {
+                return;
+            }
+
+            detail::log_stats_thread_block_t *block = detail::get_log_stats_block();
+            detail::log_stats_add(block->counters[cat][counter_t::EN_LSC_FORMAT_COUNT], 1);
+            detail::log_stats_add(block->counters[cat][counter_t::EN_LSC_FORMAT_NS], ns);
+        }
+
+        void log_stats::add_sink_latency(uint32_t cat, uint64_t ns) {
+            if (cat >= log_wrapper::categorize_t::MAX) {
+                return;
+            }
+
+            detail::log_stats_thread_block_t *block = detail::get_log_stats_block();
+            detail::log_stats_add(block->counters[cat][counter_t::EN_LSC_SINK_CALLS], 1);
+            detail::log_stats_add(block->counters[cat][counter_t::EN_LSC_SINK_NS], ns);
+            detail::log_stats_add(block->counters[cat][counter_t::EN_LSC_SINK_LATENCY + get_latency_bucket(ns)], 1);
+        }
+
+        void log_stats::add_sink_line(const log_wrapper::log_router_t &router, uint64_t bytes) {
+            if (!router.stats) {
+                return;
+            }
+
+            router.stats->counters[sink_counter_t::EN_LSSC_LINES].fetch_add(1, util::lock::memory_order_relaxed);
+            router.stats->counters[sink_counter_t::EN_LSSC_BYTES].fetch_add(bytes, util::lock::memory_order_relaxed);
+        }
+
+        void log_stats::add_sink_latency(const log_wrapper::log_router_t &router, uint64_t ns) {
+            if (!router.stats) {
+                return;
+            }
+
+            router.stats->counters[sink_counter_t::EN_LSSC_CALLS].fetch_add(1, util::lock::memory_order_relaxed);
+            router.stats->counters[sink_counter_t::EN_LSSC_NS].fetch_add(ns, util::lock::memory_order_relaxed);
+            router.stats->counters[sink_counter_t::EN_LSSC_LATENCY + get_latency_bucket(ns)].fetch_add(1, util::lock::memory_order_relaxed);
+        }
+
+        log_sink_stats_t::log_sink_stats_t() {
+            for (size_t i = 0; i < log_stats::sink_counter_t::EN_LSSC_MAX; ++i) {
+                counters[i].store(0, util::lock::memory_order_relaxed);
+            }
+        }
+    }
+}
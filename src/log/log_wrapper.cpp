@@ -1,153 +1,660 @@
-﻿#include "std/thread.h"
-#include <cstdio>
-#include <cstring>
-#include <stdarg.h>
-
-
-#include "common/string_oprs.h"
-#include "lock/lock_holder.h"
-#include "lock/spin_lock.h"
-
-#include "time/time_utility.h"
-
-#include "log/log_formatter.h"
-#include "log/log_wrapper.h"
-
-#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
-namespace util {
-    namespace log {
-        namespace detail {
-            char *get_log_tls_buffer() {
-                static THREAD_TLS char ret[LOG_WRAPPER_MAX_SIZE_PER_LINE];
-                return ret;
-            }
-        }
-    }
-}
-#else
-
-#include <pthread.h>
-namespace util {
-    namespace log {
-        namespace detail {
-            static pthread_once_t gt_get_log_tls_once = PTHREAD_ONCE_INIT;
-            static pthread_key_t gt_get_log_tls_key;
-
-            static void dtor_pthread_get_log_tls(void *p) {
-                char *buffer_block = reinterpret_cast<char *>(p);
-                if (NULL != buffer_block) {
-                    delete[] buffer_block;
-                }
-            }
-
-            static void init_pthread_get_log_tls() { (void)pthread_key_create(&gt_get_log_tls_key, dtor_pthread_get_log_tls); }
-
-            char *get_log_tls_buffer() {
-                (void)pthread_once(&gt_get_log_tls_once, init_pthread_get_log_tls);
-                char *buffer_block = reinterpret_cast<char *>(pthread_getspecific(gt_get_log_tls_key));
-                if (NULL == buffer_block) {
-                    buffer_block = new char[LOG_WRAPPER_MAX_SIZE_PER_LINE];
-                    pthread_setspecific(gt_get_log_tls_key, buffer_block);
-                }
-                return buffer_block;
-            }
-        }
-    }
-}
-
-#endif
-
-namespace util {
-    namespace log {
-        bool log_wrapper::destroyed_ = false;
-
-        log_wrapper::log_wrapper() : log_level_(level_t::LOG_LW_DISABLED) {
-            update();
-
-            set_option(options_t::OPT_AUTO_UPDATE_TIME, true);
-            prefix_format_ = "[Log %L][%F %T.%f][%s:%n(%C)]: ";
-        }
-
-        log_wrapper::~log_wrapper() {
-            log_wrapper::destroyed_ = true;
-
-            // 重置level，只要内存没释放，就还可以内存访问，但是不能写出日志
-            log_level_ = level_t::LOG_LW_DISABLED;
-        }
-
-        int32_t log_wrapper::init(level_t::type level) {
-            log_level_ = level;
-
-            return 0;
-        }
-
-        void log_wrapper::add_sink(log_handler_t h, level_t::type level_min, level_t::type level_max) {
-            if (h) {
-                log_router_t router;
-                router.handle = h;
-                router.level_min = level_min;
-                router.level_max = level_max;
-                log_sinks_.push_back(router);
-            };
-        }
-
-        void log_wrapper::update() {}
-
-        void log_wrapper::log(const caller_info_t &caller, const char *fmt, ...) {
-            if (get_option(options_t::OPT_AUTO_UPDATE_TIME) && !prefix_format_.empty()) {
-                update();
-            }
-
-            char *log_buffer = detail::get_log_tls_buffer();
-            size_t log_size = 0;
-            {
-                if (!log_sinks_.empty()) {
-                    // format => "[Log    DEBUG][2015-01-12 10:09:08.]
-                    size_t start_index = log_formatter::format(log_buffer, LOG_WRAPPER_MAX_SIZE_PER_LINE, prefix_format_.c_str(),
-                                                               prefix_format_.size(), caller);
-
-                    va_list va_args;
-                    va_start(va_args, fmt);
-                    int prt_res =
-                        UTIL_STRFUNC_VSNPRINTF(&log_buffer[start_index], LOG_WRAPPER_MAX_SIZE_PER_LINE - start_index, fmt, va_args);
-                    va_end(va_args);
-                    if (prt_res >= 0) {
-                        start_index += static_cast<size_t>(prt_res);
-                    }
-
-                    if (start_index < LOG_WRAPPER_MAX_SIZE_PER_LINE) {
-                        log_buffer[start_index] = 0;
-                        log_size = start_index;
-                    } else {
-                        log_size = LOG_WRAPPER_MAX_SIZE_PER_LINE;
-                        log_buffer[LOG_WRAPPER_MAX_SIZE_PER_LINE - 1] = 0;
-                    }
-                }
-            }
-
-            write_log(caller, log_buffer, log_size);
-        }
-
-        void log_wrapper::write_log(const caller_info_t &caller, const char *content, size_t content_size) {
-            for (std::list<log_router_t>::iterator iter = log_sinks_.begin(); iter != log_sinks_.end(); ++iter) {
-                if (caller.level_id >= iter->level_min && caller.level_id <= iter->level_max) {
-                    iter->handle(caller, content, content_size);
-                }
-            }
-        }
-
-        log_wrapper *log_wrapper::mutable_log_cat(uint32_t cats) {
-            if (log_wrapper::destroyed_) {
-                return NULL;
-            }
-
-            static log_wrapper all_logger[categorize_t::MAX];
-
-            if (cats >= categorize_t::MAX) {
-                return NULL;
-            }
-
-            return &all_logger[cats];
-        }
-    }
-}
+﻿#include "std/thread.h"
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdarg.h>
+
+
+#include "common/string_oprs.h"
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+
+#include "time/time_utility.h"
+
+#include "log/log_async_pipeline.h"
+#include "log/log_binary_codec.h"
+#include "log/log_formatter.h"
+#include "log/log_stats.h"
+#include "log/log_wrapper.h"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+namespace util {
+    namespace log {
+        namespace detail {
+            /**
+             * @brief 每个线程的日志缓冲区，第一次使用时分配，按需增长到LOG_WRAPPER_MAX_SIZE_PER_LINE
+             */
+            struct log_tls_buffer_t {
+                char *data;
+                size_t size;
+            };
+
+            static void free_log_tls_buffer(log_tls_buffer_t *block) {
+                if (NULL != block && NULL != block->data) {
+                    delete[] block->data;
+                    block->data = NULL;
+                    block->size = 0;
+                }
+            }
+
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+            static log_tls_buffer_t *get_log_tls_buffer_block() {
+                static THREAD_TLS log_tls_buffer_t ret = {NULL, 0};
+                return &ret;
+            }
+
+#if !defined(_WIN32)
+            // 线程局部变量不能有析构函数，借助pthread_key在线程退出时释放缓冲区
+            static pthread_once_t gt_get_log_tls_once = PTHREAD_ONCE_INIT;
+            static pthread_key_t gt_get_log_tls_key;
+
+            static void dtor_pthread_get_log_tls(void *p) { free_log_tls_buffer(reinterpret_cast<log_tls_buffer_t *>(p)); }
+
+            static void init_pthread_get_log_tls() { (void)pthread_key_create(&gt_get_log_tls_key, dtor_pthread_get_log_tls); }
+
+            static void register_log_tls_buffer(log_tls_buffer_t *block) {
+                (void)pthread_once(&gt_get_log_tls_once, init_pthread_get_log_tls);
+                pthread_setspecific(gt_get_log_tls_key, block);
+            }
+#else
+            // Windows下线程退出时不会自动释放，需要调用log_wrapper::release_tls_buffer
+            static void register_log_tls_buffer(log_tls_buffer_t *) {}
+#endif
+
+#else
+            static pthread_once_t gt_get_log_tls_once = PTHREAD_ONCE_INIT;
+            static pthread_key_t gt_get_log_tls_key;
+
+            static void dtor_pthread_get_log_tls(void *p) {
+                log_tls_buffer_t *block = reinterpret_cast<log_tls_buffer_t *>(p);
+                if (NULL != block) {
+                    free_log_tls_buffer(block);
+                    delete block;
+                }
+            }
+
+            static void init_pthread_get_log_tls() { (void)pthread_key_create(&gt_get_log_tls_key, dtor_pthread_get_log_tls); }
+
+            static log_tls_buffer_t *get_log_tls_buffer_block() {
+                (void)pthread_once(&gt_get_log_tls_once, init_pthread_get_log_tls);
+                log_tls_buffer_t *block = reinterpret_cast<log_tls_buffer_t *>(pthread_getspecific(gt_get_log_tls_key));
+                if (NULL == block) {
+                    block = new log_tls_buffer_t();
+                    block->data = NULL;
+                    block->size = 0;
+                    pthread_setspecific(gt_get_log_tls_key, block);
+                }
+                return block;
+            }
+
+            static void register_log_tls_buffer(log_tls_buffer_t *) {}
+#endif
+
+            /**
+             * @brief 获取至少sz字节的线程缓冲区(不超过LOG_WRAPPER_MAX_SIZE_PER_LINE)
+             * @param sz 需要的长度
+             * @param keep_size 增长时需要保留的已有数据长度
+             * @return 缓冲区，长度为get_log_tls_buffer_block()->size，分配失败返回NULL
+             */
+            static char *reserve_log_tls_buffer(size_t sz, size_t keep_size) {
+                log_tls_buffer_t *block = get_log_tls_buffer_block();
+                if (NULL == block) {
+                    return NULL;
+                }
+
+                if (sz > LOG_WRAPPER_MAX_SIZE_PER_LINE) {
+                    sz = LOG_WRAPPER_MAX_SIZE_PER_LINE;
+                }
+
+                if (NULL != block->data && block->size >= sz) {
+                    return block->data;
+                }
+
+                // 按2倍增长，减少反复格式化的次数
+                size_t new_size = block->size > 0 ? block->size : LOG_WRAPPER_TLS_BUFFER_INIT_SIZE;
+                while (new_size < sz) {
+                    new_size <<= 1;
+                }
+                if (new_size > LOG_WRAPPER_MAX_SIZE_PER_LINE) {
+                    new_size = LOG_WRAPPER_MAX_SIZE_PER_LINE;
+                }
+
+                char *new_data = new (std::nothrow) char[new_size];
+                if (NULL == new_data) {
+                    return block->data;
+                }
+
+                bool first_alloc = NULL == block->data;
+                if (!first_alloc) {
+                    if (keep_size > block->size) {
+                        keep_size = block->size;
+                    }
+                    if (keep_size > 0) {
+                        memcpy(new_data, block->data, keep_size);
+                    }
+                    delete[] block->data;
+                }
+
+                block->data = new_data;
+                block->size = new_size;
+                if (first_alloc) {
+                    register_log_tls_buffer(block);
+                }
+                return block->data;
+            }
+
+            static inline size_t get_log_tls_buffer_size() { return get_log_tls_buffer_block()->size; }
+        }
+    }
+}
+
+namespace util {
+    namespace log {
+        bool log_wrapper::destroyed_ = false;
+        util::lock::atomic_int_type<int> log_wrapper::category_levels_[log_wrapper::categorize_t::MAX];
+
+        log_wrapper::log_wrapper()
+            : log_level_(level_t::LOG_LW_DISABLED), category_(categorize_t::MAX), sink_id_alloc_(0), kv_format_(log_kv_encoder::format_t::EN_KV_FMT_JSON) {
+            update();
+
+            // 默认在写日志时读取系统的粗略时间，通过time_utility::update(t)指定的时间仍然有效
+            set_option(options_t::OPT_AUTO_UPDATE_TIME, false);
+            set_option(options_t::OPT_CAPTURE_TIME, true);
+            prefix_format_.compile("[Log %L][%F %T.%f][%s:%n(%C)]: ");
+        }
+
+        log_wrapper::~log_wrapper() {
+            // 先停止异步管线，此时所有分类的落地接口都还有效
+            log_async_pipeline::shutdown();
+
+            log_wrapper::destroyed_ = true;
+
+            // 重置level，只要内存没释放，就还可以内存访问，但是不能写出日志
+            log_level_ = level_t::LOG_LW_DISABLED;
+            for (uint32_t i = 0; i < categorize_t::MAX; ++i) {
+                category_levels_[i].store(level_t::LOG_LW_DISABLED, util::lock::memory_order_relaxed);
+            }
+        }
+
+        int32_t log_wrapper::init(level_t::type level) {
+            set_level(level);
+
+            return 0;
+        }
+
+        void log_wrapper::sync_level_cache() {
+            if (log_wrapper::destroyed_ || category_ >= categorize_t::MAX) {
+                return;
+            }
+
+            category_levels_[category_].store(log_level_, util::lock::memory_order_relaxed);
+        }
+
+        log_wrapper::sink_table_ptr_t log_wrapper::get_sinks() const {
+            lock::lock_holder<lock::spin_lock> lkholder(sink_lock_);
+            return sinks_;
+        }
+
+        uint32_t log_wrapper::add_sink(log_handler_t h, level_t::type level_min, level_t::type level_max) {
+            if (!h) {
+                return 0;
+            }
+
+            log_router_ptr_t router = std::make_shared<log_router_t>();
+            if (!router) {
+                return 0;
+            }
+
+            router->handle = h;
+            router->level_min = level_min;
+            router->level_max = level_max;
+            router->stats = std::make_shared<log_sink_stats_t>();
+
+            // 修改落地接口的操作之间互斥，写日志时只在复制指针时加锁
+            lock::lock_holder<lock::spin_lock> lkholder(sink_modify_lock_);
+            router->sink_id = ++sink_id_alloc_;
+            if (0 == router->sink_id) {
+                router->sink_id = ++sink_id_alloc_;
+            }
+
+            sink_table_ptr_t old_table = get_sinks();
+            std::vector<log_router_ptr_t> routers;
+            if (old_table) {
+                routers = old_table->routers;
+            }
+            routers.push_back(router);
+            reset_sinks(routers);
+
+            return router->sink_id;
+        }
+
+        bool log_wrapper::remove_sink(uint32_t sink_id) {
+            lock::lock_holder<lock::spin_lock> lkholder(sink_modify_lock_);
+            sink_table_ptr_t old_table = get_sinks();
+            if (!old_table) {
+                return false;
+            }
+
+            std::vector<log_router_ptr_t> routers;
+            routers.reserve(old_table->routers.size());
+            for (size_t i = 0; i < old_table->routers.size(); ++i) {
+                if (old_table->routers[i]->sink_id != sink_id) {
+                    routers.push_back(old_table->routers[i]);
+                }
+            }
+
+            if (routers.size() == old_table->routers.size()) {
+                return false;
+            }
+
+            reset_sinks(routers);
+            return true;
+        }
+
+        void log_wrapper::clear_sinks() {
+            lock::lock_holder<lock::spin_lock> lkholder(sink_modify_lock_);
+            reset_sinks(std::vector<log_router_ptr_t>());
+        }
+
+        void log_wrapper::reset_sinks(const std::vector<log_router_ptr_t> &routers) {
+            sink_table_ptr_t new_table;
+            if (!routers.empty()) {
+                std::shared_ptr<sink_table_t> table = std::make_shared<sink_table_t>();
+                table->routers = routers;
+                for (size_t i = 0; i < routers.size(); ++i) {
+                    for (int lv = routers[i]->level_min; lv <= routers[i]->level_max && lv <= level_t::LOG_LW_DEBUG; ++lv) {
+                        if (lv >= 0) {
+                            table->levels[lv].push_back(routers[i].get());
+                        }
+                    }
+                }
+                new_table = table;
+            }
+
+            // 旧表在最后一个持有者释放引用后销毁
+            sink_table_ptr_t old_table;
+            {
+                lock::lock_holder<lock::spin_lock> lkholder(sink_lock_);
+                old_table.swap(sinks_);
+                sinks_ = new_table;
+                sink_size_.store(routers.size(), util::lock::memory_order_release);
+            }
+        }
+
+        void log_wrapper::update() {}
+
+        void log_wrapper::stamp_time(caller_info_t &caller) const {
+            if (get_option(options_t::OPT_AUTO_UPDATE_TIME)) {
+                time_t sec, nsec;
+                util::time::time_utility::get_sys_now(sec, nsec);
+                caller.log_time = sec;
+                caller.log_time_nsec = static_cast<uint32_t>(nsec);
+            } else if (get_option(options_t::OPT_CAPTURE_TIME) && !util::time::time_utility::is_custom_now()) {
+                time_t sec, nsec;
+                util::time::time_utility::get_sys_now_coarse(sec, nsec);
+                caller.log_time = sec;
+                caller.log_time_nsec = static_cast<uint32_t>(nsec);
+            } else {
+                // 秒和微秒需要来自同一次update，分开读取可能跨过秒切换
+                time_t sec, usec;
+                util::time::time_utility::get_now(sec, usec);
+                caller.log_time = sec;
+                caller.log_time_nsec = static_cast<uint32_t>(usec * 1000);
+            }
+        }
+
+        void log_wrapper::log(const caller_info_t &input_caller, const char *fmt, ...) {
+            if (get_option(options_t::OPT_AUTO_UPDATE_TIME) && !prefix_format_.empty()) {
+                update();
+            }
+
+            // 在调用处记录时间，异步写出时也能保证时间准确
+            caller_info_t caller = input_caller;
+            if (0 == caller.log_time && prefix_format_.has_time_var()) {
+                stamp_time(caller);
+            }
+
+            if (0 == get_sink_size()) {
+                return;
+            }
+
+            uint64_t format_begin_ns = get_option(options_t::OPT_STATS_LATENCY) ? log_stats::now_ns() : 0;
+
+            // 先用当前的缓冲区格式化，放不下时再扩大缓冲区重新格式化参数部分
+            char *log_buffer = detail::reserve_log_tls_buffer(0, 0);
+            if (NULL == log_buffer) {
+                return;
+            }
+
+            size_t bufz = detail::get_log_tls_buffer_size();
+            // format => "[Log    DEBUG][2015-01-12 10:09:08.]
+            size_t start_index = log_formatter::format(log_buffer, bufz, prefix_format_, caller);
+            size_t log_size = start_index;
+            while (true) {
+                va_list va_args;
+                va_start(va_args, fmt);
+                int prt_res = UTIL_STRFUNC_VSNPRINTF(&log_buffer[start_index], bufz - start_index, fmt, va_args);
+                va_end(va_args);
+
+                if (prt_res < 0) {
+                    // 部分平台缓冲区不足时返回-1，不知道需要的长度，只能成倍扩大
+                    if (bufz >= LOG_WRAPPER_MAX_SIZE_PER_LINE) {
+                        log_size = bufz - 1;
+                        break;
+                    }
+                    log_buffer = detail::reserve_log_tls_buffer(bufz << 1, start_index);
+                } else if (start_index + static_cast<size_t>(prt_res) < bufz) {
+                    log_size = start_index + static_cast<size_t>(prt_res);
+                    break;
+                } else if (bufz >= LOG_WRAPPER_MAX_SIZE_PER_LINE) {
+                    log_size = bufz - 1;
+                    break;
+                } else {
+                    log_buffer = detail::reserve_log_tls_buffer(start_index + static_cast<size_t>(prt_res) + 1, start_index);
+                }
+
+                // 分配失败时保留已有的缓冲区和截断的内容
+                if (NULL == log_buffer || detail::get_log_tls_buffer_size() <= bufz) {
+                    log_buffer = detail::reserve_log_tls_buffer(0, 0);
+                    log_size = bufz - 1;
+                    break;
+                }
+                bufz = detail::get_log_tls_buffer_size();
+            }
+
+            log_buffer[log_size] = 0;
+            if (0 != format_begin_ns) {
+                log_stats::add_format_latency(category_, log_stats::now_ns() - format_begin_ns);
+            }
+            write_log(caller, log_buffer, log_size);
+        }
+
+        void log_wrapper::log_binary(const caller_info_t *caller, const char *fmt, ...) {
+            if (NULL == caller || NULL == fmt || 0 == get_sink_size()) {
+                return;
+            }
+
+            if (get_option(options_t::OPT_AUTO_UPDATE_TIME)) {
+                update();
+            }
+
+            caller_info_t stamped_caller = *caller;
+            stamp_time(stamped_caller);
+
+            // 参数数据放在缓冲区后半段，同步写出时前半段用于输出文本
+            char *log_buffer = detail::reserve_log_tls_buffer(0, 0);
+            if (NULL == log_buffer) {
+                return;
+            }
+
+            size_t bufz = detail::get_log_tls_buffer_size();
+            size_t data_size;
+            while (true) {
+                bool truncated = false;
+                va_list va_args;
+                va_start(va_args, fmt);
+                data_size = log_binary_codec::encode(log_buffer + bufz / 2, bufz / 2, fmt, va_args, &truncated);
+                va_end(va_args);
+
+                if (!truncated || bufz >= LOG_WRAPPER_MAX_SIZE_PER_LINE) {
+                    break;
+                }
+
+                log_buffer = detail::reserve_log_tls_buffer(bufz << 1, 0);
+                if (NULL == log_buffer || detail::get_log_tls_buffer_size() <= bufz) {
+                    // 分配失败时需要用原来的缓冲区重新编码
+                    log_buffer = detail::reserve_log_tls_buffer(0, 0);
+                    va_start(va_args, fmt);
+                    data_size = log_binary_codec::encode(log_buffer + bufz / 2, bufz / 2, fmt, va_args);
+                    va_end(va_args);
+                    break;
+                }
+                bufz = detail::get_log_tls_buffer_size();
+            }
+            log_buffer += bufz / 2;
+
+            if (get_option(options_t::OPT_ASYNC_WRITE) &&
+                log_async_pipeline::instance().push_binary(this, stamped_caller, fmt, log_buffer, data_size)) {
+                return;
+            }
+
+            write_binary(stamped_caller, fmt, log_buffer, data_size);
+        }
+
+        void log_wrapper::log_kv(const caller_info_t &input_caller, const log_kv_field_t *fields, size_t field_count) {
+            if (0 == get_sink_size()) {
+                return;
+            }
+
+            if (get_option(options_t::OPT_AUTO_UPDATE_TIME)) {
+                update();
+            }
+
+            caller_info_t caller = input_caller;
+            if (0 == caller.log_time) {
+                stamp_time(caller);
+            }
+
+            uint64_t format_begin_ns = get_option(options_t::OPT_STATS_LATENCY) ? log_stats::now_ns() : 0;
+
+            // 直接编码到线程缓冲区，放不下时扩大缓冲区重新编码
+            char *log_buffer = detail::reserve_log_tls_buffer(0, 0);
+            size_t log_size = 0;
+            while (NULL != log_buffer) {
+                size_t bufz = detail::get_log_tls_buffer_size();
+                log_kv_encoder encoder(log_buffer, bufz, kv_format_);
+                encoder.add_caller(caller);
+                for (size_t i = 0; NULL != fields && i < field_count; ++i) {
+                    encoder.add(fields[i]);
+                }
+
+                log_size = encoder.finish();
+                if (!encoder.is_truncated() || bufz >= LOG_WRAPPER_MAX_SIZE_PER_LINE) {
+                    break;
+                }
+
+                char *new_buffer = detail::reserve_log_tls_buffer(bufz << 1, 0);
+                if (NULL == new_buffer || detail::get_log_tls_buffer_size() <= bufz) {
+                    log_buffer = detail::reserve_log_tls_buffer(0, 0);
+                    break;
+                }
+                log_buffer = new_buffer;
+            }
+
+            if (NULL == log_buffer) {
+                return;
+            }
+
+            if (0 != format_begin_ns) {
+                log_stats::add_format_latency(category_, log_stats::now_ns() - format_begin_ns);
+            }
+            write_log(caller, log_buffer, log_size);
+        }
+
+        void log_wrapper::log_segments(const caller_info_t &input_caller, const char *const *segments, const size_t *segment_sizes,
+                                       size_t segment_count) {
+            if (get_option(options_t::OPT_AUTO_UPDATE_TIME) && !prefix_format_.empty()) {
+                update();
+            }
+
+            caller_info_t caller = input_caller;
+            if (0 == caller.log_time && prefix_format_.has_time_var()) {
+                stamp_time(caller);
+            }
+
+            if (0 == get_sink_size()) {
+                return;
+            }
+
+            uint64_t format_begin_ns = get_option(options_t::OPT_STATS_LATENCY) ? log_stats::now_ns() : 0;
+
+            size_t content_size = 0;
+            for (size_t i = 0; NULL != segments && NULL != segment_sizes && i < segment_count; ++i) {
+                if (NULL != segments[i]) {
+                    content_size += segment_sizes[i];
+                }
+            }
+
+            char *log_buffer = detail::reserve_log_tls_buffer(0, 0);
+            if (NULL == log_buffer) {
+                return;
+            }
+
+            size_t bufz = detail::get_log_tls_buffer_size();
+            size_t log_size = log_formatter::format(log_buffer, bufz, prefix_format_, caller);
+
+            // 总长度已知，最多只需要扩大一次缓冲区
+            if (log_size + content_size + 1 > bufz) {
+                char *new_buffer = detail::reserve_log_tls_buffer(log_size + content_size + 1, log_size);
+                if (NULL != new_buffer) {
+                    log_buffer = new_buffer;
+                    bufz = detail::get_log_tls_buffer_size();
+                }
+            }
+
+            for (size_t i = 0; content_size > 0 && i < segment_count && log_size + 1 < bufz; ++i) {
+                if (NULL == segments[i]) {
+                    continue;
+                }
+
+                size_t copy_size = segment_sizes[i];
+                if (log_size + copy_size + 1 > bufz) {
+                    copy_size = bufz - log_size - 1;
+                }
+                memcpy(log_buffer + log_size, segments[i], copy_size);
+                log_size += copy_size;
+            }
+
+            log_buffer[log_size] = 0;
+            if (0 != format_begin_ns) {
+                log_stats::add_format_latency(category_, log_stats::now_ns() - format_begin_ns);
+            }
+            write_log(caller, log_buffer, log_size);
+        }
+
+        void log_wrapper::write_binary(const caller_info_t &caller, const char *fmt, const char *data, size_t data_size) {
+            if (0 == get_sink_size()) {
+                return;
+            }
+
+            char *log_buffer = detail::reserve_log_tls_buffer(0, 0);
+            if (NULL == log_buffer) {
+                return;
+            }
+
+            size_t bufz = detail::get_log_tls_buffer_size();
+            // 参数数据本身在当前线程的缓冲区中时不能覆盖它，也不能扩大缓冲区
+            bool data_in_buffer = data >= log_buffer && data < log_buffer + bufz;
+            if (data_in_buffer) {
+                bufz = static_cast<size_t>(data - log_buffer);
+                if (0 == bufz) {
+                    return;
+                }
+            }
+
+            uint64_t format_begin_ns = get_option(options_t::OPT_STATS_LATENCY) ? log_stats::now_ns() : 0;
+            size_t log_size;
+            while (true) {
+                log_size = log_formatter::format(log_buffer, bufz, prefix_format_, caller);
+                if (log_size + 1 < bufz) {
+                    log_size += log_binary_codec::decode(&log_buffer[log_size], bufz - log_size, fmt, data, data_size);
+                } else {
+                    log_size = bufz - 1;
+                    log_buffer[log_size] = 0;
+                }
+
+                // 解码后的文本正好填满缓冲区时可能被截断了
+                if (data_in_buffer || log_size + 1 < bufz || bufz >= LOG_WRAPPER_MAX_SIZE_PER_LINE) {
+                    break;
+                }
+
+                char *new_buffer = detail::reserve_log_tls_buffer(bufz << 1, 0);
+                if (NULL == new_buffer || detail::get_log_tls_buffer_size() <= bufz) {
+                    // 分配失败时原来的缓冲区和内容仍然有效
+                    log_buffer = detail::reserve_log_tls_buffer(0, 0);
+                    break;
+                }
+
+                log_buffer = new_buffer;
+                bufz = detail::get_log_tls_buffer_size();
+            }
+
+            if (0 != format_begin_ns) {
+                log_stats::add_format_latency(category_, log_stats::now_ns() - format_begin_ns);
+            }
+            write_sinks(caller, log_buffer, log_size);
+        }
+
+        void log_wrapper::write_log(const caller_info_t &caller, const char *content, size_t content_size) {
+            if (get_option(options_t::OPT_ASYNC_WRITE) && log_async_pipeline::instance().push(this, caller, content, content_size)) {
+                return;
+            }
+
+            write_sinks(caller, content, content_size);
+        }
+
+        void log_wrapper::write_sinks(const caller_info_t &caller, const char *content, size_t content_size) {
+            if (caller.level_id < 0 || caller.level_id > level_t::LOG_LW_DEBUG) {
+                return;
+            }
+
+            // 持有当前表的引用，写出过程中其他线程可以修改落地接口
+            sink_table_ptr_t table = get_sinks();
+            if (!table) {
+                return;
+            }
+
+            const std::vector<const log_router_t *> &routers = table->levels[caller.level_id];
+            if (routers.empty()) {
+                return;
+            }
+
+            log_stats::add_line(category_, caller.level_id, static_cast<uint64_t>(content_size) * routers.size());
+            if (!get_option(options_t::OPT_STATS_LATENCY)) {
+                for (size_t i = 0; i < routers.size(); ++i) {
+                    routers[i]->handle(caller, content, content_size);
+                    log_stats::add_sink_line(*routers[i], content_size);
+                }
+                return;
+            }
+
+            for (size_t i = 0; i < routers.size(); ++i) {
+                uint64_t begin_ns = log_stats::now_ns();
+                routers[i]->handle(caller, content, content_size);
+                uint64_t cost_ns = log_stats::now_ns() - begin_ns;
+                log_stats::add_sink_latency(category_, cost_ns);
+                log_stats::add_sink_line(*routers[i], content_size);
+                log_stats::add_sink_latency(*routers[i], cost_ns);
+            }
+        }
+
+        bool log_wrapper::setup_categories(log_wrapper *all_logger) {
+            for (uint32_t i = 0; i < categorize_t::MAX; ++i) {
+                all_logger[i].category_ = i;
+            }
+
+            return true;
+        }
+
+        void log_wrapper::release_tls_buffer() { detail::free_log_tls_buffer(detail::get_log_tls_buffer_block()); }
+
+        log_wrapper *log_wrapper::mutable_log_cat(uint32_t cats) {
+            if (log_wrapper::destroyed_) {
+                return NULL;
+            }
+
+            static log_wrapper all_logger[categorize_t::MAX];
+            static bool categories_ready = setup_categories(all_logger);
+            (void)categories_ready;
+
+            if (cats >= categorize_t::MAX) {
+                return NULL;
+            }
+
+            return &all_logger[cats];
+        }
+    }
+}
@@ -1,75 +1,185 @@
-﻿#include "log/log_wrapper.h"
-
-#include "log/lua_log_adaptor.h"
-
-#ifndef LOG_WRAPPER_DISABLE_LUA_SUPPORT
-
-static int lua_log_adaptor_fn_lua_log(lua_State *L) {
-    int top = lua_gettop(L);
-    if (top < 2) {
-        WLOGERROR("call lua function: lua_log without log level.");
-        return 0;
-    }
-
-    // log 分类
-    uint32_t cat = static_cast<uint32_t>(luaL_checkinteger(L, 1));
-
-    util::log::log_wrapper::level_t::type level = WLOG_LEVELID(luaL_checkinteger(L, 2));
-
-    util::log::log_wrapper *logger = WDTLOGGETCAT(cat);
-    if (NULL != logger && logger->check(level)) {
-        // TODO: 是否填充lua文件名和行号？但是那个操作比较耗性能
-        util::log::log_wrapper::caller_info_t caller(level, "Lua", NULL, 0, NULL);
-
-        for (int i = 3; i <= top; ++i) {
-            const char *content = lua_tostring(L, i);
-            if (NULL != content) {
-                logger->log(caller, "%s", content);
-            }
-        }
-    }
-
-    return 0;
-}
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-int lua_log_adaptor_openLib(lua_State *L) {
-    lua_newtable(L);
-
-    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_DISABLED));
-    lua_setfield(L, -2, "DISABLED");
-
-    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_FATAL));
-    lua_setfield(L, -2, "FATAL");
-
-    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_ERROR));
-    lua_setfield(L, -2, "ERROR");
-
-    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_WARNING));
-    lua_setfield(L, -2, "WARNING");
-
-    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_INFO));
-    lua_setfield(L, -2, "INFO");
-
-    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_NOTICE));
-    lua_setfield(L, -2, "NOTICE");
-
-    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_DEBUG));
-    lua_setfield(L, -2, "DEBUG");
-
-    lua_setglobal(L, "lua_log_level_t");
-
-    lua_pushcfunction(L, lua_log_adaptor_fn_lua_log);
-    lua_setglobal(L, "lua_log");
-
-    return 0;
-}
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif
+﻿#include "std/thread.h"
+#include <cstring>
+#include <set>
+#include <string>
+
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+
+#include "log/log_wrapper.h"
+
+#include "log/lua_log_adaptor.h"
+
+#ifndef LOG_WRAPPER_DISABLE_LUA_SUPPORT
+
+#ifndef LUA_LOG_ADAPTOR_MAX_SEGMENTS
+#define LUA_LOG_ADAPTOR_MAX_SEGMENTS 32
+#endif
+
+// 保留的lua文件路径数量上限，超过后新的路径不再输出
+#ifndef LUA_LOG_ADAPTOR_MAX_SOURCES
+#define LUA_LOG_ADAPTOR_MAX_SOURCES 4096
+#endif
+
+// lua_Debug只在前缀中使用文件路径或行号时才获取，获取调用栈信息比较耗性能
+// lua_Debug::short_src在下一次获取时会被覆盖，不能直接放进caller
+static lua_Debug *lua_log_adaptor_get_debug(lua_State *L) {
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+    static THREAD_TLS lua_Debug ret;
+#else
+    static lua_Debug ret;
+#endif
+    if (0 == lua_getstack(L, 1, &ret) || 0 == lua_getinfo(L, "Sl", &ret)) {
+        return NULL;
+    }
+
+    return &ret;
+}
+
+// 异步写出时caller会被复制到后台线程，文件路径需要一直有效，所以复制一份后保留到进程结束
+// lua文件的数量有限，相同的路径复用同一份，线程内先和上一次的结果比较，不需要加锁
+static const char *lua_log_adaptor_get_source(const char *short_src) {
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+    static THREAD_TLS const char *last_source = NULL;
+    if (NULL != last_source && 0 == strcmp(last_source, short_src)) {
+        return last_source;
+    }
+#endif
+
+    // 后台线程可能在全局变量析构后还在写日志，所以不释放
+    static util::lock::spin_lock sources_lock;
+    static std::set<std::string> *sources = new std::set<std::string>();
+
+    const char *ret = NULL;
+    {
+        util::lock::lock_holder<util::lock::spin_lock> lkholder(sources_lock);
+        std::set<std::string>::iterator iter = sources->find(short_src);
+        if (iter != sources->end()) {
+            ret = iter->c_str();
+        } else if (sources->size() < LUA_LOG_ADAPTOR_MAX_SOURCES) {
+            ret = sources->insert(short_src).first->c_str();
+        }
+    }
+
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+    if (NULL != ret) {
+        last_source = ret;
+    }
+#endif
+    return ret;
+}
+
+static int lua_log_adaptor_fn_lua_log(lua_State *L) {
+    int top = lua_gettop(L);
+    if (top < 2) {
+        WLOGERROR("call lua function: lua_log without log level.");
+        return 0;
+    }
+
+    // log 分类
+    uint32_t cat = static_cast<uint32_t>(luaL_checkinteger(L, 1));
+
+    util::log::log_wrapper::level_t::type level = WLOG_LEVELID(luaL_checkinteger(L, 2));
+
+    // 先检查缓存的分类级别，关闭的级别不做任何字符串转换
+    if (!util::log::log_wrapper::check_level(cat, level)) {
+        return 0;
+    }
+
+    util::log::log_wrapper *logger = WDTLOGGETCAT(cat);
+    if (NULL == logger || !logger->check(level)) {
+        return 0;
+    }
+
+    util::log::log_wrapper::caller_info_t caller(level, "Lua", NULL, 0, NULL);
+    if (logger->get_compiled_prefix_format().has_source_var()) {
+        lua_Debug *ar = lua_log_adaptor_get_debug(L);
+        if (NULL != ar) {
+            caller.file_path = lua_log_adaptor_get_source(ar->short_src);
+            caller.line_number = ar->currentline > 0 ? static_cast<uint32_t>(ar->currentline) : 0;
+        }
+    }
+
+    // 所有参数拼接成一条日志，参数太多时先在lua中拼接
+    const char *segments[LUA_LOG_ADAPTOR_MAX_SEGMENTS];
+    size_t segment_sizes[LUA_LOG_ADAPTOR_MAX_SEGMENTS];
+    size_t segment_count = 0;
+    if (top - 2 <= LUA_LOG_ADAPTOR_MAX_SEGMENTS) {
+        for (int i = 3; i <= top; ++i) {
+            segments[segment_count] = lua_tolstring(L, i, &segment_sizes[segment_count]);
+            if (NULL != segments[segment_count]) {
+                ++segment_count;
+            }
+        }
+    } else {
+        luaL_Buffer buffer;
+        luaL_buffinit(L, &buffer);
+        for (int i = 3; i <= top; ++i) {
+            size_t len = 0;
+            const char *content = lua_tolstring(L, i, &len);
+            if (NULL != content) {
+                luaL_addlstring(&buffer, content, len);
+            }
+        }
+        luaL_pushresult(&buffer);
+
+        segments[0] = lua_tolstring(L, -1, &segment_sizes[0]);
+        segment_count = NULL == segments[0] ? 0 : 1;
+    }
+
+    logger->log_segments(caller, segments, segment_sizes, segment_count);
+    return 0;
+}
+
+static int lua_log_adaptor_fn_lua_log_check(lua_State *L) {
+    uint32_t cat = static_cast<uint32_t>(luaL_checkinteger(L, 1));
+    util::log::log_wrapper::level_t::type level = WLOG_LEVELID(luaL_checkinteger(L, 2));
+
+    lua_pushboolean(L, util::log::log_wrapper::check_level(cat, level) ? 1 : 0);
+    return 1;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int lua_log_adaptor_openLib(lua_State *L) {
+    lua_newtable(L);
+
+    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_DISABLED));
+    lua_setfield(L, -2, "DISABLED");
+
+    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_FATAL));
+    lua_setfield(L, -2, "FATAL");
+
+    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_ERROR));
+    lua_setfield(L, -2, "ERROR");
+
+    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_WARNING));
+    lua_setfield(L, -2, "WARNING");
+
+    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_INFO));
+    lua_setfield(L, -2, "INFO");
+
+    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_NOTICE));
+    lua_setfield(L, -2, "NOTICE");
+
+    lua_pushinteger(L, static_cast<lua_Integer>(util::log::log_wrapper::level_t::LOG_LW_DEBUG));
+    lua_setfield(L, -2, "DEBUG");
+
+    lua_setglobal(L, "lua_log_level_t");
+
+    lua_pushcfunction(L, lua_log_adaptor_fn_lua_log);
+    lua_setglobal(L, "lua_log");
+
+    lua_pushcfunction(L, lua_log_adaptor_fn_lua_log_check);
+    lua_setglobal(L, "lua_log_check");
+
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,158 @@
+﻿#include <cstdlib>
+#include <cstring>
+
+#include "mem_pool/monotonic_arena.h"
+
+namespace util {
+    namespace mempool {
+        monotonic_arena::monotonic_arena(size_t block_size)
+            : head_(NULL), current_(NULL), cur_(NULL), end_(NULL), block_size_(block_size > 0 ? block_size : MONOTONIC_ARENA_BLOCK_SIZE) {}
+
+        monotonic_arena::monotonic_arena(void *buffer, size_t buffer_size, size_t block_size)
+            : head_(NULL), current_(NULL), cur_(NULL), end_(NULL), block_size_(block_size > 0 ? block_size : MONOTONIC_ARENA_BLOCK_SIZE) {
+            if (NULL == buffer) {
+                return;
+            }
+
+            // 内存块头需要按指针对齐
+            uintptr_t begin = reinterpret_cast<uintptr_t>(buffer);
+            uintptr_t aligned = (begin + sizeof(void *) - 1) & ~static_cast<uintptr_t>(sizeof(void *) - 1);
+            if (buffer_size <= aligned - begin + sizeof(block_t)) {
+                return;
+            }
+
+            head_ = reinterpret_cast<block_t *>(aligned);
+            head_->next = NULL;
+            head_->size = buffer_size - (aligned - begin) - sizeof(block_t);
+            head_->external = true;
+            use_block(head_);
+        }
+
+        monotonic_arena::~monotonic_arena() { release(); }
+
+        char *monotonic_arena::strdup(const char *str, size_t len) {
+            char *ret = reinterpret_cast<char *>(allocate(len + 1, 1));
+            if (NULL == ret) {
+                return NULL;
+            }
+
+            if (len > 0) {
+                memcpy(ret, str, len);
+            }
+            ret[len] = 0;
+            return ret;
+        }
+
+        void monotonic_arena::rewind(const marker_t &marker) {
+            if (NULL == marker.block) {
+                reset();
+                return;
+            }
+
+            current_ = marker.block;
+            cur_ = marker.cur;
+            end_ = block_begin(current_) + current_->size;
+        }
+
+        void monotonic_arena::reset() {
+            if (NULL == head_) {
+                return;
+            }
+
+            use_block(head_);
+        }
+
+        void monotonic_arena::release() {
+            block_t *external = NULL;
+            while (NULL != head_) {
+                block_t *block = head_;
+                head_ = head_->next;
+
+                if (block->external) {
+                    external = block;
+                } else {
+                    free(block);
+                }
+            }
+
+            current_ = NULL;
+            cur_ = NULL;
+            end_ = NULL;
+
+            // 外部缓冲区一定是第一块，保留下来
+            if (NULL != external) {
+                external->next = NULL;
+                head_ = external;
+                use_block(head_);
+            }
+        }
+
+        size_t monotonic_arena::used() const {
+            if (NULL == current_) {
+                return 0;
+            }
+
+            size_t ret = 0;
+            for (block_t *block = head_; NULL != block && block != current_; block = block->next) {
+                ret += block->size;
+            }
+
+            return ret + static_cast<size_t>(cur_ - block_begin(current_));
+        }
+
+        size_t monotonic_arena::capacity() const {
+            size_t ret = 0;
+            for (block_t *block = head_; NULL != block; block = block->next) {
+                ret += block->size;
+            }
+            return ret;
+        }
+
+        void *monotonic_arena::allocate_slow(size_t sz, size_t align) {
+            // 先尝试reset后保留下来的内存块，放不下的跳过
+            for (block_t *block = (NULL == current_) ? head_ : current_->next; NULL != block; block = block->next) {
+                use_block(block);
+                uintptr_t aligned = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+                if (aligned + sz >= aligned && aligned + sz <= reinterpret_cast<uintptr_t>(end_)) {
+                    cur_ = reinterpret_cast<char *>(aligned + sz);
+                    return reinterpret_cast<void *>(aligned);
+                }
+            }
+
+            size_t data_size = block_size_;
+            if (sz + align > data_size) {
+                data_size = sz + align;
+                if (data_size < sz) {
+                    return NULL;
+                }
+            }
+
+            block_t *block = reinterpret_cast<block_t *>(malloc(sizeof(block_t) + data_size));
+            if (NULL == block) {
+                return NULL;
+            }
+            block->size = data_size;
+            block->external = false;
+
+            // 插入到当前内存块后面，保证rewind时后面的内存块都可以复用
+            if (NULL == current_) {
+                block->next = head_;
+                head_ = block;
+            } else {
+                block->next = current_->next;
+                current_->next = block;
+            }
+
+            use_block(block);
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+            cur_ = reinterpret_cast<char *>(aligned + sz);
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        void monotonic_arena::use_block(block_t *block) {
+            current_ = block;
+            cur_ = block_begin(block);
+            end_ = cur_ + block->size;
+        }
+    }
+}
@@ -0,0 +1,304 @@
+﻿#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "lock/lock_holder.h"
+#include "lock/spin_lock.h"
+#include "std/thread.h"
+
+#include "mem_pool/slab_allocator.h"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+namespace util {
+    namespace mempool {
+        namespace detail {
+            struct slab_free_node_t {
+                slab_free_node_t *next;
+            };
+
+            struct slab_central_t {
+                lock::spin_lock lock;
+                slab_free_node_t *head;
+                size_t count;
+            };
+
+            struct slab_registry_t {
+                slab_central_t centrals[slab_allocator::SIZE_CLASS_COUNT];
+                lock::spin_lock chunk_lock;
+                std::vector<void *> chunks;
+
+                slab_registry_t() {
+                    for (size_t i = 0; i < slab_allocator::SIZE_CLASS_COUNT; ++i) {
+                        centrals[i].head = NULL;
+                        centrals[i].count = 0;
+                    }
+                }
+            };
+
+            // 线程退出的时机可能晚于全局变量析构，并且内存块可能还在使用中，所以注册表不释放
+            static slab_registry_t *get_slab_registry() {
+                static slab_registry_t *ret = new slab_registry_t();
+                return ret;
+            }
+
+            /**
+             * @brief 每次和全局空闲链表交换的数量，线程缓存最多保留两倍
+             */
+            static inline size_t get_slab_batch_size(size_t cls) {
+                size_t ret = 8192 / slab_allocator::get_class_size(cls);
+                if (ret < 2) {
+                    return 2;
+                }
+                if (ret > 64) {
+                    return 64;
+                }
+                return ret;
+            }
+
+            // 调用前需要锁住全局空闲链表，把新的内存块切分后放入
+            static bool slab_alloc_chunk(slab_central_t &central, size_t cls) {
+                size_t obj_size = slab_allocator::get_class_size(cls);
+                char *chunk = reinterpret_cast<char *>(malloc(SLAB_ALLOCATOR_CHUNK_SIZE));
+                if (NULL == chunk) {
+                    return false;
+                }
+
+                slab_registry_t *registry = get_slab_registry();
+                {
+                    lock::lock_holder<lock::spin_lock> lkholder(registry->chunk_lock);
+                    registry->chunks.push_back(chunk);
+                }
+
+                size_t count = SLAB_ALLOCATOR_CHUNK_SIZE / obj_size;
+                for (size_t i = count; i > 0; --i) {
+                    slab_free_node_t *node = reinterpret_cast<slab_free_node_t *>(chunk + (i - 1) * obj_size);
+                    node->next = central.head;
+                    central.head = node;
+                }
+                central.count += count;
+                return true;
+            }
+
+            /**
+             * @brief 从全局空闲链表取出最多n个，返回链表头
+             */
+            static slab_free_node_t *slab_central_pop(size_t cls, size_t n, size_t &got) {
+                slab_central_t &central = get_slab_registry()->centrals[cls];
+                lock::lock_holder<lock::spin_lock> lkholder(central.lock);
+
+                got = 0;
+                if (NULL == central.head && !slab_alloc_chunk(central, cls)) {
+                    return NULL;
+                }
+
+                slab_free_node_t *ret = central.head;
+                slab_free_node_t *tail = ret;
+                got = 1;
+                while (got < n && NULL != tail->next) {
+                    tail = tail->next;
+                    ++got;
+                }
+
+                central.head = tail->next;
+                central.count -= got;
+                tail->next = NULL;
+                return ret;
+            }
+
+            /**
+             * @brief 把[head, tail]共n个放回全局空闲链表
+             */
+            static void slab_central_push(size_t cls, slab_free_node_t *head, slab_free_node_t *tail, size_t n) {
+                slab_central_t &central = get_slab_registry()->centrals[cls];
+                lock::lock_holder<lock::spin_lock> lkholder(central.lock);
+
+                tail->next = central.head;
+                central.head = head;
+                central.count += n;
+            }
+
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+            // POD类型，线程启动时为0
+            struct slab_thread_cache_t {
+                slab_free_node_t *heads[slab_allocator::SIZE_CLASS_COUNT];
+                size_t counts[slab_allocator::SIZE_CLASS_COUNT];
+                bool registered;
+            };
+
+            static THREAD_TLS slab_thread_cache_t gt_slab_thread_cache;
+
+            static void slab_thread_cache_flush(slab_thread_cache_t &cache) {
+                for (size_t cls = 0; cls < slab_allocator::SIZE_CLASS_COUNT; ++cls) {
+                    slab_free_node_t *head = cache.heads[cls];
+                    if (NULL == head) {
+                        continue;
+                    }
+
+                    slab_free_node_t *tail = head;
+                    while (NULL != tail->next) {
+                        tail = tail->next;
+                    }
+
+                    slab_central_push(cls, head, tail, cache.counts[cls]);
+                    cache.heads[cls] = NULL;
+                    cache.counts[cls] = 0;
+                }
+            }
+
+#if !defined(_WIN32)
+            static pthread_once_t gt_slab_tls_once = PTHREAD_ONCE_INIT;
+            static pthread_key_t gt_slab_tls_key;
+
+            static void slab_thread_cache_release(void *p) {
+                slab_thread_cache_t *cache = reinterpret_cast<slab_thread_cache_t *>(p);
+                if (NULL == cache) {
+                    return;
+                }
+
+                slab_thread_cache_flush(*cache);
+                cache->registered = false;
+            }
+
+            static void init_pthread_slab_tls() { (void)pthread_key_create(&gt_slab_tls_key, slab_thread_cache_release); }
+#endif
+
+            static slab_thread_cache_t &get_slab_thread_cache() {
+                slab_thread_cache_t &ret = gt_slab_thread_cache;
+                if (!ret.registered) {
+                    ret.registered = true;
+#if !defined(_WIN32)
+                    // 线程退出时归还到全局空闲链表，Windows下线程缓存不归还
+                    (void)pthread_once(&gt_slab_tls_once, init_pthread_slab_tls);
+                    pthread_setspecific(gt_slab_tls_key, &ret);
+#endif
+                }
+                return ret;
+            }
+#endif
+        }
+
+        void *slab_allocator::allocate(size_t sz) {
+            size_t cls = get_size_class(sz);
+            if (cls >= SIZE_CLASS_COUNT) {
+                return malloc(sz);
+            }
+
+            size_t got = 0;
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+            detail::slab_thread_cache_t &cache = detail::get_slab_thread_cache();
+            if (NULL == cache.heads[cls]) {
+                cache.heads[cls] = detail::slab_central_pop(cls, detail::get_slab_batch_size(cls), got);
+                cache.counts[cls] = got;
+                if (NULL == cache.heads[cls]) {
+                    return NULL;
+                }
+            }
+
+            detail::slab_free_node_t *ret = cache.heads[cls];
+            cache.heads[cls] = ret->next;
+            --cache.counts[cls];
+            return ret;
+#else
+            return detail::slab_central_pop(cls, 1, got);
+#endif
+        }
+
+        void slab_allocator::deallocate(void *p, size_t sz) {
+            if (NULL == p) {
+                return;
+            }
+
+            size_t cls = get_size_class(sz);
+            if (cls >= SIZE_CLASS_COUNT) {
+                free(p);
+                return;
+            }
+
+            detail::slab_free_node_t *node = reinterpret_cast<detail::slab_free_node_t *>(p);
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+            detail::slab_thread_cache_t &cache = detail::get_slab_thread_cache();
+            node->next = cache.heads[cls];
+            cache.heads[cls] = node;
+            ++cache.counts[cls];
+
+            // 超过上限时把后面的一批归还，保留最近释放的
+            size_t batch = detail::get_slab_batch_size(cls);
+            if (cache.counts[cls] >= batch * 2) {
+                detail::slab_free_node_t *keep_tail = node;
+                for (size_t i = 1; i < batch; ++i) {
+                    keep_tail = keep_tail->next;
+                }
+
+                detail::slab_free_node_t *head = keep_tail->next;
+                detail::slab_free_node_t *tail = head;
+                while (NULL != tail->next) {
+                    tail = tail->next;
+                }
+                keep_tail->next = NULL;
+
+                detail::slab_central_push(cls, head, tail, cache.counts[cls] - batch);
+                cache.counts[cls] = batch;
+            }
+#else
+            detail::slab_central_push(cls, node, node, 1);
+#endif
+        }
+
+        size_t slab_allocator::get_size_class(size_t sz) {
+            if (sz <= 128) {
+                return sz <= 16 ? 0 : (sz - 1) / 16;
+            }
+
+            if (sz > SLAB_ALLOCATOR_MAX_SIZE) {
+                return SIZE_CLASS_COUNT;
+            }
+
+            // (2^(g+7), 2^(g+8)]分为4级，每级2^(g+5)
+            size_t g = 0;
+            while ((static_cast<size_t>(256) << g) < sz) {
+                ++g;
+            }
+
+            size_t ret = 8 + g * 4 + ((sz - (static_cast<size_t>(128) << g) - 1) >> (g + 5));
+            return ret < SIZE_CLASS_COUNT ? ret : SIZE_CLASS_COUNT;
+        }
+
+        size_t slab_allocator::get_class_size(size_t cls) {
+            if (cls < 8) {
+                return (cls + 1) * 16;
+            }
+
+            if (cls >= SIZE_CLASS_COUNT) {
+                return 0;
+            }
+
+            size_t g = (cls - 8) / 4;
+            return (static_cast<size_t>(128) << g) + ((cls - 8) % 4 + 1) * (static_cast<size_t>(32) << g);
+        }
+
+        void slab_allocator::flush_thread_cache() {
+#if defined(THREAD_TLS_ENABLED) && 1 == THREAD_TLS_ENABLED
+            detail::slab_thread_cache_flush(detail::gt_slab_thread_cache);
+#endif
+        }
+
+        size_t slab_allocator::get_chunk_count() {
+            detail::slab_registry_t *registry = detail::get_slab_registry();
+            lock::lock_holder<lock::spin_lock> lkholder(registry->chunk_lock);
+            return registry->chunks.size();
+        }
+
+        size_t slab_allocator::get_central_free_count(size_t cls) {
+            if (cls >= SIZE_CLASS_COUNT) {
+                return 0;
+            }
+
+            detail::slab_central_t &central = detail::get_slab_registry()->centrals[cls];
+            lock::lock_holder<lock::spin_lock> lkholder(central.lock);
+            return central.count;
+        }
+    }
+}
@@ -0,0 +1,117 @@
+﻿#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+#include "log/log_category.h"
+
+namespace {
+    static std::vector<std::string> g_test_log_category_lines;
+
+    static void test_log_category_sink(const util::log::log_wrapper::caller_info_t &, const char *content, size_t content_size) {
+        g_test_log_category_lines.push_back(std::string(content, content_size));
+    }
+}
+
+CASE_TEST(log_category_test, hierarchy) {
+    util::log::log_category *http = util::log::log_category::get("log_category_test.net.http");
+    CASE_EXPECT_NE(NULL, http);
+    if (NULL == http) {
+        return;
+    }
+
+    // 父分类自动注册，重复获取返回同一个对象
+    util::log::log_category *net = util::log::log_category::find("log_category_test.net");
+    util::log::log_category *top = util::log::log_category::find("log_category_test");
+    CASE_EXPECT_NE(NULL, net);
+    CASE_EXPECT_NE(NULL, top);
+    CASE_EXPECT_EQ(net, http->get_parent());
+    CASE_EXPECT_EQ(top, net->get_parent());
+    CASE_EXPECT_EQ(&util::log::log_category::root(), top->get_parent());
+    CASE_EXPECT_EQ(&util::log::log_category::root(), util::log::log_category::get(NULL));
+    CASE_EXPECT_EQ(http, util::log::log_category::get("log_category_test.net.http"));
+    CASE_EXPECT_EQ(NULL, util::log::log_category::find("log_category_test.db"));
+    CASE_EXPECT_EQ("log_category_test.net.http", http->get_name());
+
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 10;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_WARNING);
+
+    // 都没有设置级别时使用绑定的log_wrapper分类的级别
+    top->set_logger(test_cat);
+    CASE_EXPECT_EQ(test_cat, http->get_logger_category());
+    CASE_EXPECT_EQ(logger, http->get_logger());
+    CASE_EXPECT_FALSE(http->has_level());
+    CASE_EXPECT_EQ(util::log::log_wrapper::level_t::LOG_LW_WARNING, http->get_level());
+    CASE_EXPECT_TRUE(http->check(util::log::log_wrapper::level_t::LOG_LW_WARNING));
+    CASE_EXPECT_FALSE(http->check(util::log::log_wrapper::level_t::LOG_LW_INFO));
+
+    // 子分类继承父分类的级别，单独设置的级别优先
+    net->set_level(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    CASE_EXPECT_TRUE(http->check(util::log::log_wrapper::level_t::LOG_LW_DEBUG));
+    CASE_EXPECT_FALSE(top->check(util::log::log_wrapper::level_t::LOG_LW_INFO));
+
+    http->set_level(util::log::log_wrapper::level_t::LOG_LW_ERROR);
+    CASE_EXPECT_TRUE(http->has_level());
+    CASE_EXPECT_FALSE(http->check(util::log::log_wrapper::level_t::LOG_LW_WARNING));
+
+    // 后注册的子分类也继承
+    util::log::log_category *tcp = util::log::log_category::get("log_category_test.net.tcp");
+    CASE_EXPECT_EQ(util::log::log_wrapper::level_t::LOG_LW_DEBUG, tcp->get_level());
+    CASE_EXPECT_EQ(test_cat, tcp->get_logger_category());
+
+    http->reset_level();
+    CASE_EXPECT_EQ(util::log::log_wrapper::level_t::LOG_LW_DEBUG, http->get_level());
+
+    net->reset_level();
+    CASE_EXPECT_EQ(util::log::log_wrapper::level_t::LOG_LW_WARNING, http->get_level());
+
+    top->reset_logger();
+    CASE_EXPECT_EQ(util::log::log_category::root().get_logger_category(), http->get_logger_category());
+}
+
+CASE_TEST(log_category_test, macros) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 11;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_INFO);
+    logger->set_prefix_format("[%L]");
+    logger->add_sink(test_log_category_sink);
+    g_test_log_category_lines.clear();
+
+    WLOG_NCAT("log_category_test.macro")->set_logger(test_cat);
+    WLOG_NCAT("log_category_test.macro.debug")->set_level(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+
+    for (int i = 0; i < 2; ++i) {
+        WNLOGINFO("log_category_test.macro", "info %d", i);
+        WNLOGDEBUG("log_category_test.macro", "filtered %d", i);
+        WNLOGDEBUG("log_category_test.macro.debug", "debug %d", i);
+    }
+
+    CASE_EXPECT_EQ(4, g_test_log_category_lines.size());
+    if (4 == g_test_log_category_lines.size()) {
+        CASE_EXPECT_EQ("[    Info]info 0", g_test_log_category_lines[0]);
+        CASE_EXPECT_EQ("[   Debug]debug 0", g_test_log_category_lines[1]);
+        CASE_EXPECT_EQ("[    Info]info 1", g_test_log_category_lines[2]);
+        CASE_EXPECT_EQ("[   Debug]debug 1", g_test_log_category_lines[3]);
+    }
+
+    // 调用处缓存的是分类对象，修改级别后立即生效
+    WLOG_NCAT("log_category_test.macro")->set_level(util::log::log_wrapper::level_t::LOG_LW_ERROR);
+    g_test_log_category_lines.clear();
+    WNLOGINFO("log_category_test.macro", "filtered");
+    WNLOGDEBUG("log_category_test.macro.debug", "debug");
+    CASE_EXPECT_EQ(1, g_test_log_category_lines.size());
+
+    logger->clear_sinks();
+    WLOG_NCAT("log_category_test.macro")->reset_logger();
+}
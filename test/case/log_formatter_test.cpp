@@ -0,0 +1,69 @@
+﻿#include <cstring>
+#include <string>
+
+#include "frame/test_macros.h"
+
+#include "log/log_formatter.h"
+#include "time/time_utility.h"
+
+CASE_TEST(log_formatter_test, compiled_format) {
+    util::log::log_formatter::caller_info_t caller(util::log::log_formatter::level_t::LOG_LW_INFO, "Info", "test.cpp", 123, "func", 7);
+    caller.log_time = 1500000000;
+
+    const char *patterns[] = {"[Log %L][%F %T][%s:%n(%C)]: ", "%Y-%m-%d.%N.log", "%y%j%w%H%I%M%S%R %l %x%% %", "plain text", ""};
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+        char buf1[256] = {0};
+        char buf2[256] = {0};
+        util::log::log_formatter::compiled_t compiled(patterns[i]);
+        size_t len1 = util::log::log_formatter::format(buf1, sizeof(buf1), patterns[i], strlen(patterns[i]), caller);
+        size_t len2 = util::log::log_formatter::format(buf2, sizeof(buf2), compiled, caller);
+        CASE_EXPECT_EQ(len1, len2);
+        CASE_EXPECT_EQ(std::string(buf1), std::string(buf2));
+    }
+
+    util::log::log_formatter::compiled_t rotation("%Y.%N.log");
+    CASE_EXPECT_TRUE(rotation.has_rotation_var());
+
+    // 缓冲区不足时截断并保证结尾有'\0'
+    char small[8];
+    util::log::log_formatter::compiled_t level("[Log %L]");
+    size_t len = util::log::log_formatter::format(small, sizeof(small), level, caller);
+    CASE_EXPECT_EQ(7, len);
+    CASE_EXPECT_EQ(std::string("[Log   "), std::string(small));
+}
+
+CASE_TEST(log_formatter_test, time_cache) {
+    util::log::log_formatter::caller_info_t caller;
+    util::log::log_formatter::compiled_t fmt("%F %T");
+    // 覆盖同一分钟内递增、跨分钟、跨天和时间回退的情况
+    time_t tps[] = {1500000000, 1500000001, 1500000059, 1500000061, 1500000000 + 86400 * 3 + 17, 1500000000 - 3600, 1500000000};
+    for (size_t i = 0; i < sizeof(tps) / sizeof(tps[0]); ++i) {
+        caller.log_time = tps[i];
+        char buf[64];
+        char expect[64];
+        util::log::log_formatter::format(buf, sizeof(buf), fmt, caller);
+
+        struct tm tm_obj;
+        UTIL_STRFUNC_LOCALTIME_S(&tps[i], &tm_obj);
+        strftime(expect, sizeof(expect), "%Y-%m-%d %H:%M:%S", &tm_obj);
+        CASE_EXPECT_EQ(std::string(expect), std::string(buf));
+    }
+}
+
+CASE_TEST(log_formatter_test, sub_second) {
+    util::log::log_formatter::caller_info_t caller;
+    caller.log_time = 1500000000;
+    caller.log_time_nsec = 12345678;
+
+    char buf[64];
+    util::log::log_formatter::compiled_t fmt("%f|%u|%i");
+    CASE_EXPECT_TRUE(fmt.has_time_var());
+    util::log::log_formatter::format(buf, sizeof(buf), fmt, caller);
+    CASE_EXPECT_EQ(std::string("012|012345|012345678"), std::string(buf));
+
+    time_t sec = 0, nsec = -1;
+    util::time::time_utility::get_sys_now(sec, nsec);
+    CASE_EXPECT_GE(nsec, 0);
+    CASE_EXPECT_LT(nsec, 1000000000);
+    CASE_EXPECT_LE(sec - time(NULL), 1);
+}
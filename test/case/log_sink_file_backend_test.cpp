@@ -0,0 +1,425 @@
+﻿#include <cstdio>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+#include "config/atframe_utils_build_feature.h"
+#include "config/compiler_features.h"
+
+#include "common/file_system.h"
+#include "log/log_background_worker.h"
+#include "log/log_sink_file_backend.h"
+#include "time/time_utility.h"
+
+#if defined(LOG_SINK_ENABLE_ZLIB) && LOG_SINK_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifndef UTIL_FS_WINDOWS_API
+#include <sys/stat.h>
+#endif
+
+CASE_TEST(log_sink_file_backend_test, buffered_write) {
+    std::string dir = "log_sink_file_backend_test";
+    std::string file_path = dir + "/buffered.0.log";
+    util::file_system::remove(file_path.c_str());
+
+    util::log::log_sink_file_backend backend(dir + "/buffered.%N.log");
+    backend.set_buffer_size(64).set_flush_interval(0).set_max_file_size(1024 * 1024);
+
+    util::log::log_formatter::caller_info_t caller;
+    std::string expect;
+    for (int i = 0; i < 20; ++i) {
+        char line[32];
+        int len = snprintf(line, sizeof(line), "line %d", i);
+        backend(caller, line, static_cast<size_t>(len));
+        expect.append(line, static_cast<size_t>(len));
+        expect.push_back('\n');
+    }
+
+    // 超过缓冲区大小的日志直接写出
+    std::string big(200, 'x');
+    backend(caller, big.c_str(), big.size());
+    expect += big;
+    expect.push_back('\n');
+
+    backend.flush();
+
+    std::string content;
+    CASE_EXPECT_TRUE(util::file_system::get_file_content(content, file_path.c_str(), true));
+    CASE_EXPECT_EQ(expect, content);
+
+    util::file_system::remove(file_path.c_str());
+}
+
+#if defined(UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL) && defined(UTIL_CONFIG_COMPILER_CXX_LAMBDAS) && UTIL_CONFIG_COMPILER_CXX_LAMBDAS
+
+#include <chrono>
+#include <thread>
+
+CASE_TEST(log_sink_file_backend_test, flush_timer) {
+    std::string file_path = "log_sink_file_backend_test/timer.0.log";
+    util::file_system::remove(file_path.c_str());
+
+    util::log::log_sink_file_backend backend("log_sink_file_backend_test/timer.%N.log");
+    backend.set_flush_interval(20);
+
+    // 没有后续日志时由后台线程写出
+    util::log::log_formatter::caller_info_t caller;
+    backend(caller, "timer", 5);
+
+    std::string content;
+    for (int i = 0; i < 100 && content.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        util::file_system::get_file_content(content, file_path.c_str(), true);
+    }
+    CASE_EXPECT_EQ("timer\n", content);
+
+    util::file_system::remove(file_path.c_str());
+}
+
+CASE_TEST(log_sink_file_backend_test, multi_thread_write) {
+    std::string file_path = "log_sink_file_backend_test/mt.0.log";
+    util::file_system::remove(file_path.c_str());
+
+    const int thread_num = 4;
+    const int line_per_thread = 2000;
+    std::string line(31, 'a');
+    {
+        util::log::log_sink_file_backend backend("log_sink_file_backend_test/mt.%N.log");
+        backend.set_buffer_size(256).set_flush_interval(1).set_max_file_size(1024 * 1024 * 16);
+
+        // 先在当前线程打开文件，同步写出时多个线程共享同一个缓冲区
+        util::log::log_formatter::caller_info_t caller;
+        backend(caller, line.c_str(), line.size());
+
+        std::vector<std::thread> thds;
+        for (int i = 0; i < thread_num; ++i) {
+            thds.push_back(std::thread([&backend, &line, line_per_thread]() {
+                util::log::log_formatter::caller_info_t caller;
+                for (int j = 0; j < line_per_thread; ++j) {
+                    backend(caller, line.c_str(), line.size());
+                }
+            }));
+        }
+
+        for (size_t i = 0; i < thds.size(); ++i) {
+            thds[i].join();
+        }
+        backend.flush();
+    }
+
+    std::string content;
+    CASE_EXPECT_TRUE(util::file_system::get_file_content(content, file_path.c_str(), true));
+    CASE_EXPECT_EQ(static_cast<size_t>(thread_num * line_per_thread + 1) * (line.size() + 1), content.size());
+    CASE_EXPECT_EQ(std::string::npos, content.find_first_not_of("a\n"));
+
+    util::file_system::remove(file_path.c_str());
+}
+
+#endif
+
+CASE_TEST(log_sink_file_backend_test, background_rotate) {
+    const char *files[] = {"log_sink_file_backend_test/rotate.0.log", "log_sink_file_backend_test/rotate.1.log",
+                           "log_sink_file_backend_test/rotate.2.log"};
+    for (size_t i = 0; i < 3; ++i) {
+        util::file_system::remove(files[i]);
+    }
+
+    util::log::log_formatter::caller_info_t caller;
+    {
+        util::log::log_sink_file_backend backend("log_sink_file_backend_test/rotate.%N.log");
+        backend.set_max_file_size(100).set_rotate_size(3);
+
+        // 每个文件写2行就会轮转，一共7行，最后写回第0个文件
+        std::string line(59, 'a');
+        for (int i = 0; i < 7; ++i) {
+            line[0] = static_cast<char>('0' + i);
+            backend(caller, line.c_str(), line.size());
+            util::log::log_background_worker::flush();
+        }
+        backend.flush();
+        util::log::log_background_worker::flush();
+
+        std::string content;
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, files[0], true));
+        CASE_EXPECT_EQ(60, content.size());
+        CASE_EXPECT_EQ('6', content[0]);
+
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, files[1], true));
+        CASE_EXPECT_EQ(120, content.size());
+        CASE_EXPECT_EQ('2', content[0]);
+
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, files[2], true));
+        CASE_EXPECT_EQ(120, content.size());
+        CASE_EXPECT_EQ('4', content[0]);
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        util::file_system::remove(files[i]);
+    }
+}
+
+namespace {
+    // 用inode判断切换后写的是不是后台线程预先创建的文件
+    static uint64_t get_test_file_id(const char *path) {
+#ifdef UTIL_FS_WINDOWS_API
+        return util::file_system::is_exist(path) ? 1 : 0;
+#else
+        struct stat st;
+        if (0 != stat(path, &st)) {
+            return 0;
+        }
+        return static_cast<uint64_t>(st.st_ino);
+#endif
+    }
+}
+
+CASE_TEST(log_sink_file_backend_test, prepare_next_file) {
+    const char *files[] = {"log_sink_file_backend_test/prepare/p.0.log", "log_sink_file_backend_test/prepare/p.1.log"};
+    std::string preparing = std::string(files[1]) + ".preparing";
+    for (size_t i = 0; i < 2; ++i) {
+        util::file_system::remove(files[i]);
+    }
+    util::file_system::remove(preparing.c_str());
+    util::file_system::remove("log_sink_file_backend_test/prepare");
+
+    util::log::log_formatter::caller_info_t caller;
+    {
+        util::log::log_sink_file_backend backend("log_sink_file_backend_test/prepare/p.%N.log");
+        backend.set_max_file_size(100).set_rotate_size(2);
+
+        // 第2行越过3/4，后台线程创建临时文件，下一个文件在切换前不会出现
+        std::string line(59, 'a');
+        for (int i = 0; i < 2; ++i) {
+            backend(caller, line.c_str(), line.size());
+            util::log::log_background_worker::flush();
+            CASE_EXPECT_FALSE(util::file_system::is_exist(files[1]));
+        }
+        CASE_EXPECT_TRUE(util::file_system::is_exist(preparing.c_str()));
+        uint64_t prepared_id = get_test_file_id(preparing.c_str());
+
+        // 切换时直接使用预先创建的文件
+        backend(caller, line.c_str(), line.size());
+        CASE_EXPECT_FALSE(util::file_system::is_exist(preparing.c_str()));
+        CASE_EXPECT_TRUE(util::file_system::is_exist(files[1]));
+        CASE_EXPECT_EQ(prepared_id, get_test_file_id(files[1]));
+
+        // 轮转回已有的文件时，切换前历史日志保持不变
+        line[0] = 'b';
+        backend(caller, line.c_str(), line.size());
+        util::log::log_background_worker::flush();
+        backend.flush();
+
+        std::string content;
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, files[0], true));
+        CASE_EXPECT_EQ(120, content.size());
+        CASE_EXPECT_TRUE(util::file_system::is_exist((std::string(files[0]) + ".preparing").c_str()));
+
+        line[0] = 'c';
+        backend(caller, line.c_str(), line.size());
+        backend.flush();
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, files[0], true));
+        CASE_EXPECT_EQ(60, content.size());
+        CASE_EXPECT_EQ('c', content[0]);
+    }
+
+    // 析构时删除没有用到的临时文件
+    util::log::log_background_worker::flush();
+    CASE_EXPECT_FALSE(util::file_system::is_exist((std::string(files[0]) + ".preparing").c_str()));
+    CASE_EXPECT_FALSE(util::file_system::is_exist(preparing.c_str()));
+
+    for (size_t i = 0; i < 2; ++i) {
+        util::file_system::remove(files[i]);
+    }
+    util::file_system::remove("log_sink_file_backend_test/prepare");
+}
+
+CASE_TEST(log_sink_file_backend_test, prepare_next_date) {
+    // 对齐到分钟，在每分钟的第30秒开始写
+    util::time::time_utility::update();
+    time_t now = util::time::time_utility::get_now() / 60 * 60 + 30;
+    util::time::time_utility::raw_time_t fake_now = std::chrono::system_clock::from_time_t(now);
+    util::time::time_utility::update(&fake_now);
+
+    char next_file[256] = {0};
+    {
+        util::log::log_formatter::caller_info_t next_caller;
+        next_caller.log_time = now + 60;
+        util::log::log_formatter::format(next_file, sizeof(next_file),
+                                         util::log::log_formatter::compiled_t("log_sink_file_backend_test/date.%Y%m%d%H%M.log"), next_caller);
+    }
+    std::string preparing = std::string(next_file) + ".preparing";
+
+    util::log::log_formatter::caller_info_t caller;
+    std::string current_file;
+    {
+        util::log::log_sink_file_backend backend("log_sink_file_backend_test/date.%Y%m%d%H%M.log");
+        backend.set_check_interval(60);
+
+        std::string line(59, 'a');
+        backend(caller, line.c_str(), line.size());
+        util::log::log_background_worker::flush();
+        CASE_EXPECT_TRUE(util::file_system::is_exist(preparing.c_str()));
+        CASE_EXPECT_FALSE(util::file_system::is_exist(next_file));
+        uint64_t prepared_id = get_test_file_id(preparing.c_str());
+
+        // 下一分钟切换到预先创建的文件
+        fake_now = std::chrono::system_clock::from_time_t(now + 60);
+        util::time::time_utility::update(&fake_now);
+        backend(caller, line.c_str(), line.size());
+        CASE_EXPECT_TRUE(util::file_system::is_exist(next_file));
+        CASE_EXPECT_EQ(prepared_id, get_test_file_id(next_file));
+        backend.flush();
+
+        std::string content;
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, next_file, true));
+        CASE_EXPECT_EQ(60, content.size());
+    }
+    util::log::log_background_worker::flush();
+    util::time::time_utility::update();
+
+    char prev_file[256] = {0};
+    {
+        util::log::log_formatter::caller_info_t prev_caller;
+        prev_caller.log_time = now;
+        util::log::log_formatter::format(prev_file, sizeof(prev_file),
+                                         util::log::log_formatter::compiled_t("log_sink_file_backend_test/date.%Y%m%d%H%M.log"), prev_caller);
+    }
+    util::file_system::remove(prev_file);
+    util::file_system::remove(next_file);
+    util::file_system::remove(preparing.c_str());
+}
+
+CASE_TEST(log_sink_file_backend_test, rotate_same_file) {
+    std::string file_path = "log_sink_file_backend_test/same.0.log";
+    util::file_system::remove(file_path.c_str());
+
+    util::log::log_formatter::caller_info_t caller;
+    {
+        util::log::log_sink_file_backend backend("log_sink_file_backend_test/same.%N.log");
+        backend.set_buffer_size(1024).set_flush_interval(0).set_max_file_size(100).set_rotate_size(1);
+
+        // 缓冲区中还没写出的旧内容和文件一起清空
+        std::string line(59, 'a');
+        for (int i = 0; i < 5; ++i) {
+            line[0] = static_cast<char>('0' + i);
+            backend(caller, line.c_str(), line.size());
+        }
+        backend.flush();
+        util::log::log_background_worker::flush();
+
+        std::string content;
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, file_path.c_str(), true));
+        CASE_EXPECT_EQ(60, content.size());
+        CASE_EXPECT_EQ('4', content[0]);
+    }
+
+    util::file_system::remove(file_path.c_str());
+}
+
+CASE_TEST(log_sink_file_backend_test, compress_rotated) {
+    if (!util::log::log_sink_file_backend::is_compress_supported()) {
+        return;
+    }
+
+    const char *files[] = {"log_sink_file_backend_test/compress.0.log", "log_sink_file_backend_test/compress.1.log",
+                           "log_sink_file_backend_test/compress.2.log"};
+    for (size_t i = 0; i < 3; ++i) {
+        util::file_system::remove(files[i]);
+        util::file_system::remove((std::string(files[i]) + ".gz").c_str());
+    }
+
+    util::log::log_formatter::caller_info_t caller;
+    std::string expect;
+    {
+        util::log::log_sink_file_backend backend("log_sink_file_backend_test/compress.%N.log");
+        backend.set_max_file_size(100).set_rotate_size(3).set_compress(true);
+        CASE_EXPECT_TRUE(backend.get_compress());
+
+        // 写5行，第0和第1个文件被压缩
+        std::string line(59, 'a');
+        for (int i = 0; i < 5; ++i) {
+            line[0] = static_cast<char>('0' + i);
+            backend(caller, line.c_str(), line.size());
+            if (i < 2) {
+                expect += line;
+                expect.push_back('\n');
+            }
+        }
+        backend.flush();
+        util::log::log_background_worker::flush();
+    }
+
+    CASE_EXPECT_TRUE(util::file_system::is_exist("log_sink_file_backend_test/compress.0.log.gz"));
+    CASE_EXPECT_TRUE(util::file_system::is_exist("log_sink_file_backend_test/compress.1.log.gz"));
+    CASE_EXPECT_FALSE(util::file_system::is_exist("log_sink_file_backend_test/compress.2.log.gz"));
+    CASE_EXPECT_FALSE(util::file_system::is_exist("log_sink_file_backend_test/compress.0.log.rotating"));
+
+#if defined(LOG_SINK_ENABLE_ZLIB) && LOG_SINK_ENABLE_ZLIB
+    gzFile gz = gzopen("log_sink_file_backend_test/compress.0.log.gz", "rb");
+    CASE_EXPECT_TRUE(NULL != gz);
+    if (NULL != gz) {
+        char buffer[1024];
+        int len = gzread(gz, buffer, sizeof(buffer));
+        gzclose(gz);
+        CASE_EXPECT_EQ(expect, std::string(buffer, len > 0 ? static_cast<size_t>(len) : 0));
+    }
+#endif
+
+    for (size_t i = 0; i < 3; ++i) {
+        util::file_system::remove(files[i]);
+        util::file_system::remove((std::string(files[i]) + ".gz").c_str());
+    }
+}
+
+CASE_TEST(log_sink_file_backend_test, shared_rotate) {
+    if (!util::log::log_sink_file_backend::is_shared_supported()) {
+        return;
+    }
+
+    const char *files[] = {"log_sink_file_backend_test/shared.0.log", "log_sink_file_backend_test/shared.1.log",
+                           "log_sink_file_backend_test/shared.2.log", "log_sink_file_backend_test/shared.0.log.lock"};
+    for (size_t i = 0; i < 4; ++i) {
+        util::file_system::remove(files[i]);
+    }
+
+    util::log::log_formatter::caller_info_t caller;
+    {
+        // 两个后端各自打开lock文件，和两个进程一样通过文件锁协调
+        util::log::log_sink_file_backend backends[2] = {util::log::log_sink_file_backend("log_sink_file_backend_test/shared.%N.log"),
+                                                        util::log::log_sink_file_backend("log_sink_file_backend_test/shared.%N.log")};
+        for (int i = 0; i < 2; ++i) {
+            backends[i].set_max_file_size(100).set_rotate_size(3).set_auto_flush(true).set_shared(true);
+            CASE_EXPECT_TRUE(backends[i].get_shared());
+        }
+
+        // 交替写7行，每个文件写满100字节后只轮转一次，后轮转的一方直接切换到新文件
+        std::string line(59, 'a');
+        for (int i = 0; i < 7; ++i) {
+            line[0] = static_cast<char>('0' + i);
+            backends[i % 2](caller, line.c_str(), line.size());
+            util::log::log_background_worker::flush();
+        }
+        util::log::log_background_worker::flush();
+    }
+
+    // 每个文件中是哪几行，没有被重复轮转清空的行
+    const char *expect_lines[] = {"012", "345", "6"};
+    for (size_t i = 0; i < 3; ++i) {
+        std::string content;
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, files[i], true));
+        CASE_EXPECT_EQ(60 * strlen(expect_lines[i]), content.size());
+        for (size_t j = 0; j * 60 < content.size() && j < strlen(expect_lines[i]); ++j) {
+            CASE_EXPECT_EQ(expect_lines[i][j], content[j * 60]);
+            CASE_EXPECT_EQ('\n', content[j * 60 + 59]);
+        }
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        util::file_system::remove(files[i]);
+    }
+}
@@ -0,0 +1,199 @@
+﻿#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+#include "config/compiler_features.h"
+
+#include "common/file_system.h"
+#include "log/log_background_worker.h"
+#include "log/log_sink_mmap_backend.h"
+
+CASE_TEST(log_sink_mmap_backend_test, append_and_rotate) {
+    std::string file_0 = "log_sink_mmap_backend_test/mmap.0.log";
+    std::string file_1 = "log_sink_mmap_backend_test/mmap.1.log";
+    util::file_system::remove(file_0.c_str());
+    util::file_system::remove(file_1.c_str());
+
+    util::log::log_formatter::caller_info_t caller;
+    std::string line(99, 'a');
+    {
+        util::log::log_sink_mmap_backend backend("log_sink_mmap_backend_test/mmap.%N.log");
+        backend.set_file_size(4096).set_rotate_size(2);
+
+        // 4096 / 100 = 40行后切换到下一个文件
+        for (int i = 0; i < 45; ++i) {
+            backend(caller, line.c_str(), line.size());
+        }
+    }
+
+    std::string content_0, content_1;
+    CASE_EXPECT_TRUE(util::file_system::get_file_content(content_0, file_0.c_str(), true));
+    CASE_EXPECT_TRUE(util::file_system::get_file_content(content_1, file_1.c_str(), true));
+    CASE_EXPECT_EQ(4096, content_0.size());
+    CASE_EXPECT_EQ(4096, content_1.size());
+    CASE_EXPECT_EQ(4000, strlen(content_0.c_str()));
+    CASE_EXPECT_EQ(500, strlen(content_1.c_str()));
+
+    // 重新打开后继续写在最近修改的文件末尾
+    {
+        util::log::log_sink_mmap_backend backend("log_sink_mmap_backend_test/mmap.%N.log");
+        backend.set_file_size(4096).set_rotate_size(2);
+        backend(caller, "tail", 4);
+    }
+    CASE_EXPECT_TRUE(util::file_system::get_file_content(content_1, file_1.c_str(), true));
+    CASE_EXPECT_EQ(505, strlen(content_1.c_str()));
+    CASE_EXPECT_EQ(std::string("tail\n"), std::string(content_1.c_str() + 500));
+
+    util::file_system::remove(file_0.c_str());
+    util::file_system::remove(file_1.c_str());
+}
+
+CASE_TEST(log_sink_mmap_backend_test, prepare_next_file) {
+    std::string file_0 = "log_sink_mmap_backend_test/prepare.0.log";
+    std::string file_1 = "log_sink_mmap_backend_test/prepare.1.log";
+    util::file_system::remove(file_0.c_str());
+    util::file_system::remove(file_1.c_str());
+
+    util::log::log_formatter::caller_info_t caller;
+    std::string line(99, 'a');
+    std::string content;
+    {
+        util::log::log_sink_mmap_backend backend("log_sink_mmap_backend_test/prepare.%N.log");
+        backend.set_file_size(4096).set_rotate_size(2);
+
+        // 写满第0个文件，第1个文件写过3/4后在后台线程中准备第0个文件
+        for (int i = 0; i < 40; ++i) {
+            backend(caller, line.c_str(), line.size());
+        }
+        line[0] = 'b';
+        for (int i = 0; i < 32; ++i) {
+            backend(caller, line.c_str(), line.size());
+        }
+        util::log::log_background_worker::flush();
+        CASE_EXPECT_TRUE(util::file_system::is_exist((file_0 + ".preparing").c_str()));
+
+        // 切换前不能动历史日志
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, file_0.c_str(), true));
+        CASE_EXPECT_EQ(4000, strlen(content.c_str()));
+        CASE_EXPECT_EQ('a', content[0]);
+
+        // 切换时才替换
+        line[0] = 'c';
+        for (int i = 0; i < 9; ++i) {
+            backend(caller, line.c_str(), line.size());
+        }
+        CASE_EXPECT_FALSE(util::file_system::is_exist((file_0 + ".preparing").c_str()));
+        CASE_EXPECT_TRUE(util::file_system::get_file_content(content, file_0.c_str(), true));
+        CASE_EXPECT_EQ(100, strlen(content.c_str()));
+        CASE_EXPECT_EQ('c', content[0]);
+    }
+
+    {
+        // 继续写第0个文件，越过3/4后准备第1个文件
+        util::log::log_sink_mmap_backend backend("log_sink_mmap_backend_test/prepare.%N.log");
+        backend.set_file_size(4096).set_rotate_size(2);
+        for (int i = 0; i < 30; ++i) {
+            backend(caller, line.c_str(), line.size());
+        }
+        util::log::log_background_worker::flush();
+        CASE_EXPECT_TRUE(util::file_system::is_exist((file_1 + ".preparing").c_str()));
+    }
+
+    // 没有用到的临时文件被删除，历史日志保留
+    util::log::log_background_worker::flush();
+    CASE_EXPECT_FALSE(util::file_system::is_exist((file_1 + ".preparing").c_str()));
+    CASE_EXPECT_TRUE(util::file_system::get_file_content(content, file_1.c_str(), true));
+    CASE_EXPECT_EQ(4000, strlen(content.c_str()));
+    CASE_EXPECT_EQ('b', content[0]);
+    CASE_EXPECT_TRUE(util::file_system::get_file_content(content, file_0.c_str(), true));
+    CASE_EXPECT_EQ(3100, strlen(content.c_str()));
+
+    util::file_system::remove(file_0.c_str());
+    util::file_system::remove(file_1.c_str());
+}
+
+#if defined(UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL) && defined(UTIL_CONFIG_COMPILER_CXX_LAMBDAS) && UTIL_CONFIG_COMPILER_CXX_LAMBDAS
+
+#include <thread>
+
+CASE_TEST(log_sink_mmap_backend_test, multi_thread) {
+    std::string file_0 = "log_sink_mmap_backend_test/mt.0.log";
+    util::file_system::remove(file_0.c_str());
+
+    {
+        util::log::log_sink_mmap_backend backend("log_sink_mmap_backend_test/mt.%N.log");
+        backend.set_file_size(1024 * 1024).set_rotate_size(1);
+
+        std::vector<std::thread> thds;
+        for (int i = 0; i < 4; ++i) {
+            thds.push_back(std::thread([&backend, i]() {
+                util::log::log_formatter::caller_info_t caller;
+                char line[32];
+                for (int j = 0; j < 1000; ++j) {
+                    int len = snprintf(line, sizeof(line), "%d:%04d", i, j);
+                    backend(caller, line, static_cast<size_t>(len));
+                }
+            }));
+        }
+        for (size_t i = 0; i < thds.size(); ++i) {
+            thds[i].join();
+        }
+    }
+
+    std::string content;
+    CASE_EXPECT_TRUE(util::file_system::get_file_content(content, file_0.c_str(), true));
+    CASE_EXPECT_EQ(4 * 1000 * 7, strlen(content.c_str()));
+    util::file_system::remove(file_0.c_str());
+}
+
+CASE_TEST(log_sink_mmap_backend_test, multi_thread_rotate) {
+    const char *files[] = {"log_sink_mmap_backend_test/mtr.0.log", "log_sink_mmap_backend_test/mtr.1.log",
+                           "log_sink_mmap_backend_test/mtr.2.log"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        util::file_system::remove(files[i]);
+    }
+
+    {
+        util::log::log_sink_mmap_backend backend("log_sink_mmap_backend_test/mtr.%N.log");
+        backend.set_file_size(8192).set_rotate_size(3);
+
+        std::vector<std::thread> thds;
+        for (int i = 0; i < 4; ++i) {
+            thds.push_back(std::thread([&backend, i]() {
+                util::log::log_formatter::caller_info_t caller;
+                char line[32];
+                for (int j = 0; j < 5000; ++j) {
+                    int len = snprintf(line, sizeof(line), "%d:%04d", i, j);
+                    backend(caller, line, static_cast<size_t>(len));
+                }
+            }));
+        }
+        for (size_t i = 0; i < thds.size(); ++i) {
+            thds[i].join();
+        }
+    }
+
+    // 切换文件时不能写坏已经写入的行，预先打开但没用到的文件会被删除
+    int file_count = 0;
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        std::string content;
+        if (!util::file_system::get_file_content(content, files[i], true)) {
+            continue;
+        }
+        ++file_count;
+
+        size_t len = strlen(content.c_str());
+        CASE_EXPECT_EQ(0, len % 7);
+        for (size_t pos = 0; pos < len; pos += 7) {
+            CASE_EXPECT_EQ(':', content[pos + 1]);
+            CASE_EXPECT_EQ('\n', content[pos + 6]);
+        }
+        util::file_system::remove(files[i]);
+    }
+    CASE_EXPECT_LE(2, file_count);
+}
+
+#endif
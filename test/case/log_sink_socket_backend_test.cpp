@@ -0,0 +1,190 @@
+﻿#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+#include "log/log_sink_socket_backend.h"
+
+#if !defined(_WIN32)
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    // 非阻塞地读取接收方收到的所有数据报
+    static std::vector<std::string> test_log_sink_socket_recv_all(int fd) {
+        std::vector<std::string> ret;
+        char buffer[16 * 1024];
+        while (true) {
+            ssize_t res = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (res < 0) {
+                break;
+            }
+            ret.push_back(std::string(buffer, static_cast<size_t>(res)));
+        }
+        return ret;
+    }
+}
+
+CASE_TEST(log_sink_socket_backend_test, unix_batch) {
+    const char *sock_path = "log_sink_socket_backend_test.sock";
+    unlink(sock_path);
+
+    int receiver = socket(AF_UNIX, SOCK_DGRAM, 0);
+    CASE_EXPECT_TRUE(receiver >= 0);
+    if (receiver < 0) {
+        return;
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_path, sizeof(addr.sun_path) - 1);
+    CASE_EXPECT_EQ(0, bind(receiver, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)));
+
+    util::log::log_formatter::caller_info_t caller;
+    caller.level_id = util::log::log_formatter::level_t::LOG_LW_ERROR;
+    {
+        util::log::log_sink_socket_backend backend(std::string("unix:") + sock_path);
+        backend.set_batch_size(4).set_flush_interval(0);
+
+        // 积攒4行后一次发送
+        char line[32];
+        for (int i = 0; i < 3; ++i) {
+            int len = snprintf(line, sizeof(line), "line %d", i);
+            backend(caller, line, static_cast<size_t>(len));
+        }
+        CASE_EXPECT_EQ(0, test_log_sink_socket_recv_all(receiver).size());
+
+        backend(caller, "line 3", 6);
+        std::vector<std::string> received = test_log_sink_socket_recv_all(receiver);
+        CASE_EXPECT_EQ(4, received.size());
+        for (size_t i = 0; i < received.size(); ++i) {
+            snprintf(line, sizeof(line), "line %d", static_cast<int>(i));
+            CASE_EXPECT_EQ(std::string(line), received[i]);
+        }
+
+        // syslog格式和截断
+        backend.set_syslog_facility(1).set_max_datagram_size(8);
+        backend(caller, "truncated message", 17);
+        backend.flush();
+        received = test_log_sink_socket_recv_all(receiver);
+        CASE_EXPECT_EQ(1, received.size());
+        if (1 == received.size()) {
+            CASE_EXPECT_EQ("<11>trun", received[0]);
+        }
+
+        CASE_EXPECT_EQ(5, backend.get_sent_count());
+        CASE_EXPECT_EQ(0, backend.get_dropped_count());
+    }
+
+    close(receiver);
+    unlink(sock_path);
+
+    // 接收方不存在时直接丢弃
+    {
+        util::log::log_sink_socket_backend backend(std::string("unix:") + sock_path);
+        backend.set_batch_size(2);
+        backend(caller, "dropped", 7);
+        backend(caller, "dropped", 7);
+        backend.flush();
+        CASE_EXPECT_EQ(0, backend.get_sent_count());
+        CASE_EXPECT_EQ(2, backend.get_dropped_count());
+    }
+}
+
+CASE_TEST(log_sink_socket_backend_test, shared_copy_and_timer) {
+    const char *sock_path = "log_sink_socket_backend_test_timer.sock";
+    unlink(sock_path);
+
+    int receiver = socket(AF_UNIX, SOCK_DGRAM, 0);
+    CASE_EXPECT_TRUE(receiver >= 0);
+    if (receiver < 0) {
+        return;
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_path, sizeof(addr.sun_path) - 1);
+    CASE_EXPECT_EQ(0, bind(receiver, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)));
+
+    util::log::log_formatter::caller_info_t caller;
+    {
+        util::log::log_sink_socket_backend backend(std::string("unix:") + sock_path);
+        backend.set_batch_size(32).set_flush_interval(0);
+
+        // 复制出的对象(比如添加到log_wrapper的落地接口)写入的日志可以由原来的对象发送
+        util::log::log_sink_socket_backend copied(backend);
+        copied(caller, "copied", 6);
+        CASE_EXPECT_EQ(0, test_log_sink_socket_recv_all(receiver).size());
+        backend.flush();
+        std::vector<std::string> received = test_log_sink_socket_recv_all(receiver);
+        CASE_EXPECT_EQ(1, received.size());
+        CASE_EXPECT_EQ(1, copied.get_sent_count());
+
+        // 没有新日志时由后台线程定时发送
+        backend.set_flush_interval(20);
+        backend(caller, "timer", 5);
+        for (int i = 0; i < 100 && received.size() < 2; ++i) {
+            usleep(10000);
+            std::vector<std::string> more = test_log_sink_socket_recv_all(receiver);
+            received.insert(received.end(), more.begin(), more.end());
+        }
+        CASE_EXPECT_EQ(2, received.size());
+        if (2 == received.size()) {
+            CASE_EXPECT_EQ("timer", received[1]);
+        }
+    }
+
+    close(receiver);
+    unlink(sock_path);
+}
+
+CASE_TEST(log_sink_socket_backend_test, udp) {
+    int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+    CASE_EXPECT_TRUE(receiver >= 0);
+    if (receiver < 0) {
+        return;
+    }
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    CASE_EXPECT_EQ(0, bind(receiver, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)));
+
+    socklen_t addr_len = sizeof(addr);
+    CASE_EXPECT_EQ(0, getsockname(receiver, reinterpret_cast<sockaddr *>(&addr), &addr_len));
+
+    char address[64];
+    snprintf(address, sizeof(address), "udp:127.0.0.1:%d", static_cast<int>(ntohs(addr.sin_port)));
+
+    util::log::log_formatter::caller_info_t caller;
+    util::log::log_sink_socket_backend backend;
+    CASE_EXPECT_FALSE(backend.set_address("tcp:127.0.0.1:1"));
+    CASE_EXPECT_FALSE(backend.set_address("udp:127.0.0.1"));
+    CASE_EXPECT_TRUE(backend.set_address(address));
+
+    backend(caller, "udp 0", 5);
+    backend(caller, "udp 1", 5);
+    backend.flush();
+
+    // 本机UDP发送后立即可读
+    std::vector<std::string> received = test_log_sink_socket_recv_all(receiver);
+    CASE_EXPECT_EQ(2, received.size());
+    if (2 == received.size()) {
+        CASE_EXPECT_EQ("udp 0", received[0]);
+        CASE_EXPECT_EQ("udp 1", received[1]);
+    }
+
+    close(receiver);
+}
+
+#endif
@@ -0,0 +1,136 @@
+﻿#include <cstring>
+#include <string>
+
+#include "frame/test_macros.h"
+
+#include "log/log_stats.h"
+#include "log/log_wrapper.h"
+
+namespace {
+    static size_t g_test_log_stats_sink_count = 0;
+
+    static void test_log_stats_sink(const util::log::log_wrapper::caller_info_t &, const char *, size_t) { ++g_test_log_stats_sink_count; }
+}
+
+CASE_TEST(log_stats_test, latency_bucket) {
+    CASE_EXPECT_EQ(0, util::log::log_stats::get_latency_bucket(0));
+    CASE_EXPECT_EQ(0, util::log::log_stats::get_latency_bucket(util::log::log_stats::get_latency_bucket_bound(0) - 1));
+    CASE_EXPECT_EQ(1, util::log::log_stats::get_latency_bucket(util::log::log_stats::get_latency_bucket_bound(0)));
+    CASE_EXPECT_EQ(util::log::log_stats::LATENCY_BUCKET_COUNT - 1, util::log::log_stats::get_latency_bucket(static_cast<uint64_t>(-1)));
+    CASE_EXPECT_EQ(0, util::log::log_stats::get_latency_bucket_bound(util::log::log_stats::LATENCY_BUCKET_COUNT - 1));
+
+    for (size_t i = 0; i + 1 < util::log::log_stats::LATENCY_BUCKET_COUNT; ++i) {
+        uint64_t bound = util::log::log_stats::get_latency_bucket_bound(i);
+        CASE_EXPECT_EQ(i, util::log::log_stats::get_latency_bucket(bound - 1));
+        CASE_EXPECT_EQ(i + 1, util::log::log_stats::get_latency_bucket(bound));
+    }
+}
+
+CASE_TEST(log_stats_test, counters) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 8;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    CASE_EXPECT_EQ(test_cat, logger->get_category());
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_INFO);
+    logger->set_prefix_format("");
+    logger->add_sink(test_log_stats_sink);
+    logger->add_sink(test_log_stats_sink);
+    g_test_log_stats_sink_count = 0;
+
+    util::log::log_stats::reset();
+
+    WCLOGERROR(test_cat, "error");
+    WCLOGINFO(test_cat, "info");
+    WCLOGINFO(test_cat, "%s", "info");
+    WCLOGDEBUG(test_cat, "filtered");
+
+    util::log::log_stats::snapshot_t snapshot;
+    util::log::log_stats::snapshot(snapshot);
+    const util::log::log_stats::category_t &stats = snapshot.categories[test_cat];
+
+    CASE_EXPECT_EQ(6, g_test_log_stats_sink_count);
+    CASE_EXPECT_EQ(1, stats.get_lines(util::log::log_wrapper::level_t::LOG_LW_ERROR));
+    CASE_EXPECT_EQ(2, stats.get_lines(util::log::log_wrapper::level_t::LOG_LW_INFO));
+    CASE_EXPECT_EQ(0, stats.get_lines(util::log::log_wrapper::level_t::LOG_LW_DEBUG));
+    CASE_EXPECT_EQ(3, stats.get_total_lines());
+    // 字节数按每个落地接口分别计算
+    CASE_EXPECT_EQ(2 * (strlen("error") + strlen("info") * 2), stats.get_bytes());
+    // 没有开启耗时统计
+    CASE_EXPECT_EQ(0, stats.get_format_count());
+    CASE_EXPECT_EQ(0, stats.get_sink_calls());
+
+    logger->set_option(util::log::log_wrapper::options_t::OPT_STATS_LATENCY, true);
+    WCLOGWARNING(test_cat, "warning");
+    WCLOGINFO(test_cat, "info");
+    logger->set_option(util::log::log_wrapper::options_t::OPT_STATS_LATENCY, false);
+
+    util::log::log_stats::snapshot(snapshot);
+    CASE_EXPECT_EQ(5, stats.get_total_lines());
+    CASE_EXPECT_EQ(2, stats.get_format_count());
+    CASE_EXPECT_EQ(4, stats.get_sink_calls());
+
+    uint64_t latency_count = 0;
+    for (size_t i = 0; i < util::log::log_stats::LATENCY_BUCKET_COUNT; ++i) {
+        latency_count += stats.get_sink_latency(i);
+    }
+    CASE_EXPECT_EQ(stats.get_sink_calls(), latency_count);
+
+    // 其他分类不受影响
+    CASE_EXPECT_EQ(0, snapshot.categories[test_cat + 1].get_total_lines());
+
+    util::log::log_stats::reset();
+    util::log::log_stats::snapshot(snapshot);
+    CASE_EXPECT_EQ(0, stats.get_total_lines());
+    CASE_EXPECT_EQ(0, stats.get_bytes());
+
+    logger->clear_sinks();
+}
+
+CASE_TEST(log_stats_test, sink_counters) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 8;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_INFO);
+    logger->set_prefix_format("");
+    uint32_t all_sink = logger->add_sink(test_log_stats_sink);
+    uint32_t error_sink =
+        logger->add_sink(test_log_stats_sink, util::log::log_wrapper::level_t::LOG_LW_FATAL, util::log::log_wrapper::level_t::LOG_LW_ERROR);
+
+    WCLOGERROR(test_cat, "error");
+    WCLOGINFO(test_cat, "info");
+    logger->set_option(util::log::log_wrapper::options_t::OPT_STATS_LATENCY, true);
+    WCLOGERROR(test_cat, "error");
+    logger->set_option(util::log::log_wrapper::options_t::OPT_STATS_LATENCY, false);
+
+    util::log::log_stats::sink_t stats;
+    CASE_EXPECT_TRUE(util::log::log_stats::get_sink_stats(*logger, all_sink, stats));
+    CASE_EXPECT_EQ(3, stats.get_lines());
+    CASE_EXPECT_EQ(strlen("error") * 2 + strlen("info"), stats.get_bytes());
+    CASE_EXPECT_EQ(1, stats.get_calls());
+
+    CASE_EXPECT_TRUE(util::log::log_stats::get_sink_stats(*logger, error_sink, stats));
+    CASE_EXPECT_EQ(2, stats.get_lines());
+    CASE_EXPECT_EQ(strlen("error") * 2, stats.get_bytes());
+    CASE_EXPECT_EQ(1, stats.get_calls());
+
+    uint64_t latency_count = 0;
+    for (size_t i = 0; i < util::log::log_stats::LATENCY_BUCKET_COUNT; ++i) {
+        latency_count += stats.get_latency(i);
+    }
+    CASE_EXPECT_EQ(1, latency_count);
+
+    // 移除后查询不到
+    CASE_EXPECT_TRUE(logger->remove_sink(error_sink));
+    CASE_EXPECT_FALSE(util::log::log_stats::get_sink_stats(*logger, error_sink, stats));
+
+    logger->clear_sinks();
+}
@@ -0,0 +1,686 @@
+﻿#include <cstdarg>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+#include "config/compiler_features.h"
+
+#include "log/log_async_pipeline.h"
+#include "log/log_binary_codec.h"
+#include "log/log_wrapper.h"
+#include "time/time_utility.h"
+
+namespace {
+    static std::vector<std::string> g_test_log_rate_limit_lines;
+
+    static void test_log_rate_limit_sink(const util::log::log_wrapper::caller_info_t &, const char *content, size_t content_size) {
+        g_test_log_rate_limit_lines.push_back(std::string(content, content_size));
+    }
+
+    static int64_t g_test_log_captured_time_ns = 0;
+    static void test_log_captured_time_sink(const util::log::log_wrapper::caller_info_t &caller, const char *, size_t) {
+        g_test_log_captured_time_ns = static_cast<int64_t>(caller.log_time) * 1000000000 + caller.log_time_nsec;
+    }
+}
+
+#if defined(UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL) && defined(UTIL_CONFIG_COMPILER_CXX_LAMBDAS) && UTIL_CONFIG_COMPILER_CXX_LAMBDAS
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace {
+    struct test_log_async_sink_data {
+        std::vector<std::vector<int> > seqs;
+        size_t line_count;
+        std::thread::id last_thread;
+    };
+
+    static test_log_async_sink_data g_test_log_async_sink;
+
+    static void test_log_async_sink(const util::log::log_wrapper::caller_info_t &, const char *content, size_t content_size) {
+        ++g_test_log_async_sink.line_count;
+        g_test_log_async_sink.last_thread = std::this_thread::get_id();
+
+        // 内容格式: "<thread index>:<sequence>"
+        std::string line(content, content_size);
+        size_t sep = line.find(':');
+        if (std::string::npos == sep) {
+            return;
+        }
+
+        size_t thd_idx = static_cast<size_t>(atoi(line.c_str()));
+        if (thd_idx < g_test_log_async_sink.seqs.size()) {
+            g_test_log_async_sink.seqs[thd_idx].push_back(atoi(line.c_str() + sep + 1));
+        }
+    }
+}
+
+CASE_TEST(log_wrapper_test, async_pipeline) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 1;
+    const int thread_num = 4;
+    const int line_per_thread = 2000;
+
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    logger->set_prefix_format("");
+    logger->add_sink(test_log_async_sink);
+    logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, true);
+    CASE_EXPECT_TRUE(logger->get_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE));
+
+    g_test_log_async_sink.seqs.clear();
+    g_test_log_async_sink.seqs.resize(thread_num);
+    g_test_log_async_sink.line_count = 0;
+
+    util::log::log_async_pipeline &pipeline = util::log::log_async_pipeline::instance();
+    pipeline.set_ring_size(8192);
+    CASE_EXPECT_EQ(0, pipeline.start());
+    CASE_EXPECT_EQ(1, pipeline.start());
+
+    std::vector<std::thread> thds;
+    for (int i = 0; i < thread_num; ++i) {
+        thds.push_back(std::thread([i, line_per_thread, test_cat]() {
+            for (int j = 0; j < line_per_thread; ++j) {
+                WCLOGDEBUG(test_cat, "%d:%d", i, j);
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < thds.size(); ++i) {
+        thds[i].join();
+    }
+
+    pipeline.flush();
+    CASE_EXPECT_EQ(static_cast<size_t>(thread_num * line_per_thread), g_test_log_async_sink.line_count);
+    CASE_EXPECT_TRUE(g_test_log_async_sink.last_thread != std::this_thread::get_id());
+
+    // 同一个线程内的顺序必须保持
+    for (int i = 0; i < thread_num; ++i) {
+        CASE_EXPECT_EQ(static_cast<size_t>(line_per_thread), g_test_log_async_sink.seqs[i].size());
+        bool ordered = true;
+        for (size_t j = 0; j < g_test_log_async_sink.seqs[i].size(); ++j) {
+            if (g_test_log_async_sink.seqs[i][j] != static_cast<int>(j)) {
+                ordered = false;
+                break;
+            }
+        }
+        CASE_EXPECT_TRUE(ordered);
+    }
+
+    pipeline.stop();
+    CASE_EXPECT_FALSE(pipeline.is_running());
+
+    // 停止后回退到同步写出
+    WCLOGDEBUG(test_cat, "0:%d", line_per_thread);
+    CASE_EXPECT_EQ(static_cast<size_t>(thread_num * line_per_thread + 1), g_test_log_async_sink.line_count);
+    CASE_EXPECT_TRUE(g_test_log_async_sink.last_thread == std::this_thread::get_id());
+
+    logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, false);
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DISABLED);
+}
+
+namespace {
+    static std::mutex g_test_log_async_stop_lock;
+    static std::vector<std::vector<int> > g_test_log_async_stop_hits;
+
+    static void test_log_async_stop_sink(const util::log::log_wrapper::caller_info_t &, const char *content, size_t content_size) {
+        std::string line(content, content_size);
+        size_t sep = line.find(':');
+        if (std::string::npos == sep) {
+            return;
+        }
+
+        size_t thd_idx = static_cast<size_t>(atoi(line.c_str()));
+        size_t seq = static_cast<size_t>(atoi(line.c_str() + sep + 1));
+        std::lock_guard<std::mutex> lkholder(g_test_log_async_stop_lock);
+        if (thd_idx < g_test_log_async_stop_hits.size() && seq < g_test_log_async_stop_hits[thd_idx].size()) {
+            ++g_test_log_async_stop_hits[thd_idx][seq];
+        }
+    }
+}
+
+CASE_TEST(log_wrapper_test, async_pipeline_stop_race) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 1;
+    const int thread_num = 4;
+    const int line_per_thread = 5000;
+
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    logger->set_prefix_format("");
+    logger->clear_sinks();
+    logger->add_sink(test_log_async_stop_sink);
+    logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, true);
+
+    g_test_log_async_stop_hits.clear();
+    g_test_log_async_stop_hits.resize(thread_num, std::vector<int>(line_per_thread, 0));
+
+    util::log::log_async_pipeline &pipeline = util::log::log_async_pipeline::instance();
+    pipeline.set_ring_size(8192);
+    CASE_EXPECT_EQ(0, pipeline.start());
+
+    // 停止时仍有线程在推送和flush，每条日志必须正好写出一次
+    std::vector<std::thread> thds;
+    for (int i = 0; i < thread_num; ++i) {
+        thds.push_back(std::thread([i, line_per_thread, test_cat]() {
+            for (int j = 0; j < line_per_thread; ++j) {
+                WCLOGDEBUG(test_cat, "%d:%d", i, j);
+            }
+        }));
+    }
+
+    std::atomic<bool> producer_done(false);
+    std::vector<std::thread> flush_thds;
+    for (int i = 0; i < 2; ++i) {
+        flush_thds.push_back(std::thread([&producer_done]() {
+            while (!producer_done.load()) {
+                util::log::log_async_pipeline::instance().flush();
+            }
+        }));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    pipeline.stop();
+
+    for (size_t i = 0; i < thds.size(); ++i) {
+        thds[i].join();
+    }
+    producer_done.store(true);
+    for (size_t i = 0; i < flush_thds.size(); ++i) {
+        flush_thds[i].join();
+    }
+    pipeline.flush();
+
+    size_t bad_count = 0;
+    for (int i = 0; i < thread_num; ++i) {
+        for (int j = 0; j < line_per_thread; ++j) {
+            if (1 != g_test_log_async_stop_hits[i][j]) {
+                ++bad_count;
+            }
+        }
+    }
+    CASE_EXPECT_EQ(0, bad_count);
+
+    logger->clear_sinks();
+    logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, false);
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DISABLED);
+}
+
+#endif
+
+namespace {
+    static size_t test_log_binary_roundtrip(char *out, size_t outz, const char *fmt, ...) {
+        char data[1024];
+        va_list ap;
+        va_start(ap, fmt);
+        size_t datasz = util::log::log_binary_codec::encode(data, sizeof(data), fmt, ap);
+        va_end(ap);
+        return util::log::log_binary_codec::decode(out, outz, fmt, data, datasz);
+    }
+
+    static std::string g_test_log_binary_last;
+    static void test_log_binary_sink(const util::log::log_wrapper::caller_info_t &, const char *content, size_t content_size) {
+        g_test_log_binary_last.assign(content, content_size);
+    }
+}
+
+CASE_TEST(log_wrapper_test, binary_codec) {
+    char out[256];
+    char expect[256];
+    const char *null_str = NULL;
+    size_t len = test_log_binary_roundtrip(out, sizeof(out), "%d|%5u|%-3lld|%x|%zu|%.2f|%Lg|%c|%s|%*.*s|%%|%p|%s", -12, 34u, 56LL, 255u,
+                                           static_cast<size_t>(78), 3.14159, static_cast<long double>(2.5), 'z', "hello", 6, 2, "world",
+                                           reinterpret_cast<void *>(0x1234), null_str);
+    snprintf(expect, sizeof(expect), "%d|%5u|%-3lld|%x|%zu|%.2f|%Lg|%c|%s|%*.*s|%%|%p|%s", -12, 34u, 56LL, 255u, static_cast<size_t>(78),
+             3.14159, static_cast<long double>(2.5), 'z', "hello", 6, 2, "world", reinterpret_cast<void *>(0x1234), "(null)");
+    CASE_EXPECT_EQ(strlen(expect), len);
+    CASE_EXPECT_EQ(std::string(expect), std::string(out));
+
+    // 指定精度时字符串可以不以'\0'结尾
+    const char no_nul[] = {'a', 'b', 'c', 'd', 'e', 'f'};
+    len = test_log_binary_roundtrip(out, sizeof(out), "%.3s|%.*s|%.*s", no_nul, 5, no_nul, -1, "neg");
+    CASE_EXPECT_EQ(std::string("abc|abcde|neg"), std::string(out, len));
+
+    // 输出缓冲区不足时截断
+    len = test_log_binary_roundtrip(out, 8, "%s-%d", "abcdef", 123);
+    CASE_EXPECT_EQ(7, len);
+    CASE_EXPECT_EQ(std::string("abcdef-"), std::string(out));
+}
+
+CASE_TEST(log_wrapper_test, binary_log) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 2;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    WLOG_INIT(test_cat, util::log::log_wrapper::level_t::LOG_LW_INFO);
+    logger->set_prefix_format("[%L]");
+    logger->add_sink(test_log_binary_sink);
+
+    g_test_log_binary_last.clear();
+    WCLOGBININFO(test_cat, "%s %d", "sync", 1);
+    CASE_EXPECT_EQ(std::string("[    Info]sync 1"), g_test_log_binary_last);
+
+    g_test_log_binary_last.clear();
+    WCLOGBINDEBUG(test_cat, "%s %d", "filtered", 2);
+    CASE_EXPECT_TRUE(g_test_log_binary_last.empty());
+
+    util::log::log_async_pipeline &pipeline = util::log::log_async_pipeline::instance();
+    logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, true);
+    CASE_EXPECT_EQ(0, pipeline.start());
+    WCLOGBINERROR(test_cat, "%s %d %.1f", "async", 3, 4.5);
+    pipeline.flush();
+    pipeline.stop();
+    CASE_EXPECT_EQ(std::string("[   Error]async 3 4.5"), g_test_log_binary_last);
+
+    logger->set_option(util::log::log_wrapper::options_t::OPT_ASYNC_WRITE, false);
+    WLOG_INIT(test_cat, util::log::log_wrapper::level_t::LOG_LW_DISABLED);
+}
+
+#if defined(UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL) && defined(UTIL_CONFIG_COMPILER_CXX_LAMBDAS) && UTIL_CONFIG_COMPILER_CXX_LAMBDAS
+namespace {
+    static util::lock::atomic_int_type<int> g_test_log_sink_table_count[2];
+
+    static void test_log_sink_table_sink(int index, const util::log::log_wrapper::caller_info_t &, const char *, size_t) {
+        ++g_test_log_sink_table_count[index];
+    }
+}
+
+CASE_TEST(log_wrapper_test, sink_table) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 3;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    logger->set_prefix_format("");
+    g_test_log_sink_table_count[0].store(0);
+    g_test_log_sink_table_count[1].store(0);
+
+    using namespace std::placeholders;
+    uint32_t error_sink = logger->add_sink(std::bind(test_log_sink_table_sink, 0, _1, _2, _3),
+                                           util::log::log_wrapper::level_t::LOG_LW_FATAL,
+                                           util::log::log_wrapper::level_t::LOG_LW_ERROR);
+    CASE_EXPECT_NE(0, error_sink);
+    CASE_EXPECT_EQ(1, logger->get_sink_size());
+    CASE_EXPECT_EQ(0, logger->add_sink(util::log::log_wrapper::log_handler_t()));
+
+    // 分级分组后，DEBUG日志不会进入只接收ERROR以上的落地接口
+    WCLOGERROR(test_cat, "error");
+    WCLOGDEBUG(test_cat, "debug");
+    CASE_EXPECT_EQ(1, g_test_log_sink_table_count[0].load());
+
+    // 其他线程写日志时添加和移除落地接口
+    util::lock::atomic_int_type<bool> running;
+    running.store(true);
+    std::vector<std::thread> thds;
+    for (int i = 0; i < 4; ++i) {
+        thds.push_back(std::thread([&running, test_cat]() {
+            while (running.load()) {
+                WCLOGDEBUG(test_cat, "debug");
+            }
+        }));
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        uint32_t debug_sink = logger->add_sink(std::bind(test_log_sink_table_sink, 1, _1, _2, _3));
+        CASE_EXPECT_NE(debug_sink, error_sink);
+        CASE_EXPECT_TRUE(logger->remove_sink(debug_sink));
+        CASE_EXPECT_FALSE(logger->remove_sink(debug_sink));
+    }
+
+    running.store(false);
+    for (size_t i = 0; i < thds.size(); ++i) {
+        thds[i].join();
+    }
+
+    CASE_EXPECT_EQ(1, g_test_log_sink_table_count[0].load());
+    CASE_EXPECT_EQ(1, logger->get_sink_size());
+
+    logger->clear_sinks();
+    CASE_EXPECT_EQ(0, logger->get_sink_size());
+    CASE_EXPECT_TRUE(!logger->get_sinks());
+    WCLOGERROR(test_cat, "error");
+    CASE_EXPECT_EQ(1, g_test_log_sink_table_count[0].load());
+}
+
+CASE_TEST(log_wrapper_test, rate_limit) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 4;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    logger->set_prefix_format("");
+    logger->add_sink(test_log_rate_limit_sink);
+
+    // 跨过秒切换时最多放行两个窗口的日志
+    g_test_log_rate_limit_lines.clear();
+    for (int i = 0; i < 1000; ++i) {
+        WCLOGRATEERROR(test_cat, 10, "rate %d", i);
+    }
+    CASE_EXPECT_GE(g_test_log_rate_limit_lines.size(), 10);
+    CASE_EXPECT_LE(g_test_log_rate_limit_lines.size(), 21);
+    CASE_EXPECT_EQ("rate 0", g_test_log_rate_limit_lines[0]);
+
+    // 新的窗口里第一条日志前输出丢弃的条数
+    g_test_log_rate_limit_lines.clear();
+    for (int i = 0; i < 3; ++i) {
+        WCLOGRATEERROR(test_cat, 1, "loop %d", i);
+        if (0 == i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        } else if (1 == i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        }
+    }
+
+    CASE_EXPECT_GE(g_test_log_rate_limit_lines.size(), 3);
+    if (g_test_log_rate_limit_lines.size() >= 3) {
+        CASE_EXPECT_EQ("loop 0", g_test_log_rate_limit_lines[0]);
+        if ("loop 1" == g_test_log_rate_limit_lines[1]) {
+            // loop 0和loop 1刚好跨过秒切换，没有丢弃的日志
+            CASE_EXPECT_EQ(3, g_test_log_rate_limit_lines.size());
+        } else {
+            CASE_EXPECT_EQ("suppressed 1 messages", g_test_log_rate_limit_lines[1]);
+        }
+        CASE_EXPECT_EQ("loop 2", g_test_log_rate_limit_lines[g_test_log_rate_limit_lines.size() - 1]);
+    }
+
+    g_test_log_rate_limit_lines.clear();
+    for (int i = 0; i < 100; ++i) {
+        WCLOGSAMPLEDEBUG(test_cat, 10, "sample %d", i);
+    }
+    CASE_EXPECT_EQ(10, g_test_log_rate_limit_lines.size());
+    CASE_EXPECT_EQ("sample 0", g_test_log_rate_limit_lines[0]);
+    CASE_EXPECT_EQ("sample 90", g_test_log_rate_limit_lines[9]);
+
+    logger->clear_sinks();
+}
+
+#endif
+
+CASE_TEST(log_wrapper_test, level_cache) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 5;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    CASE_EXPECT_FALSE(util::log::log_wrapper::check_level(util::log::log_wrapper::categorize_t::MAX,
+                                                          util::log::log_wrapper::level_t::LOG_LW_FATAL));
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_INFO);
+    logger->set_prefix_format("");
+    CASE_EXPECT_TRUE(util::log::log_wrapper::check_level(test_cat, util::log::log_wrapper::level_t::LOG_LW_INFO));
+    CASE_EXPECT_FALSE(util::log::log_wrapper::check_level(test_cat, util::log::log_wrapper::level_t::LOG_LW_NOTICE));
+
+    logger->set_level(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    CASE_EXPECT_TRUE(util::log::log_wrapper::check_level(test_cat, util::log::log_wrapper::level_t::LOG_LW_DEBUG));
+
+    g_test_log_rate_limit_lines.clear();
+    logger->add_sink(test_log_rate_limit_sink);
+    WCLOGDEBUG(test_cat, "debug");
+
+// 编译期移除INFO以下的日志
+#undef LOG_WRAPPER_COMPILE_MAX_LEVEL
+#define LOG_WRAPPER_COMPILE_MAX_LEVEL 4
+    WCLOGDEBUG(test_cat, "stripped");
+    WCLOGINFO(test_cat, "info");
+#undef LOG_WRAPPER_COMPILE_MAX_LEVEL
+#define LOG_WRAPPER_COMPILE_MAX_LEVEL 6
+
+    CASE_EXPECT_EQ(2, g_test_log_rate_limit_lines.size());
+    if (2 == g_test_log_rate_limit_lines.size()) {
+        CASE_EXPECT_EQ("debug", g_test_log_rate_limit_lines[0]);
+        CASE_EXPECT_EQ("info", g_test_log_rate_limit_lines[1]);
+    }
+
+    logger->set_level(util::log::log_wrapper::level_t::LOG_LW_DISABLED);
+    WCLOGFATAL(test_cat, "disabled");
+    CASE_EXPECT_EQ(2, g_test_log_rate_limit_lines.size());
+    logger->clear_sinks();
+}
+
+CASE_TEST(log_wrapper_test, kv_encoder) {
+    char buffer[256];
+    util::log::log_kv_encoder json(buffer, sizeof(buffer), util::log::log_kv_encoder::format_t::EN_KV_FMT_JSON);
+    json.add(WLOGFIELD("i", -123))
+        .add(WLOGFIELD("u", 18446744073709551615ULL))
+        .add(WLOGFIELD("d", 0.5))
+        .add(WLOGFIELD("b", true))
+        .add(WLOGFIELD("s", "a\"b\\c\n\x01"));
+    size_t len = json.finish();
+    CASE_EXPECT_EQ(std::string("{\"i\":-123,\"u\":18446744073709551615,\"d\":0.5,\"b\":true,\"s\":\"a\\\"b\\\\c\\n\\u0001\"}"),
+                   std::string(buffer, len));
+    CASE_EXPECT_FALSE(json.is_truncated());
+
+    util::log::log_kv_encoder logfmt(buffer, sizeof(buffer), util::log::log_kv_encoder::format_t::EN_KV_FMT_LOGFMT);
+    logfmt.add(WLOGFIELD("msg", "hello world")).add(WLOGFIELD("uid", 42)).add(WLOGFIELD("empty", "")).add(WLOGFIELD("min", INT64_MIN));
+    len = logfmt.finish();
+    CASE_EXPECT_EQ(std::string("msg=\"hello world\" uid=42 empty=\"\" min=-9223372036854775808"), std::string(buffer, len));
+
+    // 放不下的字段整个丢弃
+    util::log::log_kv_encoder small(buffer, 16, util::log::log_kv_encoder::format_t::EN_KV_FMT_JSON);
+    small.add(WLOGFIELD("a", 1)).add(WLOGFIELD("long", "0123456789")).add(WLOGFIELD("b", 2));
+    len = small.finish();
+    CASE_EXPECT_TRUE(small.is_truncated());
+    CASE_EXPECT_EQ(std::string("{\"a\":1}"), std::string(buffer, len));
+    CASE_EXPECT_EQ(len, strlen(buffer));
+
+    char num[24];
+    CASE_EXPECT_EQ(std::string("0"), std::string(num, util::log::log_kv_encoder::write_int(num, 0)));
+    CASE_EXPECT_EQ(std::string("1234567"), std::string(num, util::log::log_kv_encoder::write_uint(num, 1234567)));
+}
+
+CASE_TEST(log_wrapper_test, kv_log) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 6;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    g_test_log_rate_limit_lines.clear();
+    logger->add_sink(test_log_rate_limit_sink);
+
+    std::string name = "owent";
+    WCLOGKVINFO(test_cat, WLOGFIELD("event", "login"), WLOGFIELD("name", name), WLOGFIELD("cost", 1.25));
+    CASE_EXPECT_EQ(1, g_test_log_rate_limit_lines.size());
+    if (!g_test_log_rate_limit_lines.empty()) {
+        const std::string &line = g_test_log_rate_limit_lines[0];
+        CASE_EXPECT_EQ(0, line.find("{\"time\":\""));
+        CASE_EXPECT_NE(std::string::npos, line.find("\"level\":\"Info\""));
+        CASE_EXPECT_NE(std::string::npos, line.find("\"event\":\"login\",\"name\":\"owent\",\"cost\":1.25}"));
+    }
+
+    logger->set_kv_format(util::log::log_kv_encoder::format_t::EN_KV_FMT_LOGFMT);
+    WCLOGKVINFO(test_cat, WLOGFIELD("event", "logout"));
+    CASE_EXPECT_EQ(2, g_test_log_rate_limit_lines.size());
+    if (2 == g_test_log_rate_limit_lines.size()) {
+        CASE_EXPECT_EQ(0, g_test_log_rate_limit_lines[1].find("time="));
+        CASE_EXPECT_NE(std::string::npos, g_test_log_rate_limit_lines[1].find(" level=Info "));
+        CASE_EXPECT_NE(std::string::npos, g_test_log_rate_limit_lines[1].find(" event=logout"));
+    }
+
+    logger->clear_sinks();
+}
+
+CASE_TEST(log_wrapper_test, tls_buffer_grow) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 7;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    logger->set_prefix_format("[%L]");
+    g_test_log_rate_limit_lines.clear();
+    logger->add_sink(test_log_rate_limit_sink);
+    WCLOGINFO(test_cat, "%s", "");
+    CASE_EXPECT_EQ(1, g_test_log_rate_limit_lines.size());
+    std::string prefix = g_test_log_rate_limit_lines.empty() ? std::string() : g_test_log_rate_limit_lines[0];
+    g_test_log_rate_limit_lines.clear();
+
+    // 超过初始缓冲区大小的日志会扩大缓冲区后完整输出
+    util::log::log_wrapper::release_tls_buffer();
+    std::string big(LOG_WRAPPER_TLS_BUFFER_INIT_SIZE * 5 + 17, 'x');
+    WCLOGINFO(test_cat, "%s|%d", big.c_str(), 1);
+    WCLOGBININFO(test_cat, "%s|%d", big.c_str(), 2);
+    WCLOGKVINFO(test_cat, WLOGFIELD("big", big));
+    // 字符串是最后一个参数时也要扩大缓冲区，不能只截断字符串
+    util::log::log_wrapper::release_tls_buffer();
+    WCLOGBININFO(test_cat, "%d|%s", 3, big.c_str());
+
+    CASE_EXPECT_EQ(4, g_test_log_rate_limit_lines.size());
+    if (4 == g_test_log_rate_limit_lines.size()) {
+        CASE_EXPECT_EQ(prefix + big + "|1", g_test_log_rate_limit_lines[0]);
+        CASE_EXPECT_EQ(prefix + big + "|2", g_test_log_rate_limit_lines[1]);
+        CASE_EXPECT_NE(std::string::npos, g_test_log_rate_limit_lines[2].find(std::string("\"big\":\"") + big + "\"}"));
+        CASE_EXPECT_EQ(prefix + "3|" + big, g_test_log_rate_limit_lines[3]);
+    }
+
+    // 超过最大长度时截断
+    std::string huge(LOG_WRAPPER_MAX_SIZE_PER_LINE + 16, 'y');
+    WCLOGINFO(test_cat, "%s", huge.c_str());
+    CASE_EXPECT_EQ(5, g_test_log_rate_limit_lines.size());
+    if (5 == g_test_log_rate_limit_lines.size()) {
+        CASE_EXPECT_EQ(LOG_WRAPPER_MAX_SIZE_PER_LINE - 1, g_test_log_rate_limit_lines[4].size());
+    }
+
+    util::log::log_wrapper::release_tls_buffer();
+    WCLOGINFO(test_cat, "after release");
+    CASE_EXPECT_EQ(6, g_test_log_rate_limit_lines.size());
+
+    logger->clear_sinks();
+    util::log::log_wrapper::release_tls_buffer();
+}
+
+CASE_TEST(log_wrapper_test, log_segments) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 9;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    logger->set_prefix_format("[%s:%n]");
+    CASE_EXPECT_TRUE(logger->get_compiled_prefix_format().has_source_var());
+    g_test_log_rate_limit_lines.clear();
+    logger->add_sink(test_log_rate_limit_sink);
+
+    util::log::log_wrapper::caller_info_t caller(util::log::log_wrapper::level_t::LOG_LW_INFO, "Lua", "test.lua", 12, NULL);
+    const char *segments[] = {"hello", NULL, " ", "world"};
+    size_t segment_sizes[] = {5, 0, 1, 5};
+    logger->log_segments(caller, segments, segment_sizes, 4);
+    logger->log_segments(caller, segments, segment_sizes, 0);
+
+    // 超过最大长度时截断
+    std::string huge(LOG_WRAPPER_MAX_SIZE_PER_LINE + 16, 'y');
+    segments[1] = huge.c_str();
+    segment_sizes[1] = huge.size();
+    logger->log_segments(caller, segments, segment_sizes, 4);
+
+    CASE_EXPECT_EQ(3, g_test_log_rate_limit_lines.size());
+    if (3 == g_test_log_rate_limit_lines.size()) {
+        CASE_EXPECT_EQ("[test.lua:12]hello world", g_test_log_rate_limit_lines[0]);
+        CASE_EXPECT_EQ("[test.lua:12]", g_test_log_rate_limit_lines[1]);
+        CASE_EXPECT_EQ(LOG_WRAPPER_MAX_SIZE_PER_LINE - 1, g_test_log_rate_limit_lines[2].size());
+        CASE_EXPECT_EQ(0, g_test_log_rate_limit_lines[2].compare(0, 18, "[test.lua:12]hello"));
+    }
+
+    logger->set_prefix_format("[%L]");
+    CASE_EXPECT_FALSE(logger->get_compiled_prefix_format().has_source_var());
+
+    logger->clear_sinks();
+    util::log::log_wrapper::release_tls_buffer();
+}
+
+CASE_TEST(log_wrapper_test, injected_time) {
+    const uint32_t test_cat = util::log::log_wrapper::categorize_t::MAX - 12;
+    util::log::log_wrapper *logger = WLOG_GETCAT(test_cat);
+    CASE_EXPECT_NE(NULL, logger);
+    if (NULL == logger) {
+        return;
+    }
+
+    logger->init(util::log::log_wrapper::level_t::LOG_LW_DEBUG);
+    logger->set_prefix_format("[%F %T.%u]");
+    CASE_EXPECT_FALSE(logger->get_option(util::log::log_wrapper::options_t::OPT_AUTO_UPDATE_TIME));
+    CASE_EXPECT_TRUE(logger->get_option(util::log::log_wrapper::options_t::OPT_CAPTURE_TIME));
+    g_test_log_rate_limit_lines.clear();
+    logger->add_sink(test_log_rate_limit_sink);
+
+    // 默认使用time_utility::update指定的时间
+    time_t sec = 1500000000;
+    util::time::time_utility::raw_time_t tp = std::chrono::system_clock::from_time_t(sec) + std::chrono::microseconds(654321);
+    util::time::time_utility::update(&tp);
+    WCLOGINFO(test_cat, "injected");
+
+    char expect[64];
+    struct tm tm_obj;
+    UTIL_STRFUNC_LOCALTIME_S(&sec, &tm_obj);
+    size_t expect_len = strftime(expect, sizeof(expect), "[%Y-%m-%d %H:%M:%S.654321]injected", &tm_obj);
+    CASE_EXPECT_EQ(1, g_test_log_rate_limit_lines.size());
+    if (1 == g_test_log_rate_limit_lines.size()) {
+        CASE_EXPECT_EQ(std::string(expect, expect_len), g_test_log_rate_limit_lines[0]);
+    }
+
+    // 没有指定时间时，默认在写日志时读取系统时间，而不是最后一次update的时间
+    util::time::time_utility::update();
+    time_t cached_sec, cached_usec, sys_sec, sys_nsec;
+    util::time::time_utility::get_now(cached_sec, cached_usec);
+    int64_t cached_ns = static_cast<int64_t>(cached_sec) * 1000000000 + cached_usec * 1000;
+    do {
+        util::time::time_utility::get_sys_now(sys_sec, sys_nsec);
+    } while (static_cast<int64_t>(sys_sec) * 1000000000 + sys_nsec < cached_ns + 50000000);
+
+    logger->add_sink(test_log_captured_time_sink);
+    g_test_log_captured_time_ns = 0;
+    WCLOGINFO(test_cat, "captured");
+    CASE_EXPECT_GT(g_test_log_captured_time_ns, cached_ns + 20000000);
+
+    // 关闭后使用time_utility缓存的时间
+    logger->set_option(util::log::log_wrapper::options_t::OPT_CAPTURE_TIME, false);
+    g_test_log_captured_time_ns = 0;
+    WCLOGINFO(test_cat, "cached");
+    CASE_EXPECT_EQ(cached_ns, g_test_log_captured_time_ns);
+    logger->set_option(util::log::log_wrapper::options_t::OPT_CAPTURE_TIME, true);
+    logger->clear_sinks();
+    logger->add_sink(test_log_rate_limit_sink);
+    g_test_log_rate_limit_lines.resize(1);
+    util::time::time_utility::update(&tp);
+
+    // 开启后读取系统时间
+    logger->set_option(util::log::log_wrapper::options_t::OPT_AUTO_UPDATE_TIME, true);
+    WCLOGINFO(test_cat, "system");
+    CASE_EXPECT_EQ(2, g_test_log_rate_limit_lines.size());
+    if (2 == g_test_log_rate_limit_lines.size()) {
+        CASE_EXPECT_NE(std::string(expect, expect_len - 8) + "system", g_test_log_rate_limit_lines[1]);
+    }
+
+    logger->set_option(util::log::log_wrapper::options_t::OPT_AUTO_UPDATE_TIME, false);
+    util::time::time_utility::update();
+    logger->clear_sinks();
+}
@@ -0,0 +1,151 @@
+﻿#include <cstring>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+#include "config/compiler_features.h"
+
+#ifdef max
+#undef max
+#endif
+
+#include "mem_pool/lru_concurrent_pool.h"
+
+
+struct test_lru_concurrent_data {
+    int key;
+};
+static util::lock::atomic_int_type<int> g_stat_lru_concurrent[4];
+
+struct test_lru_concurrent_action : public util::mempool::lru_default_action<test_lru_concurrent_data> {
+    typedef util::mempool::lru_default_action<test_lru_concurrent_data> base_type;
+    void push(test_lru_concurrent_data *obj) { ++g_stat_lru_concurrent[0]; }
+
+    void pull(test_lru_concurrent_data *obj) { ++g_stat_lru_concurrent[1]; }
+
+    void reset(test_lru_concurrent_data *obj) { ++g_stat_lru_concurrent[2]; }
+
+    void gc(test_lru_concurrent_data *obj) {
+        ++g_stat_lru_concurrent[3];
+        base_type::gc(obj);
+    }
+};
+
+typedef util::mempool::lru_concurrent_pool<int, test_lru_concurrent_data, test_lru_concurrent_action> test_lru_concurrent_pool_t;
+
+static void test_lru_concurrent_reset_stat() {
+    for (int i = 0; i < 4; ++i) {
+        g_stat_lru_concurrent[i].store(0);
+    }
+}
+
+CASE_TEST(lru_concurrent_pool_test, basic) {
+    test_lru_concurrent_reset_stat();
+    {
+        util::mempool::lru_concurrent_pool_manager::ptr_t mgr = util::mempool::lru_concurrent_pool_manager::create();
+        test_lru_concurrent_pool_t lru(3, 2);
+        CASE_EXPECT_EQ(4, lru.get_shard_count());
+        CASE_EXPECT_EQ(2, lru.get_magazine_count());
+        lru.init(mgr);
+
+        test_lru_concurrent_data *check_ptr[LRU_CONCURRENT_POOL_MAGAZINE_SIZE * 2];
+        for (int i = 0; i < LRU_CONCURRENT_POOL_MAGAZINE_SIZE * 2; ++i) {
+            check_ptr[i] = new test_lru_concurrent_data();
+            check_ptr[i]->key = i % 3;
+            CASE_EXPECT_TRUE(lru.push(check_ptr[i]->key, check_ptr[i]));
+        }
+        CASE_EXPECT_EQ(LRU_CONCURRENT_POOL_MAGAZINE_SIZE * 2, lru.size());
+
+        // FILO，线程缓存放回分片后顺序不变
+        for (int i = LRU_CONCURRENT_POOL_MAGAZINE_SIZE * 2 - 1; i >= 0; --i) {
+            if (0 == check_ptr[i]->key) {
+                CASE_EXPECT_EQ(check_ptr[i], lru.pull(0));
+                delete check_ptr[i];
+            }
+        }
+        CASE_EXPECT_EQ(NULL, lru.pull(0));
+        CASE_EXPECT_EQ(NULL, lru.pull(3));
+
+        size_t left = lru.size();
+        CASE_EXPECT_EQ(LRU_CONCURRENT_POOL_MAGAZINE_SIZE * 2, g_stat_lru_concurrent[0].load());
+        CASE_EXPECT_EQ(LRU_CONCURRENT_POOL_MAGAZINE_SIZE * 2 - static_cast<int>(left), g_stat_lru_concurrent[1].load());
+        CASE_EXPECT_EQ(LRU_CONCURRENT_POOL_MAGAZINE_SIZE * 2 - static_cast<int>(left), g_stat_lru_concurrent[2].load());
+
+        // 管理器的gc会先把线程缓存放回分片
+        lru.set_item_min_bound(0);
+        lru.set_proc_item_count(left);
+        CASE_EXPECT_EQ(left, mgr->gc());
+        CASE_EXPECT_EQ(static_cast<int>(left), g_stat_lru_concurrent[3].load());
+        CASE_EXPECT_TRUE(lru.empty());
+
+        CASE_EXPECT_TRUE(lru.push(1, new test_lru_concurrent_data()));
+    }
+
+    CASE_EXPECT_EQ(LRU_CONCURRENT_POOL_MAGAZINE_SIZE * 2 + 1, g_stat_lru_concurrent[0].load());
+    CASE_EXPECT_EQ(g_stat_lru_concurrent[0].load() - g_stat_lru_concurrent[1].load(), g_stat_lru_concurrent[3].load());
+}
+
+#if defined(UTIL_CONFIG_COMPILER_CXX_THREAD_LOCAL) && defined(UTIL_CONFIG_COMPILER_CXX_LAMBDAS) && UTIL_CONFIG_COMPILER_CXX_LAMBDAS
+
+#include <thread>
+
+CASE_TEST(lru_concurrent_pool_test, multi_thread) {
+    test_lru_concurrent_reset_stat();
+    {
+        util::mempool::lru_concurrent_pool_manager::ptr_t mgr = util::mempool::lru_concurrent_pool_manager::create();
+        test_lru_concurrent_pool_t lru(8, 4);
+        lru.init(mgr);
+        lru.set_item_max_bound(256);
+
+        util::lock::atomic_int_type<int> wrong_key;
+        util::lock::atomic_int_type<bool> running;
+        wrong_key.store(0);
+        running.store(true);
+
+        std::vector<std::thread> thds;
+        for (int t = 0; t < 4; ++t) {
+            thds.push_back(std::thread([&lru, &wrong_key, t]() {
+                for (int i = 0; i < 20000; ++i) {
+                    int key = (t + i) % 16;
+                    test_lru_concurrent_data *obj = lru.pull(key);
+                    if (NULL == obj) {
+                        obj = new test_lru_concurrent_data();
+                        obj->key = key;
+                    } else if (obj->key != key) {
+                        ++wrong_key;
+                    }
+
+                    // 一部分对象直接释放，另一部分放回
+                    if (0 == i % 3) {
+                        delete obj;
+                    } else {
+                        lru.push(key, obj);
+                    }
+                }
+            }));
+        }
+
+        // 其他线程同时驱动回收
+        std::thread proc_thd([&mgr, &running]() {
+            time_t tick = 0;
+            while (running.load()) {
+                mgr->proc(++tick);
+                mgr->gc();
+            }
+        });
+
+        for (size_t i = 0; i < thds.size(); ++i) {
+            thds[i].join();
+        }
+        running.store(false);
+        proc_thd.join();
+
+        CASE_EXPECT_EQ(0, wrong_key.load());
+        CASE_EXPECT_EQ(g_stat_lru_concurrent[0].load() - g_stat_lru_concurrent[1].load(),
+                       g_stat_lru_concurrent[3].load() + static_cast<int>(lru.size()));
+    }
+
+    CASE_EXPECT_EQ(g_stat_lru_concurrent[0].load() - g_stat_lru_concurrent[1].load(), g_stat_lru_concurrent[3].load());
+}
+
+#endif
@@ -0,0 +1,130 @@
+﻿#include <cstring>
+
+#include "frame/test_macros.h"
+
+#ifdef max
+#undef max
+#endif
+
+#include "mem_pool/lru_intrusive_pool.h"
+
+
+struct test_lru_intrusive_data {};
+static int g_stat_lru_intrusive[4] = {0, 0, 0, 0};
+
+struct test_lru_intrusive_action : public util::mempool::lru_default_action<test_lru_intrusive_data> {
+    typedef util::mempool::lru_default_action<test_lru_intrusive_data> base_type;
+    void push(test_lru_intrusive_data *obj) { ++g_stat_lru_intrusive[0]; }
+
+    void pull(test_lru_intrusive_data *obj) { ++g_stat_lru_intrusive[1]; }
+
+    void reset(test_lru_intrusive_data *obj) { ++g_stat_lru_intrusive[2]; }
+
+    void gc(test_lru_intrusive_data *obj) {
+        ++g_stat_lru_intrusive[3];
+        base_type::gc(obj);
+    }
+};
+
+typedef util::mempool::lru_intrusive_pool<uint32_t, test_lru_intrusive_data, test_lru_intrusive_action> test_lru_intrusive_pool_t;
+
+CASE_TEST(lru_intrusive_pool_test, basic) {
+    {
+        util::mempool::lru_intrusive_pool_manager::ptr_t mgr = util::mempool::lru_intrusive_pool_manager::create();
+        test_lru_intrusive_pool_t lru;
+        test_lru_intrusive_data *check_ptr;
+        lru.set_chunk_size(4);
+        lru.init(mgr);
+
+        memset(&g_stat_lru_intrusive, 0, sizeof(g_stat_lru_intrusive));
+
+        CASE_EXPECT_TRUE(lru.push(123, new test_lru_intrusive_data()));
+        CASE_EXPECT_TRUE(lru.push(456, check_ptr = new test_lru_intrusive_data()));
+        CASE_EXPECT_TRUE(lru.push(123, new test_lru_intrusive_data()));
+
+        CASE_EXPECT_EQ(3, g_stat_lru_intrusive[0]);
+        CASE_EXPECT_EQ(3, mgr->item_count());
+        CASE_EXPECT_EQ(3, lru.size());
+        CASE_EXPECT_EQ(1, lru.free_size());
+
+        CASE_EXPECT_EQ(NULL, lru.pull(789));
+        CASE_EXPECT_EQ(check_ptr, lru.pull(456));
+        CASE_EXPECT_EQ(NULL, lru.pull(456));
+        delete check_ptr;
+        check_ptr = NULL;
+
+        CASE_EXPECT_EQ(1, g_stat_lru_intrusive[1]);
+        CASE_EXPECT_EQ(1, g_stat_lru_intrusive[2]);
+        CASE_EXPECT_EQ(2, mgr->item_count());
+        CASE_EXPECT_EQ(2, lru.free_size());
+
+        // 节点复用，不再分配新的块
+        for (int i = 0; i < 100; ++i) {
+            CASE_EXPECT_TRUE(lru.push(456, check_ptr = new test_lru_intrusive_data()));
+            CASE_EXPECT_EQ(check_ptr, lru.pull(456));
+            delete check_ptr;
+        }
+        CASE_EXPECT_EQ(2, lru.free_size());
+
+        mgr->set_item_min_bound(1);
+        CASE_EXPECT_EQ(1, mgr->gc());
+        CASE_EXPECT_EQ(1, g_stat_lru_intrusive[3]);
+        CASE_EXPECT_EQ(1, lru.size());
+    }
+
+    CASE_EXPECT_EQ(2, g_stat_lru_intrusive[3]);
+}
+
+CASE_TEST(lru_intrusive_pool_test, lru_order) {
+    util::mempool::lru_intrusive_pool_manager::ptr_t mgr = util::mempool::lru_intrusive_pool_manager::create();
+    test_lru_intrusive_pool_t lru1;
+    test_lru_intrusive_pool_t lru2;
+    lru1.init(mgr);
+    lru2.init(mgr);
+    mgr->set_item_max_bound(4);
+    mgr->set_proc_item_count(16);
+
+    memset(&g_stat_lru_intrusive, 0, sizeof(g_stat_lru_intrusive));
+
+    test_lru_intrusive_data *checked_ptr[6];
+    for (int i = 0; i < 6; ++i) {
+        checked_ptr[i] = new test_lru_intrusive_data();
+    }
+
+    // 两个池共用一个LRU队列，超出上限时淘汰最早push的
+    CASE_EXPECT_TRUE(lru1.push(1, checked_ptr[0]));
+    CASE_EXPECT_TRUE(lru2.push(1, checked_ptr[1]));
+    CASE_EXPECT_TRUE(lru1.push(2, checked_ptr[2]));
+    CASE_EXPECT_TRUE(lru2.push(1, checked_ptr[3]));
+    CASE_EXPECT_EQ(0, g_stat_lru_intrusive[3]);
+
+    CASE_EXPECT_TRUE(lru1.push(2, checked_ptr[4]));
+    CASE_EXPECT_EQ(1, g_stat_lru_intrusive[3]);
+    CASE_EXPECT_EQ(NULL, lru1.pull(1));
+
+    CASE_EXPECT_TRUE(lru2.push(2, checked_ptr[5]));
+    CASE_EXPECT_EQ(2, g_stat_lru_intrusive[3]);
+    CASE_EXPECT_EQ(checked_ptr[3], lru2.pull(1));
+    CASE_EXPECT_EQ(NULL, lru2.pull(1));
+    CASE_EXPECT_EQ(3, mgr->item_count());
+    delete checked_ptr[3];
+
+    // 超时回收
+    mgr->set_list_tick_timeout(10);
+    CASE_EXPECT_EQ(0, mgr->proc(5));
+    CASE_EXPECT_EQ(3, mgr->proc(20));
+    CASE_EXPECT_EQ(5, g_stat_lru_intrusive[3]);
+    CASE_EXPECT_EQ(0, mgr->item_count());
+    CASE_EXPECT_TRUE(lru1.empty());
+    CASE_EXPECT_TRUE(lru2.empty());
+
+    // 更换管理器
+    CASE_EXPECT_TRUE(lru1.push(1, new test_lru_intrusive_data()));
+    util::mempool::lru_intrusive_pool_manager::ptr_t mgr2 = util::mempool::lru_intrusive_pool_manager::create();
+    lru1.set_manager(mgr2);
+    CASE_EXPECT_EQ(0, mgr->item_count());
+    CASE_EXPECT_EQ(1, mgr2->item_count());
+    lru1.clear();
+    CASE_EXPECT_EQ(0, mgr2->item_count());
+    CASE_EXPECT_EQ(6, g_stat_lru_intrusive[3]);
+}
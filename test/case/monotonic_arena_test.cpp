@@ -0,0 +1,98 @@
+﻿#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+#ifdef max
+#undef max
+#endif
+
+#include "mem_pool/monotonic_arena.h"
+
+CASE_TEST(monotonic_arena_test, allocate_and_reset) {
+    util::mempool::monotonic_arena arena(1024);
+    CASE_EXPECT_EQ(0, arena.capacity());
+    CASE_EXPECT_EQ(0, arena.used());
+
+    void *p1 = arena.allocate(10);
+    void *p2 = arena.allocate(10);
+    CASE_EXPECT_NE(NULL, p1);
+    CASE_EXPECT_NE(NULL, p2);
+    CASE_EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p2) % MONOTONIC_ARENA_DEFAULT_ALIGN);
+    CASE_EXPECT_TRUE(reinterpret_cast<char *>(p2) >= reinterpret_cast<char *>(p1) + 10);
+    CASE_EXPECT_EQ(1024, arena.capacity());
+
+    // 超过内存块大小的单独申请
+    void *large = arena.allocate(4096);
+    CASE_EXPECT_NE(NULL, large);
+    CASE_EXPECT_TRUE(arena.capacity() >= 1024 + 4096);
+
+    const char *str = arena.strdup("hello", 5);
+    CASE_EXPECT_EQ(0, strcmp("hello", str));
+
+    // reset后内存块保留并从头复用
+    size_t capacity = arena.capacity();
+    arena.reset();
+    CASE_EXPECT_EQ(0, arena.used());
+    CASE_EXPECT_EQ(p1, arena.allocate(10));
+    CASE_EXPECT_EQ(capacity, arena.capacity());
+
+    arena.release();
+    CASE_EXPECT_EQ(0, arena.capacity());
+}
+
+CASE_TEST(monotonic_arena_test, scope) {
+    void *buffer[64];
+    util::mempool::monotonic_arena arena(buffer, sizeof(buffer), 256);
+    void *outer = arena.allocate(100);
+    char *buffer_begin = reinterpret_cast<char *>(buffer);
+    CASE_EXPECT_TRUE(reinterpret_cast<char *>(outer) > buffer_begin && reinterpret_cast<char *>(outer) < buffer_begin + sizeof(buffer));
+
+    void *inner_first = NULL;
+    {
+        util::mempool::monotonic_arena_scope scope(arena);
+        inner_first = arena.allocate(100);
+        for (int i = 0; i < 10; ++i) {
+            CASE_EXPECT_NE(NULL, arena.allocate(100));
+        }
+        CASE_EXPECT_TRUE(arena.capacity() > sizeof(buffer));
+    }
+
+    // 作用域结束后回到作用域开始时的位置
+    CASE_EXPECT_EQ(inner_first, arena.allocate(100));
+
+    // 释放后仍然保留外部缓冲区
+    arena.release();
+    CASE_EXPECT_EQ(sizeof(buffer) - sizeof(util::mempool::monotonic_arena::block_t), arena.capacity());
+    CASE_EXPECT_EQ(outer, arena.allocate(100));
+}
+
+CASE_TEST(monotonic_arena_test, stl_allocator) {
+    util::mempool::monotonic_arena arena;
+    for (int loop = 0; loop < 3; ++loop) {
+        {
+            typedef util::mempool::monotonic_arena_allocator<std::pair<const std::string, int> > map_alloc_t;
+            map_alloc_t map_alloc(arena);
+            std::map<std::string, int, std::less<std::string>, map_alloc_t> mp(std::less<std::string>(), map_alloc);
+            std::vector<int, util::mempool::monotonic_arena_allocator<int> > vec((util::mempool::monotonic_arena_allocator<int>(arena)));
+
+            for (int i = 0; i < 100; ++i) {
+                mp["key"] += i;
+                vec.push_back(i);
+            }
+
+            CASE_EXPECT_EQ(4950, mp["key"]);
+            CASE_EXPECT_EQ(99, vec[99]);
+            CASE_EXPECT_TRUE(arena.used() > 100 * sizeof(int));
+        }
+
+        // 每次请求结束时回收，内存块不会增长
+        size_t capacity = arena.capacity();
+        arena.reset();
+        if (loop > 0) {
+            CASE_EXPECT_EQ(capacity, arena.capacity());
+        }
+    }
+}
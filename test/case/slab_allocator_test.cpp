@@ -0,0 +1,123 @@
+﻿#include <cstring>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+#ifdef max
+#undef max
+#endif
+
+#include "mem_pool/lru_object_pool.h"
+#include "mem_pool/slab_allocator.h"
+
+CASE_TEST(slab_allocator_test, size_class) {
+    CASE_EXPECT_EQ(0, util::mempool::slab_allocator::get_size_class(0));
+    CASE_EXPECT_EQ(0, util::mempool::slab_allocator::get_size_class(16));
+    CASE_EXPECT_EQ(1, util::mempool::slab_allocator::get_size_class(17));
+    CASE_EXPECT_EQ(util::mempool::slab_allocator::SIZE_CLASS_COUNT,
+                   util::mempool::slab_allocator::get_size_class(SLAB_ALLOCATOR_MAX_SIZE + 1));
+
+    // 每个大小都落在刚好能放下它的最小级别
+    for (size_t sz = 1; sz <= SLAB_ALLOCATOR_MAX_SIZE; ++sz) {
+        size_t cls = util::mempool::slab_allocator::get_size_class(sz);
+        CASE_EXPECT_TRUE(cls < util::mempool::slab_allocator::SIZE_CLASS_COUNT);
+        CASE_EXPECT_TRUE(util::mempool::slab_allocator::get_class_size(cls) >= sz);
+        if (cls > 0) {
+            CASE_EXPECT_TRUE(util::mempool::slab_allocator::get_class_size(cls - 1) < sz);
+        }
+    }
+
+    CASE_EXPECT_EQ(SLAB_ALLOCATOR_MAX_SIZE,
+                   util::mempool::slab_allocator::get_class_size(util::mempool::slab_allocator::SIZE_CLASS_COUNT - 1));
+}
+
+CASE_TEST(slab_allocator_test, alloc_and_free) {
+    const size_t obj_size = 100;
+    size_t cls = util::mempool::slab_allocator::get_size_class(obj_size);
+
+    std::vector<void *> ptrs;
+    for (int i = 0; i < 1000; ++i) {
+        void *p = util::mempool::slab_allocator::allocate(obj_size);
+        CASE_EXPECT_NE(NULL, p);
+        CASE_EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % 16);
+        memset(p, i & 0xFF, obj_size);
+        ptrs.push_back(p);
+    }
+
+    // 刚释放的马上被复用
+    void *last = ptrs.back();
+    util::mempool::slab_allocator::deallocate(last, obj_size);
+    CASE_EXPECT_EQ(last, util::mempool::slab_allocator::allocate(obj_size));
+
+    for (size_t i = 0; i < ptrs.size(); ++i) {
+        util::mempool::slab_allocator::deallocate(ptrs[i], obj_size);
+    }
+
+    // 线程缓存只保留一部分，全部归还后全局空闲链表不少于释放的数量
+    size_t central_count = util::mempool::slab_allocator::get_central_free_count(cls);
+    CASE_EXPECT_TRUE(central_count > 0);
+    util::mempool::slab_allocator::flush_thread_cache();
+    CASE_EXPECT_TRUE(util::mempool::slab_allocator::get_central_free_count(cls) >= ptrs.size());
+    CASE_EXPECT_TRUE(util::mempool::slab_allocator::get_chunk_count() > 0);
+
+    // 超过最大值时直接使用malloc
+    void *large = util::mempool::slab_allocator::allocate(SLAB_ALLOCATOR_MAX_SIZE + 1);
+    CASE_EXPECT_NE(NULL, large);
+    util::mempool::slab_allocator::deallocate(large, SLAB_ALLOCATOR_MAX_SIZE + 1);
+}
+
+CASE_TEST(slab_allocator_test, stl_allocator) {
+    std::list<int, util::mempool::slab_stl_allocator<int> > ls;
+    std::map<int, int, std::less<int>, util::mempool::slab_stl_allocator<std::pair<const int, int> > > mp;
+    std::vector<int, util::mempool::slab_stl_allocator<int> > vec;
+    for (int i = 0; i < 1000; ++i) {
+        ls.push_back(i);
+        mp[i] = i * 2;
+        vec.push_back(i);
+    }
+
+    int sum = 0;
+    for (std::list<int, util::mempool::slab_stl_allocator<int> >::iterator iter = ls.begin(); iter != ls.end(); ++iter) {
+        sum += *iter;
+    }
+    CASE_EXPECT_EQ(499500, sum);
+    CASE_EXPECT_EQ(1000, mp.size());
+    CASE_EXPECT_EQ(1998, mp[999]);
+    CASE_EXPECT_EQ(999, vec[999]);
+}
+
+namespace {
+    struct test_slab_lru_data {
+        char payload[200];
+        static int alive;
+
+        test_slab_lru_data() { ++alive; }
+        ~test_slab_lru_data() { --alive; }
+    };
+
+    int test_slab_lru_data::alive = 0;
+}
+
+CASE_TEST(slab_allocator_test, lru_pool_action) {
+    {
+        typedef util::mempool::lru_pool<uint32_t, test_slab_lru_data, util::mempool::lru_slab_action<test_slab_lru_data> >
+            test_lru_pool_t;
+        util::mempool::lru_pool_manager::ptr_t mgr = util::mempool::lru_pool_manager::create();
+        test_lru_pool_t lru;
+        lru.init(mgr);
+
+        test_slab_lru_data *obj = util::mempool::slab_allocator::create<test_slab_lru_data>();
+        CASE_EXPECT_NE(NULL, obj);
+        CASE_EXPECT_EQ(1, test_slab_lru_data::alive);
+
+        CASE_EXPECT_TRUE(lru.push(1, obj));
+        CASE_EXPECT_TRUE(lru.push(1, util::mempool::slab_allocator::create<test_slab_lru_data>()));
+        CASE_EXPECT_EQ(2, test_slab_lru_data::alive);
+        CASE_EXPECT_EQ(1, mgr->gc());
+        CASE_EXPECT_EQ(1, test_slab_lru_data::alive);
+    }
+
+    CASE_EXPECT_EQ(0, test_slab_lru_data::alive);
+}
@@ -127,3 +127,19 @@ CASE_TEST(time_test, get_week_day) {
 CASE_TEST(time_test, is_same_month) {
     // nothing todo use libc now
 }
+
+CASE_TEST(time_test, update_custom) {
+    util::time::time_utility::raw_time_t tp = std::chrono::system_clock::from_time_t(1500000000) + std::chrono::microseconds(123456);
+    util::time::time_utility::update(&tp);
+
+    time_t sec = 0, usec = 0;
+    util::time::time_utility::get_now(sec, usec);
+    CASE_EXPECT_EQ(1500000000, sec);
+    CASE_EXPECT_EQ(123456, usec);
+    CASE_EXPECT_EQ(1500000000, util::time::time_utility::get_now());
+    CASE_EXPECT_EQ(123456, util::time::time_utility::get_now_usec());
+    CASE_EXPECT_TRUE(tp == util::time::time_utility::now());
+
+    util::time::time_utility::update();
+    CASE_EXPECT_TRUE(util::time::time_utility::get_now() > 1500000000);
+}